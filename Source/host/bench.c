@@ -0,0 +1,862 @@
+// Host microbenchmarks for the app core.
+//
+// The app translation unit is included directly so its static functions can be
+// driven without a device. Every benchmark reports wall time per operation plus
+// the heap, SD card and canvas traffic the operation caused.
+//
+//   ./build/mtg_bench [--quick] [filter]
+
+#include "furi_host.h"
+
+#include "../mtg_deck_randomizer.c"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+#define DECK_FILE_PATH "/ext/apps/MTG/mtg_decks.txt"
+#define BENCH_TRACE_PATH "/ext/apps/MTG/bench_trace.bin"
+#define BENCH_IMPORT_PATH "/ext/apps/MTG/import/bench.csv"
+#define BENCH_IMPORT_ROWS 1000
+
+typedef void (*BenchCallback)(void* context);
+
+typedef struct {
+    const char* filter;
+    uint64_t min_ns;
+} BenchConfig;
+
+static BenchConfig bench_config = {
+    .filter = NULL,
+    .min_ns = 250000000ULL,
+};
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_run(const char* name, BenchCallback callback, void* context, Canvas* canvas) {
+    if (bench_config.filter && !strstr(name, bench_config.filter)) return;
+
+    // Warm up once, then double the batch until it runs long enough to time
+    callback(context);
+    uint64_t iterations = 1;
+    uint64_t elapsed = 0;
+    FuriHostAllocStats alloc_before, alloc_after;
+    FuriHostStorageStats io_before, io_after;
+    FuriHostCanvasStats draw_before = {0}, draw_after = {0};
+
+    for (;;) {
+        alloc_before = furi_host_alloc_stats();
+        io_before = furi_host_storage_stats();
+        if (canvas) draw_before = furi_host_canvas_stats(canvas);
+
+        uint64_t start = bench_now_ns();
+        for (uint64_t i = 0; i < iterations; i++) {
+            callback(context);
+        }
+        elapsed = bench_now_ns() - start;
+
+        alloc_after = furi_host_alloc_stats();
+        io_after = furi_host_storage_stats();
+        if (canvas) draw_after = furi_host_canvas_stats(canvas);
+
+        if (elapsed >= bench_config.min_ns || iterations >= (1ULL << 30)) break;
+        iterations *= 2;
+    }
+
+    double n = (double)iterations;
+    printf(
+        "%-32s %10llu %12.1f %9.2f %11.1f %9.2f %9.2f %9.2f %9.2f %11.2f\n",
+        name,
+        (unsigned long long)iterations,
+        (double)elapsed / n,
+        (double)(alloc_after.allocs - alloc_before.allocs) / n,
+        (double)(alloc_after.bytes - alloc_before.bytes) / n,
+        (double)(io_after.reads - io_before.reads) / n,
+        (double)(io_after.writes - io_before.writes) / n,
+        (double)(draw_after.draw_calls - draw_before.draw_calls) / n,
+        (double)(draw_after.font_switches - draw_before.font_switches) / n,
+        (double)(draw_after.string_measures - draw_before.string_measures) / n);
+}
+
+// Fixture
+
+static char bench_root[] = "/tmp/mtg_bench.XXXXXX";
+
+static void bench_write_deck_file(size_t lines) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/apps/MTG/mtg_decks.txt", bench_root);
+    FILE* stream = fopen(path, "wb");
+    furi_check(stream);
+    for (size_t i = 0; i < lines; i++) {
+        // Every other deck carries metadata, spread over colors, brackets and tags
+        static const char* colors[] = {"W", "UB", "BRG", "WUBRG", "C", "GW", "UR"};
+        static const char* tags[] = {"aggro", "combo", "control", "tokens,aggro", ""};
+        if (i % 2) {
+            fprintf(
+                stream,
+                "Commander deck %06zu|%s|%zu|%s\n",
+                i,
+                colors[i % COUNT_OF(colors)],
+                1 + i / 4 % 4,
+                tags[i % COUNT_OF(tags)]);
+        } else {
+            fprintf(stream, "Commander deck %06zu\n", i);
+        }
+    }
+    fclose(stream);
+}
+
+static int bench_remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    UNUSED(st);
+    UNUSED(flag);
+    UNUSED(ftw);
+    return remove(path);
+}
+
+static void bench_fixture_alloc(void) {
+    furi_check(mkdtemp(bench_root));
+    furi_host_storage_root_set(bench_root);
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/apps", bench_root);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/apps/MTG", bench_root);
+    mkdir(path, 0755);
+
+    // A second, small list to switch to
+    snprintf(path, sizeof(path), "%s/apps/MTG/sideboard.txt", bench_root);
+    FILE* stream = fopen(path, "wb");
+    furi_check(stream);
+    for (int i = 0; i < 10; i++) {
+        fprintf(stream, "Sideboard deck %d\n", i);
+    }
+    fclose(stream);
+}
+
+static void bench_fixture_free(void) {
+    nftw(bench_root, bench_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+// Benchmarks
+
+static void bench_load_decks(void* context) {
+    load_decks(context);
+}
+
+static void bench_load_decks_text(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    // Drop the index so every run parses the text file and rebuilds it
+    storage_common_remove(furi_record_open(RECORD_STORAGE), mtg->paths.index);
+    furi_record_close(RECORD_STORAGE);
+    load_decks(mtg);
+}
+
+static void bench_make_resident(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    load_decks(mtg);
+    furi_check(mtg_decks_make_resident(mtg));
+}
+
+static void bench_save_decks(void* context) {
+    save_decks(context);
+}
+
+typedef struct {
+    size_t block_size;
+    size_t lines;
+} BenchLineReader;
+
+static void bench_line_reader(void* context) {
+    BenchLineReader* bench = context;
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    furi_check(storage_file_open(file, DECK_FILE_PATH, FSAM_READ, FSOM_OPEN_EXISTING));
+    LineReader* reader = line_reader_alloc(file, bench->block_size);
+    const char* line;
+    size_t length;
+    size_t lines = 0;
+    while (line_reader_next(reader, &line, &length)) {
+        lines++;
+    }
+    furi_check(lines == bench->lines);
+    line_reader_free(reader);
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+static const size_t bench_block_sizes[] = {64, 512, 1024, 4096};
+
+typedef struct {
+    MTGDeckRandomizer* mtg;
+    Canvas* canvas;
+    AppState state;
+} BenchDraw;
+
+static void bench_draw(void* context) {
+    BenchDraw* draw = context;
+    draw->mtg->state = draw->state;
+    mtg_deck_randomizer_draw_callback(draw->canvas, draw->mtg);
+}
+
+typedef struct {
+    MTGDeckRandomizer* mtg;
+    ViewPort* view_port;
+    Canvas* canvas;
+    AppState state;
+} BenchLoop;
+
+// One simulated second of the main loop in a given state. The virtual clock
+// advances a millisecond at a time, frame events are handled as they come due
+// and the view is drawn only when left dirty, as the GUI service would
+static void bench_loop_second(void* context) {
+    BenchLoop* loop = context;
+    MTGDeckRandomizer* mtg = loop->mtg;
+    MTGEvent event;
+
+    mtg->state = loop->state;
+    mtg->spin_start_time = furi_get_tick();
+    mtg->blink_start_time = furi_get_tick();
+    mtg_deck_randomizer_schedule_frames(mtg);
+
+    for (int ms = 0; ms < 1000; ms++) {
+        furi_host_tick_advance(1);
+        while (furi_message_queue_get(mtg->event_queue, &event, 0) == FuriStatusOk) {
+            mtg_deck_randomizer_handle_event(mtg, &event);
+        }
+        if (mtg->dirty) {
+            mtg->dirty = false;
+            view_port_update(loop->view_port);
+            furi_host_view_port_draw(loop->view_port, loop->canvas);
+        }
+    }
+}
+
+static void bench_pick(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    InputEvent event = {.key = InputKeyOk, .type = InputTypeShort};
+    mtg->state = StateMainMenu;
+    mtg_deck_randomizer_update_state(mtg, event);
+}
+
+static void bench_filter_prepare(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    mtg->filter_stale = true;
+    mtg_filter_prepare(mtg);
+}
+
+static void bench_search_prepare(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    mtg->search_stale = true;
+    furi_check(mtg_search_prepare(mtg));
+}
+
+static void bench_press(MTGDeckRandomizer* mtg, InputKey key) {
+    InputEvent input = {.key = key, .type = InputTypeShort};
+    mtg_deck_randomizer_update_state(mtg, input);
+}
+
+// Put the keyboard cursor on the key for c, in whichever layout has it
+static void bench_keyboard_select(MTGDeckRandomizer* mtg, char c) {
+    for (KeyboardLayout layout = 0; layout < KeyboardLayoutCount; layout++) {
+        for (uint8_t row = 0; row < KEYBOARD_ROWS; row++) {
+            const KeyboardRow* keys = keyboard_row(layout, row);
+            for (uint8_t column = 0; column < keys->count; column++) {
+                if (keys->keys[column].text != c) continue;
+                mtg->keyboard_layout = layout;
+                mtg->selected_row = row;
+                mtg->selected_column = column;
+                return;
+            }
+        }
+    }
+    furi_crash("No key for the search query");
+}
+
+static const char bench_search_query[] = "commander_deck_0001";
+
+static void bench_search_type(void* context) {
+    // One keystroke on the search keyboard: the query grows by a character,
+    // or starts over when full
+    MTGDeckRandomizer* mtg = context;
+    furi_check(mtg->state == StateSearch);
+    size_t length = strlen(mtg->edit_buffer);
+    if (length == strlen(bench_search_query)) {
+        mtg->edit_buffer[0] = '\0';
+        length = 0;
+    }
+    bench_keyboard_select(mtg, bench_search_query[length]);
+    bench_press(mtg, InputKeyOk);
+}
+
+static char bench_fold(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+    return c == '_' ? ' ' : c;
+}
+
+// Right in the deck list opens the search, and typing the query key by key
+// finds exactly the decks whose names start with it
+static void bench_search_check(MTGDeckRandomizer* mtg) {
+    mtg->state = StateDeckList;
+    bench_press(mtg, InputKeyRight);
+    furi_check(mtg->state == StateSearch);
+    for (size_t i = 0; bench_search_query[i]; i++) {
+        bench_keyboard_select(mtg, bench_search_query[i]);
+        bench_press(mtg, InputKeyOk);
+    }
+    furi_check(strcmp(mtg->edit_buffer, bench_search_query) == 0);
+
+    size_t matches = 0;
+    size_t length = strlen(bench_search_query);
+    for (int deck = 0; deck < mtg->deck_count; deck++) {
+        const char* name = mtg_deck_name(mtg, deck);
+        size_t i = 0;
+        while (i < length && name[i] && bench_fold(name[i]) == bench_fold(bench_search_query[i])) i++;
+        if (i == length) matches++;
+    }
+    furi_check(mtg->search_count == matches);
+    for (size_t i = 0; i < mtg->search_count; i++) {
+        const char* name = mtg_deck_name(mtg, deck_search_get(mtg->search, mtg->search_first + i));
+        for (size_t j = 0; j < length; j++) {
+            furi_check(bench_fold(name[j]) == bench_fold(bench_search_query[j]));
+        }
+    }
+
+    // Enter lists the matches, and Back twice returns to the deck list
+    if (matches > 0) {
+        bench_keyboard_select(mtg, KEYBOARD_KEY_ENTER);
+        bench_press(mtg, InputKeyOk);
+        furi_check(mtg->state == StateSearchResults);
+        bench_press(mtg, InputKeyBack);
+    }
+    furi_check(mtg->state == StateSearch);
+    bench_press(mtg, InputKeyBack);
+    furi_check(mtg->state == StateDeckList);
+}
+
+static void bench_filter_apply(void* context) {
+    // Flip between two rules so each run evaluates the list
+    MTGDeckRandomizer* mtg = context;
+    mtg->filter_rule.bracket_max = mtg->filter_rule.bracket_max == 3 ? 2 : 3;
+    mtg_filter_update(mtg);
+}
+
+static void bench_pod_assign(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    mtg->state = StatePodSetup;
+    pod_spin_start(mtg);
+    furi_check(mtg->pod_result == PodResultOk);
+}
+
+static void bench_picker_set_weight(void* context) {
+    // Move one deck between two weight classes and back
+    MTGDeckRandomizer* mtg = context;
+    deck_picker_set_weight(mtg->picker, mtg->deck_count / 2, 7);
+    deck_picker_set_weight(mtg->picker, mtg->deck_count / 2, 2);
+}
+
+static void bench_play_log_append(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    mtg_log_play(mtg, furi_hal_random_get() % mtg->deck_count, PlayResultPicked);
+}
+
+static void bench_stats_open(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    InputEvent event = {.key = InputKeyUp, .type = InputTypeShort};
+    mtg->state = StateMainMenu;
+    mtg_deck_randomizer_update_state(mtg, event);
+}
+
+static void bench_play_log_open(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    play_log_close(mtg->plays);
+    mtg->plays = play_log_open(PLAY_HISTORY_PATH, PLAY_STATS_PATH, PLAY_HISTORY_SIZE);
+}
+
+static void bench_scroll(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    InputEvent event = {.key = InputKeyDown, .type = InputTypeShort};
+    if (mtg->selected_deck >= mtg->deck_count) {
+        mtg->selected_deck = 0;
+        mtg->scroll_position = 0;
+    }
+    mtg->state = StateDeckList;
+    mtg_deck_randomizer_update_state(mtg, event);
+}
+
+typedef struct {
+    MTGDeckRandomizer* mtg;
+    ViewPort* view_port;
+} BenchInput;
+
+static void bench_input_hold(void* context) {
+    // Down held through twenty repeats while the main loop was busy: it all
+    // arrives on one wake-up and the repeats are applied as one move
+    BenchInput* bench = context;
+    MTGDeckRandomizer* mtg = bench->mtg;
+    static const InputType types[] = {InputTypePress, InputTypeLong, InputTypeRepeat, InputTypeRelease};
+    mtg->state = StateDeckList;
+    for (size_t i = 0; i < COUNT_OF(types); i++) {
+        InputEvent input = {.key = InputKeyDown, .type = types[i]};
+        for (int n = 0; n < (types[i] == InputTypeRepeat ? 20 : 1); n++) {
+            furi_host_view_port_input(bench->view_port, &input);
+        }
+    }
+    furi_check(furi_message_queue_get_count(mtg->event_queue) == 1);
+
+    MTGEvent event;
+    while (furi_message_queue_get(mtg->event_queue, &event, 0) == FuriStatusOk) {
+        mtg_deck_randomizer_handle_event(mtg, &event);
+    }
+    mtg->dirty = false;
+    if (mtg->selected_deck >= mtg->deck_count) {
+        mtg->selected_deck = 0;
+        mtg->scroll_position = 0;
+    }
+}
+
+static void bench_perf_dump(void* context) {
+    UNUSED(context);
+    furi_check(perf_dump(PERF_CSV_PATH));
+}
+
+static void bench_store_delete_add(void* context) {
+    // Delete from the middle and append it back so the list size stays put
+    DeckStore* store = context;
+    size_t index = deck_store_count(store) / 2;
+    char name[MAX_NAME_LENGTH];
+    size_t length = deck_store_get_length(store, index);
+    DeckMeta meta = deck_store_get_meta(store, index);
+    memcpy(name, deck_store_get(store, index), length);
+    deck_store_remove(store, index);
+    deck_store_add(store, name, length);
+    deck_store_set_meta(store, deck_store_count(store) - 1, meta);
+}
+
+static void bench_write_import_file(void) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/apps/MTG/import", bench_root);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/apps/MTG/import/bench.csv", bench_root);
+    FILE* stream = fopen(path, "wb");
+    furi_check(stream);
+    fprintf(stream, "Deck Name,Commander,Color Identity,Bracket,Tags\r\n");
+    for (size_t i = 0; i < BENCH_IMPORT_ROWS; i++) {
+        // Every fourth row names a deck already in the list, in other case
+        if (i % 4 == 3) {
+            fprintf(stream, "commander DECK %06zu,,,,\r\n", i);
+        } else {
+            fprintf(
+                stream, "\"Imported, deck %06zu\",Commander %zu,\"White, Blue\",%zu,\"aggro,tokens\"\r\n", i, i, 1 + i % 4);
+        }
+    }
+    fclose(stream);
+}
+
+static void bench_import(void* context) {
+    // Into a copy of the list, which also seeds the duplicate set from it;
+    // the file is put back afterwards for the next run
+    DeckStore* store = deck_store_clone(context);
+    DeckImport* import = deck_import_open(BENCH_IMPORT_PATH, store);
+    while (deck_import_step(import, IMPORT_ROWS_PER_FRAME) == DeckImportStatusRunning) {
+    }
+    DeckImportStatus status = deck_import_status(import);
+    furi_check(status == DeckImportStatusDone || status == DeckImportStatusFull);
+    deck_import_close(import);
+    deck_store_free(store);
+    if (status == DeckImportStatusDone) {
+        storage_common_rename(furi_record_open(RECORD_STORAGE), BENCH_IMPORT_PATH ".done", BENCH_IMPORT_PATH);
+        furi_record_close(RECORD_STORAGE);
+    }
+}
+
+static void bench_edit_rename(void* context) {
+    // Rename in place and handle worker reports as the main loop would. Only
+    // the UI side is timed; the writes land on the storage worker
+    MTGDeckRandomizer* mtg = context;
+    MTGEvent event;
+    mtg_decks_commit(mtg, DeckJournalOpRename, mtg->deck_count / 2);
+    while (furi_message_queue_get(mtg->event_queue, &event, 0) == FuriStatusOk) {
+        mtg_deck_randomizer_storage_event(mtg);
+    }
+}
+
+static void bench_list_switch(void* context) {
+    // Over to the other list and back
+    MTGDeckRandomizer* mtg = context;
+    size_t active = deck_lists_active(mtg->lists);
+    mtg_list_switch(mtg, !active);
+    mtg_list_switch(mtg, active);
+}
+
+static void bench_lists_open(void* context) {
+    UNUSED(context);
+    deck_lists_close(deck_lists_open(APP_FOLDER, DECK_LISTS_PATH, DECK_LIST_DEFAULT));
+}
+
+static void bench_lists_refresh(void* context) {
+    MTGDeckRandomizer* mtg = context;
+    deck_lists_refresh(mtg->lists);
+}
+
+// A short session without edits: a spin, the deck list scrolled with Down
+// held, the stats screen, and a second spin
+static const struct {
+    uint16_t delay;
+    uint8_t times;
+    InputKey key;
+    InputType type;
+} bench_trace_events[] = {
+    {500, 1, InputKeyOk, InputTypePress},
+    {80, 1, InputKeyOk, InputTypeShort},
+    {0, 1, InputKeyOk, InputTypeRelease},
+    {7000, 1, InputKeyDown, InputTypePress},
+    {500, 1, InputKeyDown, InputTypeLong},
+    {150, 30, InputKeyDown, InputTypeRepeat},
+    {100, 1, InputKeyDown, InputTypeRelease},
+    {400, 1, InputKeyBack, InputTypePress},
+    {80, 1, InputKeyBack, InputTypeShort},
+    {0, 1, InputKeyBack, InputTypeRelease},
+    {600, 1, InputKeyUp, InputTypePress},
+    {80, 1, InputKeyUp, InputTypeShort},
+    {0, 1, InputKeyUp, InputTypeRelease},
+    {300, 1, InputKeyDown, InputTypePress},
+    {80, 1, InputKeyDown, InputTypeShort},
+    {0, 1, InputKeyDown, InputTypeRelease},
+    {400, 1, InputKeyBack, InputTypePress},
+    {80, 1, InputKeyBack, InputTypeShort},
+    {0, 1, InputKeyBack, InputTypeRelease},
+    {1000, 1, InputKeyOk, InputTypePress},
+    {80, 1, InputKeyOk, InputTypeShort},
+    {0, 1, InputKeyOk, InputTypeRelease},
+    {4000, 1, InputKeyBack, InputTypePress},
+};
+
+static void bench_trace_record(void) {
+    TraceRecorder* recorder = trace_recorder_open(BENCH_TRACE_PATH, 0x2545F491, 1700000000, 0);
+    furi_check(recorder);
+    for (size_t i = 0; i < COUNT_OF(bench_trace_events); i++) {
+        InputEvent input = {.key = bench_trace_events[i].key, .type = bench_trace_events[i].type};
+        for (int n = 0; n < bench_trace_events[i].times; n++) {
+            furi_host_tick_advance(bench_trace_events[i].delay);
+            trace_recorder_event(recorder, &input);
+            trace_recorder_write(recorder);
+        }
+    }
+    furi_check(trace_recorder_close(recorder));
+}
+
+static uint32_t bench_replay_hash;
+
+static void bench_replay(void* context) {
+    // A fresh session every time, from the same picker state, so every run
+    // has to end in the same state as the first
+    UNUSED(context);
+    MTGDeckRandomizer* mtg = mtg_deck_randomizer_alloc();
+    storage_common_remove(furi_record_open(RECORD_STORAGE), mtg->paths.picker);
+    furi_record_close(RECORD_STORAGE);
+    furi_check(mtg_replay(mtg, BENCH_TRACE_PATH));
+    uint32_t hash = mtg_state_hash(mtg);
+    furi_check(!bench_replay_hash || hash == bench_replay_hash);
+    bench_replay_hash = hash;
+    deck_picker_random_seed(0);
+    mtg_deck_randomizer_free(mtg);
+}
+
+static const struct {
+    AppState state;
+    const char* name;
+} bench_draw_states[] = {
+    {StateMainMenu, "main_menu"},
+    {StateSpinning, "spinning"},
+    {StateSelected, "selected"},
+    {StateDeckList, "deck_list"},
+    {StateKeyboard, "keyboard"},
+    {StateEditDeletePopup, "edit_delete_popup"},
+    {StateStats, "stats"},
+    {StateFilter, "filter"},
+    {StatePodSetup, "pod_setup"},
+    {StatePodSpinning, "pod_spinning"},
+    {StatePodSelected, "pod_selected"},
+    {StateSearch, "search"},
+    {StateSearchResults, "search_results"},
+    {StateLists, "lists"},
+    {StateImport, "import"},
+};
+
+static const struct {
+    AppState state;
+    const char* name;
+} bench_loop_states[] = {
+    {StateMainMenu, "main_menu"},
+    {StateSpinning, "spinning"},
+    {StateSelected, "selected"},
+    {StatePodSpinning, "pod_spinning"},
+};
+
+// Lists the app loads whole; DECK_STORE_ENTRIES_MAX caps the largest
+static const size_t bench_list_sizes[] = {10, 100, 1000, 10000, 50000};
+// Parsing alone has no deck limit, so it is timed on a longer file too
+#define BENCH_PARSE_LINES 100000
+
+static void bench_line_readers(size_t lines) {
+    char name[64];
+    for (size_t i = 0; i < COUNT_OF(bench_block_sizes); i++) {
+        BenchLineReader reader = {.block_size = bench_block_sizes[i], .lines = lines};
+        snprintf(name, sizeof(name), "line_reader/%zuB/%zu", bench_block_sizes[i], lines);
+        bench_run(name, bench_line_reader, &reader, NULL);
+    }
+}
+
+static void bench_deck_list(MTGDeckRandomizer* mtg, Canvas* canvas, size_t lines) {
+    char name[64];
+    bench_write_deck_file(lines);
+
+    snprintf(name, sizeof(name), "load_decks_text/%zu", lines);
+    bench_run(name, bench_load_decks_text, mtg, NULL);
+    furi_check(mtg->deck_count == (int)lines);
+
+    snprintf(name, sizeof(name), "load_decks/%zu", lines);
+    bench_run(name, bench_load_decks, mtg, NULL);
+    furi_check(mtg->deck_count == (int)lines);
+
+    snprintf(name, sizeof(name), "make_resident/%zu", lines);
+    bench_run(name, bench_make_resident, mtg, NULL);
+    furi_check(mtg->deck_count == (int)lines);
+
+    bench_line_readers(lines);
+
+    snprintf(name, sizeof(name), "save_decks/%zu", lines);
+    bench_run(name, bench_save_decks, mtg, NULL);
+
+    // Draw and pick against a freshly opened list, as right after startup: the
+    // first load parses the restored file, the second opens the rebuilt index
+    bench_write_deck_file(lines);
+    load_decks(mtg);
+    furi_check(mtg->deck_count == (int)lines);
+    load_decks(mtg);
+    furi_check(mtg->deck_count == (int)lines);
+    furi_check(mtg->index);
+    mtg->selected_deck = 0;
+    stats_rows_load(mtg);
+    furi_check(mtg_search_prepare(mtg));
+    mtg_search_update(mtg);
+
+    for (size_t i = 0; i < COUNT_OF(bench_draw_states); i++) {
+        BenchDraw draw = {.mtg = mtg, .canvas = canvas, .state = bench_draw_states[i].state};
+        // Freeze the virtual clock inside the animation windows
+        mtg->spin_start_time = furi_get_tick();
+        mtg->blink_start_time = furi_get_tick();
+        mtg->blink_visible = true;
+        mtg->selected_deck = 0;
+        snprintf(name, sizeof(name), "draw/%s/%zu", bench_draw_states[i].name, lines);
+        bench_run(name, bench_draw, &draw, canvas);
+    }
+    // The overlay adds a pass over the sample ring and two lines to any screen
+    mtg->perf_overlay = true;
+    BenchDraw overlay = {.mtg = mtg, .canvas = canvas, .state = StateMainMenu};
+    snprintf(name, sizeof(name), "draw/perf_overlay/%zu", lines);
+    bench_run(name, bench_draw, &overlay, canvas);
+    mtg->perf_overlay = false;
+    mtg->state = StateMainMenu;
+
+    // Idle screens should cost nothing; animations a fixed number of frames
+    ViewPort* view_port = view_port_alloc();
+    view_port_draw_callback_set(view_port, mtg_deck_randomizer_draw_callback, mtg);
+    for (size_t i = 0; i < COUNT_OF(bench_loop_states); i++) {
+        BenchLoop loop = {
+            .mtg = mtg, .view_port = view_port, .canvas = canvas, .state = bench_loop_states[i].state};
+        snprintf(name, sizeof(name), "loop_second/%s/%zu", bench_loop_states[i].name, lines);
+        bench_run(name, bench_loop_second, &loop, canvas);
+    }
+    mtg->state = StateMainMenu;
+    mtg_deck_randomizer_schedule_frames(mtg);
+    view_port_free(view_port);
+
+    // Scrolling pages names in from the index and prefetches ahead
+    snprintf(name, sizeof(name), "scroll/%zu", lines);
+    bench_run(name, bench_scroll, mtg, NULL);
+    view_port = view_port_alloc();
+    view_port_input_callback_set(view_port, mtg_deck_randomizer_input_callback, mtg);
+    BenchInput input = {.mtg = mtg, .view_port = view_port};
+    mtg->selected_deck = 0;
+    snprintf(name, sizeof(name), "input_hold/%zu", lines);
+    bench_run(name, bench_input_hold, &input, NULL);
+    view_port_free(view_port);
+    mtg->state = StateMainMenu;
+
+    // Building the bitplanes reads the metadata table in batches
+    snprintf(name, sizeof(name), "filter_prepare/%zu", lines);
+    bench_run(name, bench_filter_prepare, mtg, NULL);
+
+    // The search order comes ready-made from the index; each keystroke is two
+    // binary searches over names paged in through the cache
+    snprintf(name, sizeof(name), "search_prepare/%zu", lines);
+    bench_run(name, bench_search_prepare, mtg, NULL);
+    bench_search_check(mtg);
+    mtg->state = StateDeckList;
+    bench_press(mtg, InputKeyRight);
+    snprintf(name, sizeof(name), "search_type/%zu", lines);
+    bench_run(name, bench_search_type, mtg, NULL);
+    mtg->state = StateMainMenu;
+
+    furi_check(mtg_decks_make_resident(mtg));
+    // BENCH_IMPORT_ROWS rows merged into the list, a quarter of them duplicates
+    snprintf(name, sizeof(name), "import/%zu", lines);
+    bench_run(name, bench_import, mtg->decks, NULL);
+
+    snprintf(name, sizeof(name), "store_delete_add/%zu", lines);
+    bench_run(name, bench_store_delete_add, mtg->decks, NULL);
+    // That reshuffled the store behind the app's back
+    mtg->filter_stale = true;
+    mtg->search_stale = true;
+    furi_check(mtg_search_prepare(mtg));
+
+    snprintf(name, sizeof(name), "edit_rename/%zu", lines);
+    bench_run(name, bench_edit_rename, mtg, NULL);
+    storage_worker_flush(mtg->storage);
+    deck_journal_clear(mtg->journal);
+
+    // Every mode should pick in constant time whatever the list size. The
+    // weighted runs spread the decks over all classes first
+    deck_picker_load(mtg->picker, mtg->deck_count);
+    for (int i = 0; i < mtg->deck_count && i <= DECK_PICKER_WEIGHTED_MAX; i++) {
+        deck_picker_set_weight(mtg->picker, i, i % (DECK_PICKER_WEIGHT_MAX + 1));
+    }
+    for (DeckPickerMode mode = 0; mode < DeckPickerModeCount; mode++) {
+        deck_picker_set_mode(mtg->picker, mode);
+        snprintf(name, sizeof(name), "pick/%s/%zu", deck_picker_mode_name(mode), lines);
+        bench_run(name, bench_pick, mtg, NULL);
+    }
+    deck_picker_set_mode(mtg->picker, DeckPickerModeUniform);
+
+    // "No blue, bracket 3 or lower": a rule change is one pass over the
+    // bitplanes, a filtered pick a search over the running match counts
+    mtg->filter_rule = DECK_FILTER_RULE_ANY;
+    mtg->filter_rule.without_colors = DeckColorBlue;
+    mtg->filter_rule.bracket_max = 3;
+    snprintf(name, sizeof(name), "filter_apply/%zu", lines);
+    bench_run(name, bench_filter_apply, mtg, NULL);
+    mtg->filter_rule.bracket_max = 3;
+    mtg_filter_update(mtg);
+    furi_check(deck_filter_count(mtg->filter) > 0);
+    snprintf(name, sizeof(name), "filter_pick/%zu", lines);
+    bench_run(name, bench_pick, mtg, NULL);
+    mtg->filter_rule = DECK_FILTER_RULE_ANY;
+    mtg_filter_update(mtg);
+
+    // A pod is a fixed number of draws; balancing adds a count per bracket
+    // and two passes over the bitplanes
+    mtg->pod_rule = (PodRule){.seats = POD_SEATS_MAX, .spread = -1};
+    snprintf(name, sizeof(name), "pod_assign/%zu", lines);
+    bench_run(name, bench_pod_assign, mtg, NULL);
+    mtg->pod_rule = (PodRule){.seats = 4, .spread = 1};
+    snprintf(name, sizeof(name), "pod_assign_balanced/%zu", lines);
+    bench_run(name, bench_pod_assign, mtg, NULL);
+    mtg->pod_rule = (PodRule){.seats = POD_SEATS_DEFAULT, .spread = -1};
+
+    snprintf(name, sizeof(name), "picker_set_weight/%zu", lines);
+    bench_run(name, bench_picker_set_weight, mtg, NULL);
+
+    snprintf(name, sizeof(name), "play_log_append/%zu", lines);
+    bench_run(name, bench_play_log_append, mtg, NULL);
+
+    // Switching reads the other list from its index and frees this one; the
+    // manifest alone is all startup reads, and a refresh with nothing changed
+    // is one stat per list
+    furi_check(deck_lists_count(mtg->lists) == 2);
+    int deck_count = mtg->deck_count;
+    snprintf(name, sizeof(name), "list_switch/%zu", lines);
+    bench_run(name, bench_list_switch, mtg, NULL);
+    furi_check(mtg->deck_count == deck_count);
+    snprintf(name, sizeof(name), "lists_open/%zu", lines);
+    bench_run(name, bench_lists_open, mtg, NULL);
+    snprintf(name, sizeof(name), "lists_refresh/%zu", lines);
+    bench_run(name, bench_lists_refresh, mtg, NULL);
+
+    // Startup, the trace and the final save of a whole replayed session
+    bench_replay_hash = 0;
+    snprintf(name, sizeof(name), "replay/%zu", lines);
+    bench_run(name, bench_replay, NULL, NULL);
+
+    mtg->state = StateMainMenu;
+}
+
+static const size_t bench_history_games[] = {10, 10000};
+
+// Opening the stats screen and the log should cost the same however many
+// games have been recorded
+static void bench_play_history(MTGDeckRandomizer* mtg, size_t games) {
+    char name[64];
+    play_log_close(mtg->plays);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_common_remove(storage, PLAY_HISTORY_PATH);
+    storage_common_remove(storage, PLAY_STATS_PATH);
+    furi_record_close(RECORD_STORAGE);
+    mtg->plays = play_log_open(PLAY_HISTORY_PATH, PLAY_STATS_PATH, PLAY_HISTORY_SIZE);
+
+    int decks = MIN(mtg->deck_count, 100);
+    for (size_t i = 0; i < games; i++) {
+        mtg_log_play(mtg, i % decks, PlayResultPicked);
+    }
+    furi_check(play_log_totals(mtg->plays)->games == games);
+
+    snprintf(name, sizeof(name), "stats_open/%zu_games", games);
+    bench_run(name, bench_stats_open, mtg, NULL);
+
+    snprintf(name, sizeof(name), "play_log_open/%zu_games", games);
+    bench_run(name, bench_play_log_open, mtg, NULL);
+    mtg->state = StateMainMenu;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            bench_config.min_ns = 10000000ULL;
+        } else {
+            bench_config.filter = argv[i];
+        }
+    }
+
+    bench_fixture_alloc();
+    furi_host_tick_set(1000);
+    bench_trace_record();
+    bench_write_import_file();
+
+    MTGDeckRandomizer* mtg = mtg_deck_randomizer_alloc();
+    Canvas* canvas = furi_host_canvas_alloc();
+
+    printf(
+        "%-32s %10s %12s %9s %11s %9s %9s %9s %9s %11s\n",
+        "benchmark",
+        "iters",
+        "ns/op",
+        "allocs/op",
+        "bytes/op",
+        "reads/op",
+        "writes/op",
+        "draws/op",
+        "fonts/op",
+        "measures/op");
+
+    bench_write_deck_file(BENCH_PARSE_LINES);
+    bench_line_readers(BENCH_PARSE_LINES);
+    for (size_t i = 0; i < COUNT_OF(bench_list_sizes); i++) {
+        bench_deck_list(mtg, canvas, bench_list_sizes[i]);
+    }
+    for (size_t i = 0; i < COUNT_OF(bench_history_games); i++) {
+        bench_play_history(mtg, bench_history_games[i]);
+    }
+
+    bench_run("perf_dump", bench_perf_dump, NULL, NULL);
+
+    furi_host_canvas_free(canvas);
+    mtg_deck_randomizer_free(mtg);
+    bench_fixture_free();
+    return 0;
+}
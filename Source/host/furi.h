@@ -0,0 +1,170 @@
+#pragma once
+
+// Minimal Linux stand-in for the parts of the Flipper firmware API used by the app.
+// Only what mtg_deck_randomizer needs is provided; behaviour follows the firmware
+// closely enough to measure and regression-test the app core on a PC.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define UNUSED(x) (void)(x)
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef COUNT_OF
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+#endif
+
+#define furi_assert(x) assert(x)
+#define furi_check(x)  \
+    do {               \
+        if (!(x)) abort(); \
+    } while (0)
+#define furi_crash(message) abort()
+
+// Memory manager. The host heap has no fixed size; both report 0
+
+size_t memmgr_get_free_heap(void);
+size_t memmgr_get_minimum_free_heap(void);
+
+// Logging
+
+void furi_host_log(char level, const char* tag, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define FURI_LOG_E(tag, format, ...) furi_host_log('E', tag, format, ##__VA_ARGS__)
+#define FURI_LOG_W(tag, format, ...) furi_host_log('W', tag, format, ##__VA_ARGS__)
+#define FURI_LOG_I(tag, format, ...) furi_host_log('I', tag, format, ##__VA_ARGS__)
+#define FURI_LOG_D(tag, format, ...) furi_host_log('D', tag, format, ##__VA_ARGS__)
+#define FURI_LOG_T(tag, format, ...) furi_host_log('T', tag, format, ##__VA_ARGS__)
+
+// Kernel
+
+typedef enum {
+    FuriStatusOk = 0,
+    FuriStatusError = -1,
+    FuriStatusErrorTimeout = -2,
+    FuriStatusErrorResource = -3,
+    FuriStatusErrorParameter = -4,
+} FuriStatus;
+
+#define FuriWaitForever 0xFFFFFFFFU
+
+uint32_t furi_get_tick(void);
+uint32_t furi_kernel_get_tick_frequency(void);
+uint32_t furi_ms_to_ticks(uint32_t milliseconds);
+void furi_delay_ms(uint32_t milliseconds);
+void furi_delay_tick(uint32_t ticks);
+
+// The firmware masks interrupts; here one process-wide lock stands in
+void furi_host_critical_enter(void);
+void furi_host_critical_exit(void);
+
+#define FURI_CRITICAL_ENTER() furi_host_critical_enter()
+#define FURI_CRITICAL_EXIT()  furi_host_critical_exit()
+
+// Records
+
+#define RECORD_STORAGE "storage"
+#define RECORD_GUI     "gui"
+
+void* furi_record_open(const char* name);
+void furi_record_close(const char* name);
+
+// Strings
+
+typedef struct FuriString FuriString;
+
+FuriString* furi_string_alloc(void);
+FuriString* furi_string_alloc_set(const char* cstr);
+FuriString* furi_string_alloc_printf(const char* format, ...)
+    __attribute__((format(printf, 1, 2)));
+void furi_string_free(FuriString* string);
+const char* furi_string_get_cstr(const FuriString* string);
+size_t furi_string_size(const FuriString* string);
+void furi_string_set_str(FuriString* string, const char* cstr);
+void furi_string_reset(FuriString* string);
+int furi_string_printf(FuriString* string, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+void furi_string_cat_str(FuriString* string, const char* cstr);
+
+// Message queue
+
+typedef struct FuriMessageQueue FuriMessageQueue;
+
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size);
+void furi_message_queue_free(FuriMessageQueue* instance);
+FuriStatus
+    furi_message_queue_put(FuriMessageQueue* instance, const void* msg_ptr, uint32_t timeout);
+FuriStatus furi_message_queue_get(FuriMessageQueue* instance, void* msg_ptr, uint32_t timeout);
+uint32_t furi_message_queue_get_count(FuriMessageQueue* instance);
+uint32_t furi_message_queue_get_space(FuriMessageQueue* instance);
+
+// Mutex
+
+typedef enum {
+    FuriMutexTypeNormal,
+    FuriMutexTypeRecursive,
+} FuriMutexType;
+
+typedef struct FuriMutex FuriMutex;
+
+FuriMutex* furi_mutex_alloc(FuriMutexType type);
+void furi_mutex_free(FuriMutex* instance);
+FuriStatus furi_mutex_acquire(FuriMutex* instance, uint32_t timeout);
+FuriStatus furi_mutex_release(FuriMutex* instance);
+
+// Timers
+
+typedef void (*FuriTimerCallback)(void* context);
+
+typedef enum {
+    FuriTimerTypeOnce = 0,
+    FuriTimerTypePeriodic = 1,
+} FuriTimerType;
+
+typedef struct FuriTimer FuriTimer;
+
+FuriTimer* furi_timer_alloc(FuriTimerCallback func, FuriTimerType type, void* context);
+void furi_timer_free(FuriTimer* instance);
+FuriStatus furi_timer_start(FuriTimer* instance, uint32_t ticks);
+FuriStatus furi_timer_stop(FuriTimer* instance);
+uint32_t furi_timer_is_running(FuriTimer* instance);
+
+// Threads
+
+typedef int32_t (*FuriThreadCallback)(void* context);
+typedef struct FuriThread FuriThread;
+typedef void* FuriThreadId;
+
+typedef enum {
+    FuriFlagWaitAny = 0x00000000U,
+    FuriFlagWaitAll = 0x00000001U,
+    FuriFlagNoClear = 0x00000002U,
+    FuriFlagError = 0x80000000U,
+    FuriFlagErrorUnknown = 0xFFFFFFFFU,
+    FuriFlagErrorTimeout = 0xFFFFFFFEU,
+} FuriFlag;
+
+FuriThread* furi_thread_alloc_ex(
+    const char* name,
+    uint32_t stack_size,
+    FuriThreadCallback callback,
+    void* context);
+void furi_thread_free(FuriThread* thread);
+void furi_thread_start(FuriThread* thread);
+bool furi_thread_join(FuriThread* thread);
+FuriThreadId furi_thread_get_id(FuriThread* thread);
+FuriThreadId furi_thread_get_current_id(void);
+// The host has no fixed-size task stacks; reports 0
+uint32_t furi_thread_get_stack_space(FuriThreadId thread_id);
+uint32_t furi_thread_flags_set(FuriThreadId thread_id, uint32_t flags);
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <furi.h>
+
+uint32_t furi_hal_random_get(void);
+void furi_hal_random_fill_buf(uint8_t* buf, uint32_t len);
+
+uint32_t furi_hal_rtc_get_timestamp(void);
+
+// Cortex-M DWT cycle counter. Each access to DWT reads the host's monotonic
+// clock, scaled to furi_hal_cortex_instructions_per_microsecond()
+typedef struct {
+    uint32_t CYCCNT;
+} DWT_Type;
+
+DWT_Type* furi_host_dwt(void);
+#define DWT (furi_host_dwt())
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
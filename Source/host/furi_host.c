@@ -0,0 +1,1116 @@
+#include "furi_host.h"
+#include <furi_hal.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Allocation accounting. The host build links with -Wl,--wrap for the libc
+// allocator so every malloc/free made by app code (and by these stand-ins,
+// mirroring the firmware heap) is counted.
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+static FuriHostAllocStats alloc_stats;
+
+void* __wrap_malloc(size_t size) {
+    __atomic_add_fetch(&alloc_stats.allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_stats.bytes, size, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    __atomic_add_fetch(&alloc_stats.allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_stats.bytes, count * size, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    __atomic_add_fetch(&alloc_stats.allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_stats.bytes, size, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void* ptr) {
+    if (ptr) __atomic_add_fetch(&alloc_stats.frees, 1, __ATOMIC_RELAXED);
+    __real_free(ptr);
+}
+
+FuriHostAllocStats furi_host_alloc_stats(void) {
+    FuriHostAllocStats stats;
+    stats.allocs = __atomic_load_n(&alloc_stats.allocs, __ATOMIC_RELAXED);
+    stats.frees = __atomic_load_n(&alloc_stats.frees, __ATOMIC_RELAXED);
+    stats.bytes = __atomic_load_n(&alloc_stats.bytes, __ATOMIC_RELAXED);
+    return stats;
+}
+
+// Logging
+
+static char log_level = 0;
+
+void furi_host_log_level_set(char level) {
+    log_level = level;
+}
+
+static int log_rank(char level) {
+    const char* levels = "EWIDT";
+    const char* found = level ? strchr(levels, level) : NULL;
+    return found ? (int)(found - levels) : -1;
+}
+
+void furi_host_log(char level, const char* tag, const char* format, ...) {
+    if (log_rank(level) > log_rank(log_level)) return;
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[%c][%s] ", level, tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+// Memory manager
+
+size_t memmgr_get_free_heap(void) {
+    return 0;
+}
+
+size_t memmgr_get_minimum_free_heap(void) {
+    return 0;
+}
+
+// Kernel
+
+static uint32_t host_tick;
+
+void furi_host_tick_set(uint32_t tick) {
+    __atomic_store_n(&host_tick, tick, __ATOMIC_RELAXED);
+}
+
+static void furi_timer_fire_due(void);
+
+void furi_host_tick_advance(uint32_t ticks) {
+    __atomic_add_fetch(&host_tick, ticks, __ATOMIC_RELAXED);
+    furi_timer_fire_due();
+}
+
+uint32_t furi_get_tick(void) {
+    return __atomic_load_n(&host_tick, __ATOMIC_RELAXED);
+}
+
+static pthread_mutex_t host_critical = PTHREAD_MUTEX_INITIALIZER;
+
+void furi_host_critical_enter(void) {
+    pthread_mutex_lock(&host_critical);
+}
+
+void furi_host_critical_exit(void) {
+    pthread_mutex_unlock(&host_critical);
+}
+
+uint32_t furi_kernel_get_tick_frequency(void) {
+    return 1000;
+}
+
+uint32_t furi_ms_to_ticks(uint32_t milliseconds) {
+    return milliseconds;
+}
+
+void furi_delay_ms(uint32_t milliseconds) {
+    furi_host_tick_advance(milliseconds);
+}
+
+void furi_delay_tick(uint32_t ticks) {
+    furi_host_tick_advance(ticks);
+}
+
+// Records
+
+static int record_storage;
+static int record_gui;
+
+void* furi_record_open(const char* name) {
+    if (strcmp(name, RECORD_STORAGE) == 0) return &record_storage;
+    if (strcmp(name, RECORD_GUI) == 0) return &record_gui;
+    furi_check(false);
+    return NULL;
+}
+
+void furi_record_close(const char* name) {
+    UNUSED(name);
+}
+
+// Strings
+
+struct FuriString {
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+static void furi_string_reserve(FuriString* string, size_t size) {
+    if (size + 1 <= string->capacity) return;
+    size_t capacity = string->capacity ? string->capacity : 16;
+    while (capacity < size + 1)
+        capacity *= 2;
+    string->data = realloc(string->data, capacity);
+    string->capacity = capacity;
+}
+
+FuriString* furi_string_alloc(void) {
+    FuriString* string = malloc(sizeof(FuriString));
+    string->data = NULL;
+    string->size = 0;
+    string->capacity = 0;
+    furi_string_reserve(string, 0);
+    string->data[0] = '\0';
+    return string;
+}
+
+FuriString* furi_string_alloc_set(const char* cstr) {
+    FuriString* string = furi_string_alloc();
+    furi_string_set_str(string, cstr);
+    return string;
+}
+
+static int furi_string_vprintf(FuriString* string, const char* format, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int size = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (size < 0) return size;
+    furi_string_reserve(string, size);
+    vsnprintf(string->data, size + 1, format, args);
+    string->size = size;
+    return size;
+}
+
+FuriString* furi_string_alloc_printf(const char* format, ...) {
+    FuriString* string = furi_string_alloc();
+    va_list args;
+    va_start(args, format);
+    furi_string_vprintf(string, format, args);
+    va_end(args);
+    return string;
+}
+
+void furi_string_free(FuriString* string) {
+    free(string->data);
+    free(string);
+}
+
+const char* furi_string_get_cstr(const FuriString* string) {
+    return string->data;
+}
+
+size_t furi_string_size(const FuriString* string) {
+    return string->size;
+}
+
+void furi_string_set_str(FuriString* string, const char* cstr) {
+    size_t size = strlen(cstr);
+    furi_string_reserve(string, size);
+    memcpy(string->data, cstr, size + 1);
+    string->size = size;
+}
+
+void furi_string_reset(FuriString* string) {
+    string->size = 0;
+    string->data[0] = '\0';
+}
+
+int furi_string_printf(FuriString* string, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = furi_string_vprintf(string, format, args);
+    va_end(args);
+    return result;
+}
+
+void furi_string_cat_str(FuriString* string, const char* cstr) {
+    size_t size = strlen(cstr);
+    furi_string_reserve(string, string->size + size);
+    memcpy(string->data + string->size, cstr, size + 1);
+    string->size += size;
+}
+
+// Message queue
+
+struct FuriMessageQueue {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    uint8_t* buffer;
+    uint32_t msg_count;
+    uint32_t msg_size;
+    uint32_t head;
+    uint32_t count;
+};
+
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size) {
+    FuriMessageQueue* instance = malloc(sizeof(FuriMessageQueue));
+    pthread_mutex_init(&instance->mutex, NULL);
+    pthread_cond_init(&instance->changed, NULL);
+    instance->buffer = malloc(msg_count * msg_size);
+    instance->msg_count = msg_count;
+    instance->msg_size = msg_size;
+    instance->head = 0;
+    instance->count = 0;
+    return instance;
+}
+
+void furi_message_queue_free(FuriMessageQueue* instance) {
+    pthread_cond_destroy(&instance->changed);
+    pthread_mutex_destroy(&instance->mutex);
+    free(instance->buffer);
+    free(instance);
+}
+
+// Waits on the queue condition; timeouts are real time so threads make progress
+// independently of the virtual tick.
+static bool furi_message_queue_wait(FuriMessageQueue* instance, uint32_t timeout) {
+    if (timeout == 0) return false;
+    if (timeout == FuriWaitForever) {
+        pthread_cond_wait(&instance->changed, &instance->mutex);
+        return true;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(&instance->changed, &instance->mutex, &deadline) == 0;
+}
+
+FuriStatus
+    furi_message_queue_put(FuriMessageQueue* instance, const void* msg_ptr, uint32_t timeout) {
+    FuriStatus status = FuriStatusOk;
+    pthread_mutex_lock(&instance->mutex);
+    while (instance->count == instance->msg_count) {
+        if (!furi_message_queue_wait(instance, timeout)) {
+            status = timeout ? FuriStatusErrorTimeout : FuriStatusErrorResource;
+            break;
+        }
+    }
+    if (status == FuriStatusOk) {
+        uint32_t tail = (instance->head + instance->count) % instance->msg_count;
+        memcpy(instance->buffer + tail * instance->msg_size, msg_ptr, instance->msg_size);
+        instance->count++;
+        pthread_cond_broadcast(&instance->changed);
+    }
+    pthread_mutex_unlock(&instance->mutex);
+    return status;
+}
+
+FuriStatus furi_message_queue_get(FuriMessageQueue* instance, void* msg_ptr, uint32_t timeout) {
+    FuriStatus status = FuriStatusOk;
+    pthread_mutex_lock(&instance->mutex);
+    while (instance->count == 0) {
+        if (!furi_message_queue_wait(instance, timeout)) {
+            status = timeout ? FuriStatusErrorTimeout : FuriStatusErrorResource;
+            break;
+        }
+    }
+    if (status == FuriStatusOk) {
+        memcpy(msg_ptr, instance->buffer + instance->head * instance->msg_size, instance->msg_size);
+        instance->head = (instance->head + 1) % instance->msg_count;
+        instance->count--;
+        pthread_cond_broadcast(&instance->changed);
+    }
+    pthread_mutex_unlock(&instance->mutex);
+    return status;
+}
+
+uint32_t furi_message_queue_get_count(FuriMessageQueue* instance) {
+    pthread_mutex_lock(&instance->mutex);
+    uint32_t count = instance->count;
+    pthread_mutex_unlock(&instance->mutex);
+    return count;
+}
+
+uint32_t furi_message_queue_get_space(FuriMessageQueue* instance) {
+    pthread_mutex_lock(&instance->mutex);
+    uint32_t space = instance->msg_count - instance->count;
+    pthread_mutex_unlock(&instance->mutex);
+    return space;
+}
+
+// Mutex
+
+struct FuriMutex {
+    pthread_mutex_t mutex;
+};
+
+FuriMutex* furi_mutex_alloc(FuriMutexType type) {
+    FuriMutex* instance = malloc(sizeof(FuriMutex));
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(
+        &attr, type == FuriMutexTypeRecursive ? PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_NORMAL);
+    pthread_mutex_init(&instance->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return instance;
+}
+
+void furi_mutex_free(FuriMutex* instance) {
+    pthread_mutex_destroy(&instance->mutex);
+    free(instance);
+}
+
+FuriStatus furi_mutex_acquire(FuriMutex* instance, uint32_t timeout) {
+    if (timeout == 0) {
+        return pthread_mutex_trylock(&instance->mutex) == 0 ? FuriStatusOk : FuriStatusErrorResource;
+    }
+    // Timed waits are not needed by the app; anything non-zero waits until acquired
+    return pthread_mutex_lock(&instance->mutex) == 0 ? FuriStatusOk : FuriStatusError;
+}
+
+FuriStatus furi_mutex_release(FuriMutex* instance) {
+    return pthread_mutex_unlock(&instance->mutex) == 0 ? FuriStatusOk : FuriStatusError;
+}
+
+// Timers run off the virtual clock: furi_host_tick_advance fires whatever came
+// due, on the calling thread, so animation is reproducible run to run
+
+struct FuriTimer {
+    FuriTimerCallback callback;
+    FuriTimerType type;
+    void* context;
+    bool running;
+    uint32_t period;
+    uint32_t deadline;
+    FuriTimer* next;
+};
+
+static pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FuriTimer* timer_list;
+
+FuriTimer* furi_timer_alloc(FuriTimerCallback func, FuriTimerType type, void* context) {
+    FuriTimer* instance = malloc(sizeof(FuriTimer));
+    instance->callback = func;
+    instance->type = type;
+    instance->context = context;
+    instance->running = false;
+    instance->period = 0;
+    instance->deadline = 0;
+    pthread_mutex_lock(&timer_mutex);
+    instance->next = timer_list;
+    timer_list = instance;
+    pthread_mutex_unlock(&timer_mutex);
+    return instance;
+}
+
+void furi_timer_free(FuriTimer* instance) {
+    pthread_mutex_lock(&timer_mutex);
+    for (FuriTimer** link = &timer_list; *link; link = &(*link)->next) {
+        if (*link == instance) {
+            *link = instance->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&timer_mutex);
+    free(instance);
+}
+
+FuriStatus furi_timer_start(FuriTimer* instance, uint32_t ticks) {
+    if (ticks == 0) return FuriStatusErrorParameter;
+    pthread_mutex_lock(&timer_mutex);
+    instance->period = ticks;
+    instance->deadline = furi_get_tick() + ticks;
+    instance->running = true;
+    pthread_mutex_unlock(&timer_mutex);
+    return FuriStatusOk;
+}
+
+FuriStatus furi_timer_stop(FuriTimer* instance) {
+    pthread_mutex_lock(&timer_mutex);
+    bool running = instance->running;
+    instance->running = false;
+    pthread_mutex_unlock(&timer_mutex);
+    return running ? FuriStatusOk : FuriStatusErrorResource;
+}
+
+uint32_t furi_timer_is_running(FuriTimer* instance) {
+    pthread_mutex_lock(&timer_mutex);
+    bool running = instance->running;
+    pthread_mutex_unlock(&timer_mutex);
+    return running;
+}
+
+static void furi_timer_fire_due(void) {
+    for (;;) {
+        // Earliest due timer first; callbacks run unlocked so they may restart or stop timers
+        uint32_t now = furi_get_tick();
+        FuriTimer* due = NULL;
+        pthread_mutex_lock(&timer_mutex);
+        for (FuriTimer* timer = timer_list; timer; timer = timer->next) {
+            if (!timer->running || (int32_t)(now - timer->deadline) < 0) continue;
+            if (!due || (int32_t)(timer->deadline - due->deadline) < 0) due = timer;
+        }
+        if (due) {
+            if (due->type == FuriTimerTypePeriodic) {
+                due->deadline += due->period;
+            } else {
+                due->running = false;
+            }
+        }
+        pthread_mutex_unlock(&timer_mutex);
+
+        if (!due) break;
+        due->callback(due->context);
+    }
+}
+
+// Threads and thread flags
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    uint32_t flags;
+} FuriHostThreadFlags;
+
+struct FuriThread {
+    pthread_t thread;
+    FuriThreadCallback callback;
+    void* context;
+    bool started;
+    FuriHostThreadFlags flags;
+};
+
+// Threads not started through furi_thread (the app entry point on the host) get
+// their own flags so furi_thread_get_current_id works everywhere, as on the firmware
+static __thread FuriHostThreadFlags thread_self_flags = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    0,
+};
+static __thread FuriHostThreadFlags* thread_current_flags;
+
+FuriThread* furi_thread_alloc_ex(
+    const char* name,
+    uint32_t stack_size,
+    FuriThreadCallback callback,
+    void* context) {
+    UNUSED(name);
+    UNUSED(stack_size);
+    FuriThread* thread = malloc(sizeof(FuriThread));
+    thread->callback = callback;
+    thread->context = context;
+    thread->started = false;
+    pthread_mutex_init(&thread->flags.mutex, NULL);
+    pthread_cond_init(&thread->flags.changed, NULL);
+    thread->flags.flags = 0;
+    return thread;
+}
+
+void furi_thread_free(FuriThread* thread) {
+    furi_check(!thread->started);
+    pthread_cond_destroy(&thread->flags.changed);
+    pthread_mutex_destroy(&thread->flags.mutex);
+    free(thread);
+}
+
+static void* furi_thread_body(void* context) {
+    FuriThread* thread = context;
+    thread_current_flags = &thread->flags;
+    thread->callback(thread->context);
+    return NULL;
+}
+
+void furi_thread_start(FuriThread* thread) {
+    furi_check(!thread->started);
+    thread->started = true;
+    furi_check(pthread_create(&thread->thread, NULL, furi_thread_body, thread) == 0);
+}
+
+bool furi_thread_join(FuriThread* thread) {
+    if (thread->started) {
+        pthread_join(thread->thread, NULL);
+        thread->started = false;
+    }
+    return true;
+}
+
+FuriThreadId furi_thread_get_id(FuriThread* thread) {
+    return &thread->flags;
+}
+
+FuriThreadId furi_thread_get_current_id(void) {
+    return thread_current_flags ? thread_current_flags : &thread_self_flags;
+}
+
+uint32_t furi_thread_get_stack_space(FuriThreadId thread_id) {
+    UNUSED(thread_id);
+    return 0;
+}
+
+uint32_t furi_thread_flags_set(FuriThreadId thread_id, uint32_t flags) {
+    FuriHostThreadFlags* target = thread_id;
+    pthread_mutex_lock(&target->mutex);
+    target->flags |= flags;
+    uint32_t result = target->flags;
+    pthread_cond_broadcast(&target->changed);
+    pthread_mutex_unlock(&target->mutex);
+    return result;
+}
+
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    FuriHostThreadFlags* self = furi_thread_get_current_id();
+    bool wait_all = options & FuriFlagWaitAll;
+    uint32_t result = FuriFlagErrorTimeout;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (timeout != FuriWaitForever) {
+        deadline.tv_sec += timeout / 1000;
+        deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&self->mutex);
+    while (true) {
+        uint32_t set = self->flags & flags;
+        if (wait_all ? set == flags : set != 0) {
+            result = self->flags;
+            if (!(options & FuriFlagNoClear)) self->flags &= ~flags;
+            break;
+        }
+        if (timeout == 0) break;
+        if (timeout == FuriWaitForever) {
+            pthread_cond_wait(&self->changed, &self->mutex);
+        } else if (pthread_cond_timedwait(&self->changed, &self->mutex, &deadline) != 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&self->mutex);
+    return result;
+}
+
+// Random
+
+static uint32_t random_state = 0x2545F491;
+
+void furi_host_random_seed(uint32_t seed) {
+    random_state = seed ? seed : 0x2545F491;
+}
+
+uint32_t furi_hal_random_get(void) {
+    // xorshift32: deterministic so benchmark and replay runs are reproducible
+    uint32_t x = random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    random_state = x;
+    return x;
+}
+
+void furi_hal_random_fill_buf(uint8_t* buf, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)furi_hal_random_get();
+    }
+}
+
+// RTC
+
+static uint32_t rtc_base = 1700000000;
+
+void furi_host_rtc_set(uint32_t timestamp) {
+    rtc_base = timestamp - furi_get_tick() / 1000;
+}
+
+static DWT_Type host_dwt;
+
+DWT_Type* furi_host_dwt(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t micros = (uint64_t)now.tv_sec * 1000000U + now.tv_nsec / 1000U;
+    host_dwt.CYCCNT = (uint32_t)(micros * furi_hal_cortex_instructions_per_microsecond());
+    return &host_dwt;
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return 64;
+}
+
+uint32_t furi_hal_rtc_get_timestamp(void) {
+    // Follows the virtual clock so runs stay reproducible
+    return rtc_base + furi_get_tick() / 1000;
+}
+
+// Canvas
+
+struct Canvas {
+    Font font;
+    Color color;
+    FuriHostCanvasStats stats;
+};
+
+// Average glyph advance per font; close enough to the firmware fonts for layout
+static const uint8_t canvas_font_advance[FontTotalNumber] = {6, 5, 5, 12};
+static const uint8_t canvas_font_height[FontTotalNumber] = {10, 8, 8, 15};
+
+static void canvas_hash(Canvas* canvas, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    uint32_t hash = canvas->stats.hash;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    canvas->stats.hash = hash;
+}
+
+static void canvas_hash_op(Canvas* canvas, char op, int32_t a, int32_t b, int32_t c, int32_t d) {
+    int32_t data[5] = {op, a, b, c, d};
+    canvas->stats.draw_calls++;
+    canvas_hash(canvas, data, sizeof(data));
+}
+
+Canvas* furi_host_canvas_alloc(void) {
+    Canvas* canvas = malloc(sizeof(Canvas));
+    furi_host_canvas_reset(canvas);
+    return canvas;
+}
+
+void furi_host_canvas_free(Canvas* canvas) {
+    free(canvas);
+}
+
+FuriHostCanvasStats furi_host_canvas_stats(const Canvas* canvas) {
+    return canvas->stats;
+}
+
+void furi_host_canvas_reset(Canvas* canvas) {
+    canvas->font = FontSecondary;
+    canvas->color = ColorBlack;
+    memset(&canvas->stats, 0, sizeof(canvas->stats));
+    canvas->stats.hash = 2166136261U;
+}
+
+void canvas_clear(Canvas* canvas) {
+    canvas_hash_op(canvas, 'C', 0, 0, 0, 0);
+}
+
+void canvas_set_font(Canvas* canvas, Font font) {
+    if (canvas->font != font) canvas->stats.font_switches++;
+    canvas->font = font;
+}
+
+void canvas_set_color(Canvas* canvas, Color color) {
+    canvas->color = color;
+}
+
+size_t canvas_width(const Canvas* canvas) {
+    UNUSED(canvas);
+    return 128;
+}
+
+size_t canvas_height(const Canvas* canvas) {
+    UNUSED(canvas);
+    return 64;
+}
+
+uint16_t canvas_string_width(Canvas* canvas, const char* str) {
+    canvas->stats.string_measures++;
+    return (uint16_t)(strlen(str) * canvas_font_advance[canvas->font]);
+}
+
+size_t canvas_current_font_height(const Canvas* canvas) {
+    return canvas_font_height[canvas->font];
+}
+
+void canvas_draw_str(Canvas* canvas, int32_t x, int32_t y, const char* str) {
+    canvas_hash_op(canvas, 'S', x, y, canvas->font, canvas->color);
+    canvas_hash(canvas, str, strlen(str));
+}
+
+void canvas_draw_str_aligned(
+    Canvas* canvas,
+    int32_t x,
+    int32_t y,
+    Align horizontal,
+    Align vertical,
+    const char* str) {
+    // The firmware measures the string to resolve the alignment
+    uint16_t width = canvas_string_width(canvas, str);
+    if (horizontal == AlignRight) {
+        x -= width;
+    } else if (horizontal == AlignCenter) {
+        x -= width / 2;
+    }
+    if (vertical == AlignTop) {
+        y += canvas_current_font_height(canvas);
+    } else if (vertical == AlignCenter) {
+        y += canvas_current_font_height(canvas) / 2;
+    }
+    canvas_draw_str(canvas, x, y, str);
+}
+
+void canvas_draw_glyph(Canvas* canvas, int32_t x, int32_t y, uint16_t ch) {
+    canvas_hash_op(canvas, 'G', x, y, ch, canvas->font);
+}
+
+void canvas_draw_frame(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height) {
+    canvas_hash_op(canvas, 'F', x, y, (int32_t)width, (int32_t)height);
+}
+
+void canvas_draw_box(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height) {
+    canvas_hash_op(canvas, 'B', x, y, (int32_t)width, (int32_t)height);
+}
+
+void canvas_draw_line(Canvas* canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    canvas_hash_op(canvas, 'L', x1, y1, x2, y2);
+}
+
+// View port and GUI
+
+struct ViewPort {
+    bool enabled;
+    uint32_t updates;
+    ViewPortDrawCallback draw_callback;
+    void* draw_context;
+    ViewPortInputCallback input_callback;
+    void* input_context;
+};
+
+ViewPort* view_port_alloc(void) {
+    ViewPort* view_port = calloc(1, sizeof(ViewPort));
+    view_port->enabled = true;
+    return view_port;
+}
+
+void view_port_free(ViewPort* view_port) {
+    free(view_port);
+}
+
+void view_port_enabled_set(ViewPort* view_port, bool enabled) {
+    view_port->enabled = enabled;
+}
+
+void view_port_draw_callback_set(ViewPort* view_port, ViewPortDrawCallback callback, void* context) {
+    view_port->draw_callback = callback;
+    view_port->draw_context = context;
+}
+
+void view_port_input_callback_set(
+    ViewPort* view_port,
+    ViewPortInputCallback callback,
+    void* context) {
+    view_port->input_callback = callback;
+    view_port->input_context = context;
+}
+
+void view_port_update(ViewPort* view_port) {
+    __atomic_add_fetch(&view_port->updates, 1, __ATOMIC_RELAXED);
+}
+
+uint32_t furi_host_view_port_updates(ViewPort* view_port) {
+    return __atomic_load_n(&view_port->updates, __ATOMIC_RELAXED);
+}
+
+void furi_host_view_port_draw(ViewPort* view_port, Canvas* canvas) {
+    if (view_port->enabled && view_port->draw_callback) {
+        view_port->draw_callback(canvas, view_port->draw_context);
+    }
+}
+
+void furi_host_view_port_input(ViewPort* view_port, InputEvent* event) {
+    if (view_port->enabled && view_port->input_callback) {
+        view_port->input_callback(event, view_port->input_context);
+    }
+}
+
+// Input names, as the firmware spells them
+
+const char* input_get_key_name(InputKey key) {
+    static const char* const names[InputKeyMAX] = {"Up", "Down", "Right", "Left", "Ok", "Back"};
+    return key < InputKeyMAX ? names[key] : "Unknown";
+}
+
+const char* input_get_type_name(InputType type) {
+    static const char* const names[InputTypeMAX] = {"Press", "Release", "Short", "Long", "Repeat"};
+    return type < InputTypeMAX ? names[type] : "Unknown";
+}
+
+void gui_add_view_port(Gui* gui, ViewPort* view_port, GuiLayer layer) {
+    UNUSED(gui);
+    UNUSED(view_port);
+    UNUSED(layer);
+}
+
+void gui_remove_view_port(Gui* gui, ViewPort* view_port) {
+    UNUSED(gui);
+    UNUSED(view_port);
+}
+
+// Storage, backed by a host directory standing in for /ext
+
+struct File {
+    FILE* stream;
+    DIR* dir;
+    FS_Error error;
+};
+
+static char storage_root[512] = "sd";
+static FuriHostStorageStats storage_stats;
+
+void furi_host_storage_root_set(const char* path) {
+    snprintf(storage_root, sizeof(storage_root), "%s", path);
+}
+
+const char* furi_host_storage_root(void) {
+    return storage_root;
+}
+
+// The storage worker thread does I/O too, so counters are updated atomically
+#define STORAGE_STAT_ADD(field, value) __atomic_add_fetch(&storage_stats.field, value, __ATOMIC_RELAXED)
+
+FuriHostStorageStats furi_host_storage_stats(void) {
+    FuriHostStorageStats stats;
+    stats.opens = __atomic_load_n(&storage_stats.opens, __ATOMIC_RELAXED);
+    stats.reads = __atomic_load_n(&storage_stats.reads, __ATOMIC_RELAXED);
+    stats.read_bytes = __atomic_load_n(&storage_stats.read_bytes, __ATOMIC_RELAXED);
+    stats.writes = __atomic_load_n(&storage_stats.writes, __ATOMIC_RELAXED);
+    stats.write_bytes = __atomic_load_n(&storage_stats.write_bytes, __ATOMIC_RELAXED);
+    stats.seeks = __atomic_load_n(&storage_stats.seeks, __ATOMIC_RELAXED);
+    return stats;
+}
+
+static void storage_host_path(char* out, size_t size, const char* path) {
+    if (strncmp(path, "/ext", 4) == 0) path += 4;
+    snprintf(out, size, "%s%s", storage_root, path);
+}
+
+static FS_Error storage_errno(void) {
+    switch (errno) {
+        case ENOENT:
+            return FSE_NOT_EXIST;
+        case EEXIST:
+            return FSE_EXIST;
+        case EACCES:
+        case EPERM:
+            return FSE_DENIED;
+        default:
+            return FSE_INTERNAL;
+    }
+}
+
+File* storage_file_alloc(Storage* storage) {
+    UNUSED(storage);
+    File* file = malloc(sizeof(File));
+    file->stream = NULL;
+    file->dir = NULL;
+    file->error = FSE_OK;
+    return file;
+}
+
+void storage_file_free(File* file) {
+    if (file->stream) fclose(file->stream);
+    if (file->dir) closedir(file->dir);
+    free(file);
+}
+
+bool storage_file_open(File* file, const char* path, FS_AccessMode access_mode, FS_OpenMode open_mode) {
+    char host_path[1024];
+    storage_host_path(host_path, sizeof(host_path), path);
+    STORAGE_STAT_ADD(opens, 1);
+
+    const char* mode = NULL;
+    bool exists = access(host_path, F_OK) == 0;
+    switch (open_mode) {
+        case FSOM_OPEN_EXISTING:
+            mode = (access_mode == FSAM_READ) ? "rb" : "r+b";
+            break;
+        case FSOM_OPEN_ALWAYS:
+        case FSOM_OPEN_APPEND:
+            mode = exists ? "r+b" : "w+b";
+            break;
+        case FSOM_CREATE_NEW:
+            mode = "w+xb";
+            break;
+        case FSOM_CREATE_ALWAYS:
+            mode = "w+b";
+            break;
+    }
+
+    file->stream = mode ? fopen(host_path, mode) : NULL;
+    if (!file->stream) {
+        file->error = storage_errno();
+        return false;
+    }
+    if (open_mode == FSOM_OPEN_APPEND) fseek(file->stream, 0, SEEK_END);
+    file->error = FSE_OK;
+    return true;
+}
+
+bool storage_file_close(File* file) {
+    if (!file->stream) return false;
+    fclose(file->stream);
+    file->stream = NULL;
+    return true;
+}
+
+bool storage_file_is_open(File* file) {
+    return file->stream != NULL;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    if (!file->stream) return 0;
+    STORAGE_STAT_ADD(reads, 1);
+    size_t read = fread(buff, 1, bytes_to_read, file->stream);
+    STORAGE_STAT_ADD(read_bytes, read);
+    return read;
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    if (!file->stream) return 0;
+    STORAGE_STAT_ADD(writes, 1);
+    // Mixed read/write streams need a positioning call between directions
+    fseek(file->stream, 0, SEEK_CUR);
+    size_t written = fwrite(buff, 1, bytes_to_write, file->stream);
+    STORAGE_STAT_ADD(write_bytes, written);
+    return written;
+}
+
+bool storage_file_seek(File* file, uint32_t offset, bool from_start) {
+    if (!file->stream) return false;
+    STORAGE_STAT_ADD(seeks, 1);
+    return fseek(file->stream, offset, from_start ? SEEK_SET : SEEK_CUR) == 0;
+}
+
+uint64_t storage_file_tell(File* file) {
+    if (!file->stream) return 0;
+    return (uint64_t)ftell(file->stream);
+}
+
+uint64_t storage_file_size(File* file) {
+    if (!file->stream) return 0;
+    struct stat st;
+    fflush(file->stream);
+    if (fstat(fileno(file->stream), &st) != 0) return 0;
+    return (uint64_t)st.st_size;
+}
+
+bool storage_file_truncate(File* file) {
+    if (!file->stream) return false;
+    fflush(file->stream);
+    return ftruncate(fileno(file->stream), ftell(file->stream)) == 0;
+}
+
+bool storage_file_sync(File* file) {
+    if (!file->stream) return false;
+    return fflush(file->stream) == 0;
+}
+
+bool storage_file_eof(File* file) {
+    if (!file->stream) return true;
+    return storage_file_tell(file) >= storage_file_size(file);
+}
+
+FS_Error storage_file_get_error(File* file) {
+    return file->error;
+}
+
+FS_Error storage_common_stat(Storage* storage, const char* path, FileInfo* fileinfo) {
+    UNUSED(storage);
+    char host_path[1024];
+    storage_host_path(host_path, sizeof(host_path), path);
+    struct stat st;
+    if (stat(host_path, &st) != 0) return storage_errno();
+    if (fileinfo) {
+        fileinfo->flags = S_ISDIR(st.st_mode) ? FSF_DIRECTORY : 0;
+        fileinfo->size = (uint64_t)st.st_size;
+    }
+    return FSE_OK;
+}
+
+FS_Error storage_common_timestamp(Storage* storage, const char* path, uint32_t* timestamp) {
+    UNUSED(storage);
+    char host_path[1024];
+    storage_host_path(host_path, sizeof(host_path), path);
+    struct stat st;
+    if (stat(host_path, &st) != 0) return storage_errno();
+    *timestamp = (uint32_t)st.st_mtime;
+    return FSE_OK;
+}
+
+FS_Error storage_common_remove(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char host_path[1024];
+    storage_host_path(host_path, sizeof(host_path), path);
+    if (remove(host_path) != 0) return storage_errno();
+    return FSE_OK;
+}
+
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path) {
+    UNUSED(storage);
+    char host_old[1024];
+    char host_new[1024];
+    storage_host_path(host_old, sizeof(host_old), old_path);
+    storage_host_path(host_new, sizeof(host_new), new_path);
+    // Like the firmware, an existing destination file is replaced
+    if (rename(host_old, host_new) != 0) return storage_errno();
+    return FSE_OK;
+}
+
+bool storage_dir_open(File* file, const char* path) {
+    char host_path[1024];
+    storage_host_path(host_path, sizeof(host_path), path);
+    STORAGE_STAT_ADD(opens, 1);
+    file->dir = opendir(host_path);
+    file->error = file->dir ? FSE_OK : storage_errno();
+    return file->dir != NULL;
+}
+
+bool storage_dir_close(File* file) {
+    if (!file->dir) return false;
+    closedir(file->dir);
+    file->dir = NULL;
+    return true;
+}
+
+bool storage_dir_read(File* file, FileInfo* fileinfo, char* name, uint16_t name_length) {
+    if (!file->dir) return false;
+    STORAGE_STAT_ADD(reads, 1);
+
+    // The firmware does not list . and ..
+    struct dirent* entry;
+    do {
+        entry = readdir(file->dir);
+    } while (entry && (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0));
+    if (!entry) {
+        file->error = FSE_NOT_EXIST;
+        return false;
+    }
+
+    if (name) snprintf(name, name_length, "%s", entry->d_name);
+    if (fileinfo) {
+        struct stat st;
+        int fd = dirfd(file->dir);
+        if (fstatat(fd, entry->d_name, &st, 0) != 0) return false;
+        fileinfo->flags = S_ISDIR(st.st_mode) ? FSF_DIRECTORY : 0;
+        fileinfo->size = (uint64_t)st.st_size;
+    }
+    return true;
+}
+
+bool storage_common_exists(Storage* storage, const char* path) {
+    return storage_common_stat(storage, path, NULL) == FSE_OK;
+}
+
+bool storage_simply_mkdir(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char host_path[1024];
+    storage_host_path(host_path, sizeof(host_path), path);
+    return mkdir(host_path, 0755) == 0 || errno == EEXIST;
+}
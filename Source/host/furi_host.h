@@ -0,0 +1,60 @@
+#pragma once
+
+// Host-only controls for the firmware stand-ins: virtual clock, SD card root,
+// and the counters the benchmark suite reports.
+
+#include <furi.h>
+#include <gui/gui.h>
+#include <storage/storage.h>
+
+typedef struct {
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t bytes;
+} FuriHostAllocStats;
+
+typedef struct {
+    uint64_t opens;
+    uint64_t reads;
+    uint64_t read_bytes;
+    uint64_t writes;
+    uint64_t write_bytes;
+    uint64_t seeks;
+} FuriHostStorageStats;
+
+typedef struct {
+    uint64_t draw_calls;
+    uint64_t font_switches;
+    uint64_t string_measures;
+    uint32_t hash;
+} FuriHostCanvasStats;
+
+// Log level filter: one of "EWIDT", or 0 to silence everything (the default)
+void furi_host_log_level_set(char level);
+
+// Virtual clock returned by furi_get_tick(), in milliseconds. Advancing it fires
+// any FuriTimer that comes due, on the calling thread
+void furi_host_tick_set(uint32_t tick);
+void furi_host_tick_advance(uint32_t ticks);
+
+// Host directory that stands in for /ext
+void furi_host_storage_root_set(const char* path);
+const char* furi_host_storage_root(void);
+
+void furi_host_random_seed(uint32_t seed);
+
+// Unix time returned by furi_hal_rtc_get_timestamp(), advancing with the virtual clock
+void furi_host_rtc_set(uint32_t timestamp);
+
+FuriHostAllocStats furi_host_alloc_stats(void);
+FuriHostStorageStats furi_host_storage_stats(void);
+
+Canvas* furi_host_canvas_alloc(void);
+void furi_host_canvas_free(Canvas* canvas);
+FuriHostCanvasStats furi_host_canvas_stats(const Canvas* canvas);
+void furi_host_canvas_reset(Canvas* canvas);
+
+// Drive a view port the way the GUI service would
+uint32_t furi_host_view_port_updates(ViewPort* view_port);
+void furi_host_view_port_draw(ViewPort* view_port, Canvas* canvas);
+void furi_host_view_port_input(ViewPort* view_port, InputEvent* event);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <furi.h>
+#include <input/input.h>
+
+typedef enum {
+    FontPrimary,
+    FontSecondary,
+    FontKeyboard,
+    FontBigNumbers,
+    FontTotalNumber,
+} Font;
+
+typedef enum {
+    AlignLeft,
+    AlignRight,
+    AlignTop,
+    AlignBottom,
+    AlignCenter,
+} Align;
+
+typedef enum {
+    ColorWhite = 0x00,
+    ColorBlack = 0x01,
+    ColorXOR = 0x02,
+} Color;
+
+typedef struct Canvas Canvas;
+
+void canvas_clear(Canvas* canvas);
+void canvas_set_font(Canvas* canvas, Font font);
+void canvas_set_color(Canvas* canvas, Color color);
+size_t canvas_width(const Canvas* canvas);
+size_t canvas_height(const Canvas* canvas);
+uint16_t canvas_string_width(Canvas* canvas, const char* str);
+size_t canvas_current_font_height(const Canvas* canvas);
+void canvas_draw_str(Canvas* canvas, int32_t x, int32_t y, const char* str);
+void canvas_draw_str_aligned(
+    Canvas* canvas,
+    int32_t x,
+    int32_t y,
+    Align horizontal,
+    Align vertical,
+    const char* str);
+void canvas_draw_glyph(Canvas* canvas, int32_t x, int32_t y, uint16_t ch);
+void canvas_draw_frame(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height);
+void canvas_draw_box(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height);
+void canvas_draw_line(Canvas* canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+typedef struct ViewPort ViewPort;
+typedef void (*ViewPortDrawCallback)(Canvas* canvas, void* context);
+typedef void (*ViewPortInputCallback)(InputEvent* event, void* context);
+
+ViewPort* view_port_alloc(void);
+void view_port_free(ViewPort* view_port);
+void view_port_enabled_set(ViewPort* view_port, bool enabled);
+void view_port_draw_callback_set(ViewPort* view_port, ViewPortDrawCallback callback, void* context);
+void view_port_input_callback_set(
+    ViewPort* view_port,
+    ViewPortInputCallback callback,
+    void* context);
+void view_port_update(ViewPort* view_port);
+
+typedef enum {
+    GuiLayerDesktop,
+    GuiLayerWindow,
+    GuiLayerStatusBarLeft,
+    GuiLayerStatusBarRight,
+    GuiLayerFullscreen,
+    GuiLayerMAX,
+} GuiLayer;
+
+typedef struct Gui Gui;
+
+void gui_add_view_port(Gui* gui, ViewPort* view_port, GuiLayer layer);
+void gui_remove_view_port(Gui* gui, ViewPort* view_port);
@@ -0,0 +1,47 @@
+// Headless replay of an input trace recorded with the app's "record" argument.
+//
+// The app entry point runs as on the device with "replay" as its argument,
+// against a host directory standing in for /ext; copy the card's apps/MTG
+// folder as it was when recording started. The report it writes is printed.
+//
+//   ./build/mtg_replay <sd-dir> [trace]
+//
+// trace is a path as the app sees it, /ext/apps/MTG/mtg_trace.bin by default.
+
+#include "furi_host.h"
+
+#include <stdio.h>
+
+int32_t mtg_deck_randomizer_app(void* p);
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <sd-dir> [trace]\n", argv[0]);
+        return 2;
+    }
+    furi_host_storage_root_set(argv[1]);
+
+    char args[512];
+    if (argc == 3) {
+        snprintf(args, sizeof(args), "replay %s", argv[2]);
+    } else {
+        snprintf(args, sizeof(args), "replay");
+    }
+    int32_t result = mtg_deck_randomizer_app(args);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/apps/MTG/mtg_replay.log", argv[1]);
+    FILE* report = fopen(path, "rb");
+    if (result != 0 || !report) {
+        fprintf(stderr, "replay failed\n");
+        if (report) fclose(report);
+        return 1;
+    }
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), report)) > 0) {
+        fwrite(buffer, 1, read, stdout);
+    }
+    fclose(report);
+    return 0;
+}
@@ -0,0 +1,721 @@
+// Host behaviour tests for the app core.
+//
+// Each test drives one module through its public interface and checks the
+// result against a plain reference computation. Randomness comes from the
+// picker's seeded sequence, so every run draws the same numbers.
+//
+//   ./build/mtg_test [filter]
+
+#include "furi_host.h"
+
+#include "../mtg_deck_filter.h"
+#include "../mtg_deck_import.h"
+#include "../mtg_deck_journal.h"
+#include "../mtg_deck_picker.h"
+#include "../mtg_deck_search.h"
+#include "../mtg_deck_store.h"
+#include "../mtg_play_log.h"
+#include "../mtg_pod.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+#define TEST_DIR          "/ext/apps/MTG"
+#define TEST_PICKER_PATH  TEST_DIR "/test_picker.bin"
+#define TEST_DECKS_PATH   TEST_DIR "/test_decks.txt"
+#define TEST_JOURNAL_PATH TEST_DIR "/test_decks.jnl"
+#define TEST_IMPORT_PATH  TEST_DIR "/import/test.csv"
+#define TEST_HISTORY_PATH TEST_DIR "/test_history.bin"
+#define TEST_STATS_PATH   TEST_DIR "/test_stats.bin"
+
+static int test_failures;
+
+#define TEST_CHECK(condition)                                           \
+    do {                                                                \
+        if (!(condition)) {                                             \
+            printf("    %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            test_failures++;                                            \
+        }                                                               \
+    } while (0)
+
+// Fixture
+
+static char test_root[] = "/tmp/mtg_test.XXXXXX";
+
+// Path of an /ext path inside the temporary SD card
+static void test_host_path(const char* path, char* out, size_t size) {
+    furi_check(strncmp(path, "/ext", 4) == 0);
+    snprintf(out, size, "%s%s", test_root, path + 4);
+}
+
+static void test_write_file(const char* path, const char* text) {
+    char host_path[1024];
+    test_host_path(path, host_path, sizeof(host_path));
+    FILE* stream = fopen(host_path, "wb");
+    furi_check(stream);
+    fputs(text, stream);
+    fclose(stream);
+}
+
+static long test_file_size(const char* path) {
+    char host_path[1024];
+    test_host_path(path, host_path, sizeof(host_path));
+    struct stat st;
+    return stat(host_path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+static int test_remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    UNUSED(st);
+    UNUSED(flag);
+    UNUSED(ftw);
+    return remove(path);
+}
+
+static void test_fixture_alloc(void) {
+    furi_check(mkdtemp(test_root));
+    furi_host_storage_root_set(test_root);
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/apps", test_root);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/apps/MTG", test_root);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/apps/MTG/import", test_root);
+    mkdir(path, 0755);
+}
+
+static void test_fixture_free(void) {
+    nftw(test_root, test_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static DeckMeta test_meta(uint8_t colors, uint8_t bracket, uint32_t tags) {
+    return colors | DECK_META_COLORS_KNOWN | (DeckMeta)bracket << DECK_META_BRACKET_SHIFT |
+           tags << DECK_META_TAGS_SHIFT;
+}
+
+// Picker
+
+// Weighted picks land on each deck in proportion to its weight
+static void test_picker_weighted(void) {
+    static const uint8_t weights[] = {0, 1, 2, 3, 9, 0, 1, 5, 2, 1};
+    const size_t count = COUNT_OF(weights);
+    const size_t draws = 200000;
+
+    DeckPicker* picker = deck_picker_alloc(TEST_PICKER_PATH);
+    deck_picker_load(picker, count);
+    uint32_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        TEST_CHECK(deck_picker_set_weight(picker, i, weights[i]));
+        total += weights[i];
+    }
+    deck_picker_set_mode(picker, DeckPickerModeWeighted);
+
+    deck_picker_random_seed(0x5EED);
+    uint32_t hits[COUNT_OF(weights)] = {0};
+    for (size_t i = 0; i < draws; i++) {
+        size_t deck = deck_picker_pick(picker);
+        furi_check(deck < count);
+        hits[deck]++;
+    }
+    deck_picker_random_seed(0);
+
+    for (size_t i = 0; i < count; i++) {
+        TEST_CHECK(deck_picker_get_weight(picker, i) == weights[i]);
+        double expected = (double)draws * weights[i] / total;
+        if (weights[i] == 0) {
+            TEST_CHECK(hits[i] == 0);
+        } else {
+            // Within 5% of the expected share, several standard deviations here
+            TEST_CHECK(hits[i] > expected * 0.95 && hits[i] < expected * 1.05);
+        }
+    }
+    deck_picker_free(picker);
+    storage_common_remove(furi_record_open(RECORD_STORAGE), TEST_PICKER_PATH);
+    furi_record_close(RECORD_STORAGE);
+}
+
+// The shuffle bag draws every deck exactly once per round
+static void test_picker_shuffle(void) {
+    const size_t count = 37;
+    DeckPicker* picker = deck_picker_alloc(TEST_PICKER_PATH);
+    deck_picker_load(picker, count);
+    deck_picker_set_mode(picker, DeckPickerModeShuffle);
+
+    deck_picker_random_seed(0xBA6);
+    for (int round = 0; round < 3; round++) {
+        uint8_t seen[37] = {0};
+        for (size_t i = 0; i < count; i++) {
+            size_t deck = deck_picker_pick(picker);
+            furi_check(deck < count);
+            seen[deck]++;
+        }
+        for (size_t i = 0; i < count; i++) {
+            TEST_CHECK(seen[i] == 1);
+        }
+    }
+    deck_picker_random_seed(0);
+
+    deck_picker_free(picker);
+    storage_common_remove(furi_record_open(RECORD_STORAGE), TEST_PICKER_PATH);
+    furi_record_close(RECORD_STORAGE);
+}
+
+// Adding and removing decks mid-round neither repeats nor skips a deck, also
+// across a reload of the state file
+static void test_picker_shuffle_edit(void) {
+    size_t count = 37;
+    DeckPicker* picker = deck_picker_alloc(TEST_PICKER_PATH);
+    deck_picker_load(picker, count);
+    deck_picker_set_mode(picker, DeckPickerModeShuffle);
+
+    deck_picker_random_seed(0xED17);
+    // drawn follows the list through the same edits as the picker
+    uint8_t drawn[40] = {0};
+    size_t first = deck_picker_pick(picker);
+    drawn[first] = 1;
+    for (size_t i = 1; i < 12; i++) {
+        drawn[deck_picker_pick(picker)]++;
+    }
+
+    size_t undrawn = 0;
+    while (drawn[undrawn]) undrawn++;
+    size_t removed[] = {first, undrawn > first ? undrawn - 1 : undrawn};
+    for (size_t r = 0; r < COUNT_OF(removed); r++) {
+        deck_picker_remove(picker, removed[r]);
+        memmove(&drawn[removed[r]], &drawn[removed[r] + 1], count - removed[r] - 1);
+        count--;
+    }
+    // The last one lands at the end of the list
+    const size_t added[] = {0, 5, 37};
+    for (size_t a = 0; a < COUNT_OF(added); a++) {
+        deck_picker_insert(picker, added[a]);
+        memmove(&drawn[added[a] + 1], &drawn[added[a]], count - added[a]);
+        drawn[added[a]] = 0;
+        count++;
+    }
+    deck_picker_sync(picker);
+    deck_picker_free(picker);
+
+    picker = deck_picker_alloc(TEST_PICKER_PATH);
+    deck_picker_load(picker, count);
+    size_t left = 0;
+    for (size_t i = 0; i < count; i++) {
+        TEST_CHECK(drawn[i] <= 1);
+        if (!drawn[i]) left++;
+    }
+    TEST_CHECK(left == count - 11);
+    for (size_t i = 0; i < left; i++) {
+        size_t deck = deck_picker_pick(picker);
+        furi_check(deck < count);
+        drawn[deck]++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        TEST_CHECK(drawn[i] == 1);
+    }
+
+    // The next round is a whole one again
+    uint8_t seen[40] = {0};
+    for (size_t i = 0; i < count; i++) {
+        seen[deck_picker_pick(picker)]++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        TEST_CHECK(seen[i] == 1);
+    }
+    deck_picker_random_seed(0);
+
+    deck_picker_free(picker);
+    storage_common_remove(furi_record_open(RECORD_STORAGE), TEST_PICKER_PATH);
+    furi_record_close(RECORD_STORAGE);
+}
+
+// Journal
+
+static DeckStore* test_store_from(const char* const* names, size_t count) {
+    DeckStore* store = deck_store_alloc();
+    for (size_t i = 0; i < count; i++) {
+        furi_check(deck_store_add(store, names[i], strlen(names[i])));
+    }
+    return store;
+}
+
+static const char* const test_journal_decks[] = {"Atraxa", "Krenko", "Urza", "Zur"};
+
+// Edits made before a power loss come back on the next start, and a record
+// torn mid-append is dropped without taking the good ones with it
+static void test_journal_replay(void) {
+    test_write_file(TEST_DECKS_PATH, "Atraxa\nKrenko\nUrza\nZur\n");
+    DeckJournal* journal = deck_journal_alloc(TEST_JOURNAL_PATH, TEST_DECKS_PATH);
+    TEST_CHECK(deck_journal_append(journal, DeckJournalOpAdd, 4, "Edgar", 5));
+    TEST_CHECK(deck_journal_append(journal, DeckJournalOpRename, 1, "Krenko, Mob Boss", 16));
+    TEST_CHECK(deck_journal_append(journal, DeckJournalOpDelete, 2, NULL, 0));
+    size_t journal_size = deck_journal_size(journal);
+    long file_size = test_file_size(TEST_JOURNAL_PATH);
+    deck_journal_free(journal);
+
+    // The crash: half of a fourth record reached the card
+    char host_path[1024];
+    test_host_path(TEST_JOURNAL_PATH, host_path, sizeof(host_path));
+    FILE* stream = fopen(host_path, "ab");
+    furi_check(stream);
+    static const uint8_t torn[] = {4, 0, 0, 0, 0, 0, DeckJournalOpAdd};
+    fwrite(torn, 1, sizeof(torn), stream);
+    fclose(stream);
+
+    journal = deck_journal_alloc(TEST_JOURNAL_PATH, TEST_DECKS_PATH);
+    TEST_CHECK(deck_journal_pending(journal));
+    DeckStore* store = test_store_from(test_journal_decks, COUNT_OF(test_journal_decks));
+    TEST_CHECK(deck_journal_replay(journal, store) == 3);
+    TEST_CHECK(deck_journal_size(journal) == journal_size);
+    TEST_CHECK(test_file_size(TEST_JOURNAL_PATH) == file_size);
+
+    static const char* const expected[] = {"Atraxa", "Krenko, Mob Boss", "Zur", "Edgar"};
+    TEST_CHECK(deck_store_count(store) == COUNT_OF(expected));
+    for (size_t i = 0; i < MIN(deck_store_count(store), COUNT_OF(expected)); i++) {
+        TEST_CHECK(strcmp(deck_store_get(store, i), expected[i]) == 0);
+    }
+
+    // Records appended after the replay follow on from the last good one
+    TEST_CHECK(deck_journal_append(journal, DeckJournalOpDelete, 0, NULL, 0));
+    deck_journal_free(journal);
+    deck_store_free(store);
+    journal = deck_journal_alloc(TEST_JOURNAL_PATH, TEST_DECKS_PATH);
+    store = test_store_from(test_journal_decks, COUNT_OF(test_journal_decks));
+    TEST_CHECK(deck_journal_replay(journal, store) == 4);
+    TEST_CHECK(deck_store_count(store) == 3);
+    TEST_CHECK(strcmp(deck_store_get(store, 0), "Krenko, Mob Boss") == 0);
+    deck_store_free(store);
+
+    // A journal for an older version of the list is thrown away
+    test_write_file(TEST_DECKS_PATH, "Atraxa\nKrenko\nUrza\nZur\nYuriko\n");
+    TEST_CHECK(!deck_journal_pending(journal));
+    TEST_CHECK(test_file_size(TEST_JOURNAL_PATH) < 0);
+    deck_journal_free(journal);
+}
+
+// Filter and pods
+
+// Deck metadata spread over every color, bracket and a few tags
+static DeckMeta test_filter_meta(size_t i) {
+    if (i % 11 == 10) return DECK_META_NONE;
+    uint32_t mixed = (uint32_t)(i * 2654435761U);
+    return test_meta(mixed >> 8 & DECK_COLORS_ALL, i % 7 == 6 ? 0 : 1 + i % 5, mixed >> 16 & 0x7);
+}
+
+static bool test_filter_reference(DeckMeta meta, const DeckFilterRule* rule) {
+    if (rule->without_colors || rule->with_colors) {
+        if (!deck_meta_has_colors(meta)) return false;
+        if (deck_meta_colors(meta) & rule->without_colors) return false;
+        if ((deck_meta_colors(meta) & rule->with_colors) != rule->with_colors) return false;
+    }
+    uint8_t bracket = deck_meta_bracket(meta);
+    if ((rule->bracket_min || rule->bracket_max) && bracket == 0) return false;
+    if (rule->bracket_min && bracket < rule->bracket_min) return false;
+    if (rule->bracket_max && bracket > rule->bracket_max) return false;
+    if (rule->tag >= 0 && !(deck_meta_tags(meta) & (1U << rule->tag))) return false;
+    return true;
+}
+
+static DeckFilter* test_filter_alloc(size_t count) {
+    DeckFilter* filter = deck_filter_alloc();
+    deck_filter_reset(filter, count);
+    for (size_t i = 0; i < count; i++) {
+        DeckMeta meta = test_filter_meta(i);
+        deck_filter_set_meta(filter, i, &meta, 1);
+    }
+    return filter;
+}
+
+// Every rule lets through exactly the decks a direct test of each deck
+// does, and the nth match and the bracket counts agree with that list
+static void test_filter_select(void) {
+    const size_t count = 300;
+    DeckFilter* filter = test_filter_alloc(count);
+
+    DeckFilterRule rules[] = {
+        DECK_FILTER_RULE_ANY,
+        DECK_FILTER_RULE_ANY,
+        DECK_FILTER_RULE_ANY,
+        DECK_FILTER_RULE_ANY,
+        DECK_FILTER_RULE_ANY,
+        DECK_FILTER_RULE_ANY,
+    };
+    rules[1].without_colors = DeckColorBlue;
+    rules[2].with_colors = DeckColorGreen | DeckColorBlack;
+    rules[3].bracket_min = 2;
+    rules[3].bracket_max = 3;
+    rules[4].bracket_max = 1;
+    rules[4].tag = 1;
+    rules[5].without_colors = DeckColorRed;
+    rules[5].bracket_min = 4;
+    rules[5].tag = 2;
+
+    for (size_t r = 0; r < COUNT_OF(rules); r++) {
+        size_t matches = deck_filter_apply(filter, &rules[r]);
+        TEST_CHECK(matches == deck_filter_count(filter));
+        TEST_CHECK(matches > 0);
+
+        size_t nth = 0;
+        uint32_t brackets[DECK_META_BRACKET_MAX + 1] = {0};
+        for (size_t i = 0; i < count; i++) {
+            bool expected = test_filter_reference(test_filter_meta(i), &rules[r]);
+            TEST_CHECK(deck_filter_matches(filter, i) == expected);
+            if (!expected) continue;
+            if (nth < matches) TEST_CHECK(deck_filter_select(filter, nth) == i);
+            brackets[deck_meta_bracket(test_filter_meta(i))]++;
+            nth++;
+        }
+        TEST_CHECK(nth == matches);
+
+        uint32_t counts[DECK_META_BRACKET_MAX + 1];
+        deck_filter_bracket_counts(filter, counts);
+        TEST_CHECK(memcmp(counts, brackets, sizeof(counts)) == 0);
+    }
+    deck_filter_free(filter);
+}
+
+// Every seat gets a different deck the rule lets through, within the spread
+// when balancing, and a pod that cannot be filled is refused
+static void test_pod_distinct(void) {
+    const size_t count = 120;
+    DeckFilter* filter = test_filter_alloc(count);
+    DeckFilterRule rule = DECK_FILTER_RULE_ANY;
+    rule.without_colors = DeckColorWhite;
+    deck_filter_apply(filter, &rule);
+
+    deck_picker_random_seed(0x90D);
+    for (int spread = -1; spread <= POD_SPREAD_MAX; spread++) {
+        for (uint8_t seats = POD_SEATS_MIN; seats <= POD_SEATS_MAX; seats++) {
+            PodRule pod = {.seats = seats, .spread = spread};
+            for (int run = 0; run < 200; run++) {
+                uint32_t decks[POD_SEATS_MAX];
+                size_t available = 0;
+                PodResult result = pod_assign(filter, &rule, &pod, decks, &available);
+                TEST_CHECK(result == PodResultOk);
+                if (result != PodResultOk) break;
+
+                uint8_t low = DECK_META_BRACKET_MAX, high = 0;
+                for (uint8_t seat = 0; seat < seats; seat++) {
+                    furi_check(decks[seat] < count);
+                    TEST_CHECK(test_filter_reference(test_filter_meta(decks[seat]), &rule));
+                    for (uint8_t other = 0; other < seat; other++) {
+                        TEST_CHECK(decks[seat] != decks[other]);
+                    }
+                    uint8_t bracket = deck_meta_bracket(test_filter_meta(decks[seat]));
+                    low = MIN(low, bracket);
+                    high = MAX(high, bracket);
+                }
+                if (spread >= 0) {
+                    TEST_CHECK(low > 0);
+                    TEST_CHECK(high - low <= spread);
+                }
+            }
+        }
+    }
+    deck_filter_free(filter);
+
+    // Three decks two brackets apart: too few for four seats, and no two of
+    // them close enough for a pod of two at spread 0
+    DeckFilter* small = deck_filter_alloc();
+    const DeckMeta metas[] = {
+        test_meta(DeckColorRed, 1, 0),
+        test_meta(DeckColorRed, 3, 0),
+        test_meta(DeckColorRed, 5, 0),
+    };
+    deck_filter_reset(small, COUNT_OF(metas));
+    deck_filter_set_meta(small, 0, metas, COUNT_OF(metas));
+    rule = DECK_FILTER_RULE_ANY;
+    deck_filter_apply(small, &rule);
+
+    uint32_t decks[POD_SEATS_MAX];
+    size_t available = 0;
+    PodRule pod = {.seats = 4, .spread = -1};
+    TEST_CHECK(pod_assign(small, &rule, &pod, decks, &available) == PodResultTooFewDecks);
+    TEST_CHECK(available == 3);
+    pod = (PodRule){.seats = 2, .spread = 0};
+    TEST_CHECK(pod_assign(small, &rule, &pod, decks, &available) == PodResultUnbalanced);
+    TEST_CHECK(available == 1);
+    pod = (PodRule){.seats = 2, .spread = 2};
+    TEST_CHECK(pod_assign(small, &rule, &pod, decks, &available) == PodResultOk);
+    deck_picker_random_seed(0);
+    deck_filter_free(small);
+}
+
+// Search
+
+static const char* test_search_name(void* context, uint32_t position) {
+    return deck_store_get(context, position);
+}
+
+// The order holds every deck once, sorted as the search compares, and each
+// prefix finds the same decks a scan of the list does
+static void test_search_check(DeckSearch* search, DeckStore* store) {
+    size_t count = deck_store_count(store);
+    uint8_t seen[64] = {0};
+    furi_check(count <= COUNT_OF(seen));
+    for (size_t rank = 0; rank < count; rank++) {
+        uint32_t position = deck_search_get(search, rank);
+        TEST_CHECK(position < count);
+        if (position >= count) return;
+        seen[position]++;
+        if (rank > 0) {
+            const char* previous = deck_store_get(store, deck_search_get(search, rank - 1));
+            TEST_CHECK(deck_search_compare(previous, deck_store_get(store, position)) <= 0);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        TEST_CHECK(seen[i] == 1);
+    }
+
+    static const char* const prefixes[] = {"", "a", "kr", "KRENKO", "urza_", "z", "q"};
+    for (size_t p = 0; p < COUNT_OF(prefixes); p++) {
+        size_t first = 0;
+        size_t found = deck_search_find(search, prefixes[p], &first);
+        size_t expected = 0;
+        size_t length = strlen(prefixes[p]);
+        for (size_t i = 0; i < count; i++) {
+            char head[64];
+            snprintf(head, sizeof(head), "%.*s", (int)length, deck_store_get(store, i));
+            if (strlen(head) == length && deck_search_compare(head, prefixes[p]) == 0) expected++;
+        }
+        TEST_CHECK(found == expected);
+        for (size_t rank = first; rank < first + found; rank++) {
+            char head[64];
+            snprintf(head, sizeof(head), "%.*s", (int)length, deck_store_get(store, deck_search_get(search, rank)));
+            TEST_CHECK(deck_search_compare(head, prefixes[p]) == 0);
+        }
+    }
+}
+
+// Adding, renaming and deleting decks keeps the order right without a resort
+static void test_search_edit(void) {
+    static const char* const names[] = {
+        "Urza Lord High Artificer",
+        "krenko mob boss",
+        "Atraxa",
+        "Zur the Enchanter",
+        "Krenko, Tin Street",
+        "animar",
+        "Urza's Saga",
+    };
+    DeckStore* store = test_store_from(names, COUNT_OF(names));
+    DeckSearch* search = deck_search_alloc(test_search_name, store);
+    uint16_t* order = deck_search_reset(search, deck_store_count(store));
+    furi_check(order);
+    TEST_CHECK(deck_search_sort(store, order));
+    test_search_check(search, store);
+
+    furi_check(deck_store_add(store, "Kenrith", 7));
+    TEST_CHECK(deck_search_insert(search, deck_store_count(store) - 1));
+    test_search_check(search, store);
+
+    furi_check(deck_store_add(store, "Aminatou", 8));
+    TEST_CHECK(deck_search_insert(search, deck_store_count(store) - 1));
+    test_search_check(search, store);
+
+    // Rename to both ends of the order and back into the middle
+    furi_check(deck_store_set(store, 2, "Zzz last", 8));
+    deck_search_update(search, 2);
+    test_search_check(search, store);
+    furi_check(deck_store_set(store, 3, "aaa first", 9));
+    deck_search_update(search, 3);
+    test_search_check(search, store);
+    furi_check(deck_store_set(store, 2, "Krenko_Legion", 13));
+    deck_search_update(search, 2);
+    test_search_check(search, store);
+
+    // Deleting moves every later position down one
+    deck_store_remove(store, 0);
+    deck_search_remove(search, 0);
+    test_search_check(search, store);
+    deck_store_remove(store, 3);
+    deck_search_remove(search, 3);
+    test_search_check(search, store);
+    deck_store_remove(store, deck_store_count(store) - 1);
+    deck_search_remove(search, deck_store_count(store));
+    test_search_check(search, store);
+
+    deck_search_free(search);
+    deck_store_free(store);
+}
+
+// Import
+
+static DeckImportStatus test_import(const char* text, DeckStore* store) {
+    test_write_file(TEST_IMPORT_PATH, text);
+    DeckImport* import = deck_import_open(TEST_IMPORT_PATH, store);
+    furi_check(import);
+    // A few rows a step, so rows straddle the steps
+    DeckImportStatus status;
+    while ((status = deck_import_step(import, 2)) == DeckImportStatusRunning) {
+    }
+    deck_import_close(import);
+    return status;
+}
+
+static void test_check_deck(DeckStore* store, size_t index, const char* name, DeckMeta meta) {
+    TEST_CHECK(index < deck_store_count(store));
+    if (index >= deck_store_count(store)) return;
+    if (strcmp(deck_store_get(store, index), name) != 0) {
+        printf("    deck %zu is \"%s\", expected \"%s\"\n", index, deck_store_get(store, index), name);
+        test_failures++;
+    }
+    TEST_CHECK(deck_store_get_meta(store, index) == meta);
+}
+
+// Quoted fields keep their delimiters, "" is a quote, line breaks inside
+// quotes become spaces, '|' cannot break into the metadata, a name that
+// differs only in case, '_' and blanks is a duplicate while one that only
+// shares its hash is not, and color words are read whole
+static void test_import_csv(void) {
+    DeckStore* store = deck_store_alloc();
+    DeckImportStatus status = test_import(
+        "\xEF\xBB\xBF"
+        "Deck Name,Commander,Color Identity,Bracket,Tags\r\n"
+        "\"Urza's Saga, Again\",Urza,U,4,\"artifacts,combo\"\r\n"
+        "\"The \"\"Big\"\" One\",,\"White, Blue\",Bracket 2,\r\n"
+        ",Krenko,R,,goblins\r\n"
+        "\"Two\nLines\",,g,9,\r\n"
+        "Pipe | Deck,,BR,,\r\n"
+        "\"URZA'S  SAGA,_Again\",,,,\r\n"
+        ",,,,\r\n"
+        "\r\n"
+        "Last,,C,3",
+        store);
+    TEST_CHECK(status == DeckImportStatusDone);
+    TEST_CHECK(deck_store_tag_count(store) == 3);
+    int artifacts = deck_store_tag(store, "artifacts", 9);
+    int combo = deck_store_tag(store, "combo", 5);
+    int goblins = deck_store_tag(store, "goblins", 7);
+
+    test_check_deck(store, 0, "Urza's Saga, Again", test_meta(DeckColorBlue, 4, 1U << artifacts | 1U << combo));
+    test_check_deck(store, 1, "The \"Big\" One", test_meta(DeckColorWhite | DeckColorBlue, 2, 0));
+    test_check_deck(store, 2, "Krenko", test_meta(DeckColorRed, 0, 1U << goblins));
+    test_check_deck(store, 3, "Two Lines", test_meta(DeckColorGreen, 9, 0));
+    test_check_deck(store, 4, "Pipe / Deck", test_meta(DeckColorBlack | DeckColorRed, 0, 0));
+    test_check_deck(store, 5, "Last", test_meta(0, 3, 0));
+    TEST_CHECK(deck_store_count(store) == 6);
+
+    // A semicolon file, whose commas are plain text
+    status = test_import("commander;deck\nAtraxa;Superfriends, Again\n\"Zur\";\"a;b\"\n", store);
+    TEST_CHECK(status == DeckImportStatusDone);
+    test_check_deck(store, 6, "Superfriends, Again", DECK_META_NONE);
+    test_check_deck(store, 7, "a;b", DECK_META_NONE);
+    TEST_CHECK(deck_store_count(store) == 8);
+
+    // Guild and shard names have their own colors, and other words give none
+    status = test_import(
+        "Name,Colors\nAzorius,Azorius\nGruul,GRUUL\nBoros,Boros\nEsper,\"Esper, Red\"\n"
+        "Mono,Mono Green\nLetters,wu\n",
+        store);
+    TEST_CHECK(status == DeckImportStatusDone);
+    test_check_deck(store, 8, "Azorius", test_meta(DeckColorWhite | DeckColorBlue, 0, 0));
+    test_check_deck(store, 9, "Gruul", test_meta(DeckColorRed | DeckColorGreen, 0, 0));
+    test_check_deck(store, 10, "Boros", test_meta(DeckColorRed | DeckColorWhite, 0, 0));
+    test_check_deck(
+        store, 11, "Esper", test_meta(DeckColorWhite | DeckColorBlue | DeckColorBlack | DeckColorRed, 0, 0));
+    test_check_deck(store, 12, "Mono", test_meta(DeckColorGreen, 0, 0));
+    test_check_deck(store, 13, "Letters", test_meta(DeckColorWhite | DeckColorBlue, 0, 0));
+    TEST_CHECK(deck_store_count(store) == 14);
+
+    // Pxzkmi and Wwxrmh, and Enshms and Hmmkte, share a name hash: the names
+    // decide, in the file and against the decks already in the store
+    status = test_import("Name\nDeck Pxzkmi\nDeck Wwxrmh\nDECK  wwxrmh\nDeck Enshms\n", store);
+    TEST_CHECK(status == DeckImportStatusDone);
+    test_check_deck(store, 14, "Deck Pxzkmi", DECK_META_NONE);
+    test_check_deck(store, 15, "Deck Wwxrmh", DECK_META_NONE);
+    test_check_deck(store, 16, "Deck Enshms", DECK_META_NONE);
+    status = test_import("Name\nDeck Hmmkte\ndeck_pxzkmi\n", store);
+    TEST_CHECK(status == DeckImportStatusDone);
+    test_check_deck(store, 17, "Deck Hmmkte", DECK_META_NONE);
+    TEST_CHECK(deck_store_count(store) == 18);
+
+    // Without a name or commander column nothing is imported
+    status = test_import("Colors,Bracket\nU,4\n", store);
+    TEST_CHECK(status == DeckImportStatusNoHeader);
+    TEST_CHECK(deck_store_count(store) == 18);
+    deck_store_free(store);
+}
+
+// Play log
+
+static uint32_t test_play_deck(size_t i) {
+    // An odd multiplier keeps the ids distinct and spreads them over the table
+    return (uint32_t)(i + 1) * 0x9E3779B1U;
+}
+
+// Stats survive the table doubling several times and a reopen, and no single
+// game allocates a table's worth of heap while the table grows
+static void test_play_stats(void) {
+    const size_t decks = 3100;
+    PlayLog* log = play_log_open(TEST_HISTORY_PATH, TEST_STATS_PATH, 64);
+    uint64_t most_bytes = 0;
+    for (size_t i = 0; i < decks; i++) {
+        for (size_t game = 0; game <= i % 3; game++) {
+            uint64_t before = furi_host_alloc_stats().bytes;
+            play_log_append(log, test_play_deck(i), 1000 + i, PlayResultPicked);
+            most_bytes = MAX(most_bytes, furi_host_alloc_stats().bytes - before);
+        }
+        play_log_append(log, test_play_deck(i), 1000 + i, i % 2 ? PlayResultWon : PlayResultLost);
+    }
+    // The last doubling, to 4096 slots, is a 64 KB table
+    TEST_CHECK(most_bytes < 4096);
+    play_log_close(log);
+
+    log = play_log_open(TEST_HISTORY_PATH, TEST_STATS_PATH, 64);
+    const PlayTotals* totals = play_log_totals(log);
+    TEST_CHECK(totals->decks == decks);
+    uint32_t games = 0;
+    for (size_t i = 0; i < decks; i++) {
+        PlayStats stats;
+        TEST_CHECK(play_log_get(log, test_play_deck(i), &stats));
+        TEST_CHECK(stats.plays == i % 3 + 1);
+        TEST_CHECK(stats.wins == i % 2 && stats.losses == 1 - i % 2);
+        TEST_CHECK(stats.last_played == 1000 + i);
+        games += stats.plays;
+    }
+    TEST_CHECK(totals->games == games);
+    PlayStats stats;
+    TEST_CHECK(!play_log_get(log, test_play_deck(decks), &stats));
+    play_log_close(log);
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_common_remove(storage, TEST_HISTORY_PATH);
+    storage_common_remove(storage, TEST_STATS_PATH);
+    furi_record_close(RECORD_STORAGE);
+}
+
+static const struct {
+    const char* name;
+    void (*run)(void);
+} tests[] = {
+    {"picker_weighted", test_picker_weighted},
+    {"picker_shuffle", test_picker_shuffle},
+    {"picker_shuffle_edit", test_picker_shuffle_edit},
+    {"journal_replay", test_journal_replay},
+    {"filter_select", test_filter_select},
+    {"pod_distinct", test_pod_distinct},
+    {"search_edit", test_search_edit},
+    {"import_csv", test_import_csv},
+    {"play_stats", test_play_stats},
+};
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : NULL;
+    furi_host_log_level_set('E');
+    test_fixture_alloc();
+
+    int failed = 0;
+    for (size_t i = 0; i < COUNT_OF(tests); i++) {
+        if (filter && !strstr(tests[i].name, filter)) continue;
+        int before = test_failures;
+        tests[i].run();
+        bool passed = test_failures == before;
+        printf("%-4s %s\n", passed ? "ok" : "FAIL", tests[i].name);
+        if (!passed) failed++;
+    }
+
+    test_fixture_free();
+    if (failed) printf("%d test(s) failed\n", failed);
+    return failed ? 1 : 0;
+}
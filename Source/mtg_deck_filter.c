@@ -0,0 +1,190 @@
+#include "mtg_deck_filter.h"
+
+#define DECK_FILTER_PLANES      32
+#define DECK_FILTER_WORD_BITS   32
+#define DECK_FILTER_BRACKET_BITS 4
+
+struct DeckFilter {
+    size_t count;
+    size_t words;
+    // NULL for a plane with no bit set
+    uint32_t* planes[DECK_FILTER_PLANES];
+    uint32_t* matches;
+    uint32_t* ranks;
+    size_t match_count;
+};
+
+DeckFilter* deck_filter_alloc(void) {
+    DeckFilter* filter = malloc(sizeof(DeckFilter));
+    filter->count = 0;
+    filter->words = 0;
+    memset(filter->planes, 0, sizeof(filter->planes));
+    filter->matches = NULL;
+    filter->ranks = NULL;
+    filter->match_count = 0;
+    return filter;
+}
+
+static void deck_filter_drop(DeckFilter* filter) {
+    for (size_t p = 0; p < DECK_FILTER_PLANES; p++) {
+        free(filter->planes[p]);
+        filter->planes[p] = NULL;
+    }
+    free(filter->matches);
+    free(filter->ranks);
+    filter->matches = NULL;
+    filter->ranks = NULL;
+}
+
+void deck_filter_free(DeckFilter* filter) {
+    furi_assert(filter);
+    deck_filter_drop(filter);
+    free(filter);
+}
+
+void deck_filter_reset(DeckFilter* filter, size_t count) {
+    furi_assert(filter);
+
+    deck_filter_drop(filter);
+    filter->count = count;
+    filter->words = (count + DECK_FILTER_WORD_BITS - 1) / DECK_FILTER_WORD_BITS;
+    filter->matches = malloc(MAX(filter->words, (size_t)1) * sizeof(uint32_t));
+    filter->ranks = malloc(MAX(filter->words, (size_t)1) * sizeof(uint32_t));
+    filter->match_count = 0;
+}
+
+void deck_filter_set_meta(DeckFilter* filter, size_t first, const DeckMeta* metas, size_t count) {
+    furi_assert(filter);
+    furi_assert(first + count <= filter->count);
+
+    for (size_t i = 0; i < count; i++) {
+        size_t index = first + i;
+        uint32_t word = index / DECK_FILTER_WORD_BITS;
+        uint32_t bit = 1U << (index % DECK_FILTER_WORD_BITS);
+        for (DeckMeta meta = metas[i]; meta; meta &= meta - 1) {
+            size_t p = __builtin_ctz(meta);
+            if (!filter->planes[p]) {
+                filter->planes[p] = malloc(filter->words * sizeof(uint32_t));
+                memset(filter->planes[p], 0, filter->words * sizeof(uint32_t));
+            }
+            filter->planes[p][word] |= bit;
+        }
+    }
+}
+
+static inline uint32_t deck_filter_plane(const DeckFilter* filter, size_t plane, size_t word) {
+    return filter->planes[plane] ? filter->planes[plane][word] : 0;
+}
+
+static uint32_t deck_filter_bracket_set(const DeckFilter* filter, size_t word) {
+    uint32_t set = 0;
+    for (int bit = 0; bit < DECK_FILTER_BRACKET_BITS; bit++) {
+        set |= deck_filter_plane(filter, DECK_META_BRACKET_SHIFT + bit, word);
+    }
+    return set;
+}
+
+// Decks whose bracket is at most max (unset counts as 0), compared bit-sliced
+// from the top bit down
+static uint32_t deck_filter_bracket_at_most(const DeckFilter* filter, size_t word, uint8_t max) {
+    uint32_t less = 0;
+    uint32_t equal = UINT32_MAX;
+    for (int bit = DECK_FILTER_BRACKET_BITS - 1; bit >= 0; bit--) {
+        uint32_t plane = deck_filter_plane(filter, DECK_META_BRACKET_SHIFT + bit, word);
+        if (max & (1 << bit)) {
+            less |= equal & ~plane;
+            equal &= plane;
+        } else {
+            equal &= ~plane;
+        }
+    }
+    return less | equal;
+}
+
+static uint32_t deck_filter_bracket_equal(const DeckFilter* filter, size_t word, uint8_t bracket) {
+    uint32_t equal = UINT32_MAX;
+    for (int bit = 0; bit < DECK_FILTER_BRACKET_BITS; bit++) {
+        uint32_t plane = deck_filter_plane(filter, DECK_META_BRACKET_SHIFT + bit, word);
+        equal &= (bracket & (1 << bit)) ? plane : ~plane;
+    }
+    return equal;
+}
+
+size_t deck_filter_apply(DeckFilter* filter, const DeckFilterRule* rule) {
+    furi_assert(filter);
+    furi_assert(rule);
+
+    size_t total = 0;
+    for (size_t w = 0; w < filter->words; w++) {
+        uint32_t match = UINT32_MAX;
+        size_t tail = filter->count - w * DECK_FILTER_WORD_BITS;
+        if (tail < DECK_FILTER_WORD_BITS) match = (1U << tail) - 1;
+
+        if (rule->without_colors || rule->with_colors) {
+            match &= deck_filter_plane(filter, __builtin_ctz(DECK_META_COLORS_KNOWN), w);
+        }
+        for (size_t c = 0; c < DECK_COLOR_COUNT; c++) {
+            if (rule->without_colors & (1 << c)) match &= ~deck_filter_plane(filter, c, w);
+            if (rule->with_colors & (1 << c)) match &= deck_filter_plane(filter, c, w);
+        }
+        // Either bracket limit leaves out decks without a bracket
+        if (rule->bracket_min || rule->bracket_max) match &= deck_filter_bracket_set(filter, w);
+        if (rule->bracket_min) match &= ~deck_filter_bracket_at_most(filter, w, rule->bracket_min - 1);
+        if (rule->bracket_max) match &= deck_filter_bracket_at_most(filter, w, rule->bracket_max);
+        if (rule->tag >= 0) match &= deck_filter_plane(filter, DECK_META_TAGS_SHIFT + rule->tag, w);
+
+        filter->matches[w] = match;
+        filter->ranks[w] = total;
+        total += __builtin_popcount(match);
+    }
+    filter->match_count = total;
+    return total;
+}
+
+size_t deck_filter_count(const DeckFilter* filter) {
+    furi_assert(filter);
+    return filter->match_count;
+}
+
+bool deck_filter_matches(const DeckFilter* filter, size_t index) {
+    furi_assert(filter);
+    furi_assert(index < filter->count);
+    return (filter->matches[index / DECK_FILTER_WORD_BITS] >> (index % DECK_FILTER_WORD_BITS)) & 1;
+}
+
+size_t deck_filter_select(const DeckFilter* filter, size_t nth) {
+    furi_assert(filter);
+    furi_assert(nth < filter->match_count);
+
+    // Last word whose running count is still at or below nth
+    size_t low = 0;
+    size_t high = filter->words - 1;
+    while (low < high) {
+        size_t middle = (low + high + 1) / 2;
+        if (filter->ranks[middle] <= nth) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    uint32_t word = filter->matches[low];
+    for (size_t skip = nth - filter->ranks[low]; skip > 0; skip--) {
+        word &= word - 1;
+    }
+    return low * DECK_FILTER_WORD_BITS + __builtin_ctz(word);
+}
+
+void deck_filter_bracket_counts(const DeckFilter* filter, uint32_t counts[DECK_META_BRACKET_MAX + 1]) {
+    furi_assert(filter);
+    furi_assert(counts);
+
+    memset(counts, 0, (DECK_META_BRACKET_MAX + 1) * sizeof(uint32_t));
+    for (size_t w = 0; w < filter->words; w++) {
+        uint32_t match = filter->matches[w];
+        if (!match) continue;
+        for (uint8_t bracket = 0; bracket <= DECK_META_BRACKET_MAX; bracket++) {
+            counts[bracket] += __builtin_popcount(match & deck_filter_bracket_equal(filter, w, bracket));
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <furi.h>
+
+#include "mtg_deck_meta.h"
+
+/* Deck filtering over bitplanes
+ *
+ * Plane p holds bit p of every deck's DeckMeta, 32 decks to a word, so a rule
+ * is evaluated a word at a time: colors and tags are single plane tests and
+ * the bracket limit is a bit-sliced comparison over its four planes. Planes
+ * no deck uses are never allocated.
+ *
+ * Applying a rule leaves a bitset of matching decks and the running count of
+ * matches before each word; picking the n-th match is then a binary search
+ * over those counts and a bit select, with no list of matches built.
+ */
+
+typedef struct {
+    // Decks with any of these colors are left out
+    uint8_t without_colors;
+    // Decks must have all of these colors
+    uint8_t with_colors;
+    // Lowest bracket allowed, 0 for any
+    uint8_t bracket_min;
+    // Highest bracket allowed, 0 for any
+    uint8_t bracket_max;
+    // Tag id decks must carry, -1 for any
+    int8_t tag;
+} DeckFilterRule;
+
+#define DECK_FILTER_RULE_ANY ((DeckFilterRule){.without_colors = 0, .with_colors = 0, .bracket_min = 0, .bracket_max = 0, .tag = -1})
+
+static inline bool deck_filter_rule_active(const DeckFilterRule* rule) {
+    return rule->without_colors || rule->with_colors || rule->bracket_min || rule->bracket_max || rule->tag >= 0;
+}
+
+typedef struct DeckFilter DeckFilter;
+
+DeckFilter* deck_filter_alloc(void);
+
+void deck_filter_free(DeckFilter* filter);
+
+/** Start over for a list of count decks, all without metadata */
+void deck_filter_reset(DeckFilter* filter, size_t count);
+
+/** Load the metadata of count decks starting at first */
+void deck_filter_set_meta(DeckFilter* filter, size_t first, const DeckMeta* metas, size_t count);
+
+/** Evaluate a rule over the whole list
+ *
+ * @return number of matching decks
+ */
+size_t deck_filter_apply(DeckFilter* filter, const DeckFilterRule* rule);
+
+/** Matches found by the last deck_filter_apply */
+size_t deck_filter_count(const DeckFilter* filter);
+
+bool deck_filter_matches(const DeckFilter* filter, size_t index);
+
+/** Position of the nth matching deck, nth < deck_filter_count */
+size_t deck_filter_select(const DeckFilter* filter, size_t nth);
+
+/** Count the matches found by the last deck_filter_apply in each bracket
+ *
+ * @param counts  indexed by bracket; counts[0] holds decks without one
+ */
+void deck_filter_bracket_counts(const DeckFilter* filter, uint32_t counts[DECK_META_BRACKET_MAX + 1]);
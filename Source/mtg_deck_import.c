@@ -0,0 +1,628 @@
+#include "mtg_deck_import.h"
+#include "mtg_storage_helpers.h"
+
+#include <stdio.h>
+
+#define DECK_IMPORT_EXTENSION   ".csv"
+#define DECK_IMPORT_DONE_SUFFIX ".done"
+#define DECK_IMPORT_BLOCK_SIZE  512
+// Longest field kept, terminator included; anything past it is dropped
+#define DECK_IMPORT_FIELD_SIZE  128
+// Longest header cell that can still name a field
+#define DECK_IMPORT_HEADER_SIZE 24
+#define DECK_IMPORT_HASHES_MIN  64
+
+typedef enum {
+    DeckImportFieldName,
+    DeckImportFieldCommander,
+    DeckImportFieldColors,
+    DeckImportFieldBracket,
+    DeckImportFieldTags,
+    DeckImportFieldCount,
+    DeckImportFieldNone = DeckImportFieldCount,
+} DeckImportField;
+
+typedef enum {
+    DeckImportCsvFieldStart,
+    DeckImportCsvUnquoted,
+    DeckImportCsvQuoted,
+    // A quote inside a quoted field: "" for a quote, the end of it otherwise
+    DeckImportCsvQuote,
+} DeckImportCsvState;
+
+typedef struct {
+    const char* name;
+    DeckImportField field;
+} DeckImportColumnName;
+
+static const DeckImportColumnName deck_import_columns[] = {
+    {"name", DeckImportFieldName},
+    {"deck", DeckImportFieldName},
+    {"deck name", DeckImportFieldName},
+    {"deckname", DeckImportFieldName},
+    {"title", DeckImportFieldName},
+    {"commander", DeckImportFieldCommander},
+    {"commanders", DeckImportFieldCommander},
+    {"colors", DeckImportFieldColors},
+    {"color", DeckImportFieldColors},
+    {"colours", DeckImportFieldColors},
+    {"colour", DeckImportFieldColors},
+    {"color identity", DeckImportFieldColors},
+    {"colour identity", DeckImportFieldColors},
+    {"identity", DeckImportFieldColors},
+    {"ci", DeckImportFieldColors},
+    {"bracket", DeckImportFieldBracket},
+    {"power", DeckImportFieldBracket},
+    {"tags", DeckImportFieldTags},
+    {"tag", DeckImportFieldTags},
+    {"archetype", DeckImportFieldTags},
+};
+
+typedef struct {
+    const char* word;
+    const char* letters;
+} DeckImportColorWord;
+
+static const DeckImportColorWord deck_import_color_words[] = {
+    {"white", "W"},
+    {"blue", "U"},
+    {"black", "B"},
+    {"red", "R"},
+    {"green", "G"},
+    {"colorless", "C"},
+    {"colourless", "C"},
+    // Guilds
+    {"azorius", "WU"},
+    {"dimir", "UB"},
+    {"rakdos", "BR"},
+    {"gruul", "RG"},
+    {"selesnya", "GW"},
+    {"orzhov", "WB"},
+    {"izzet", "UR"},
+    {"golgari", "BG"},
+    {"boros", "RW"},
+    {"simic", "GU"},
+    // Shards
+    {"bant", "GWU"},
+    {"esper", "WUB"},
+    {"grixis", "UBR"},
+    {"jund", "BRG"},
+    {"naya", "RGW"},
+    // Wedges
+    {"abzan", "WBG"},
+    {"jeskai", "URW"},
+    {"sultai", "BGU"},
+    {"mardu", "RWB"},
+    {"temur", "GUR"},
+};
+
+struct DeckImport {
+    Storage* storage;
+    File* file;
+    DeckStore* store;
+    char path[DECK_IMPORT_PATH_SIZE];
+    DeckImportStatus status;
+    DeckImportProgress progress;
+
+    uint8_t block[DECK_IMPORT_BLOCK_SIZE];
+    size_t block_length;
+    size_t block_next;
+
+    DeckImportCsvState state;
+    // 0 until the header row shows which one the file uses
+    char delimiter;
+    bool header_done;
+    // Anything seen since the last row ended, so blank lines can be passed over
+    bool row_started;
+    size_t column;
+    uint8_t columns[DECK_IMPORT_COLUMNS_MAX];
+    char header[DECK_IMPORT_HEADER_SIZE];
+    size_t header_length;
+    char fields[DeckImportFieldCount][DECK_IMPORT_FIELD_SIZE];
+    size_t field_lengths[DeckImportFieldCount];
+
+    // Open addressing over normalized name hashes, 0 marking a free slot, with
+    // the store index of each name so a collision is told from a duplicate
+    uint32_t* hashes;
+    uint16_t* hash_decks;
+    size_t hash_count;
+    size_t hash_capacity;
+};
+
+static char deck_import_lower(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+    return c;
+}
+
+static bool deck_import_is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+typedef struct {
+    const char* name;
+    size_t length;
+    size_t i;
+    bool any;
+} DeckImportNameReader;
+
+// Next character of the name case folded as in search, '_' as a space, blanks
+// collapsed and trimmed; '\0' at its end
+static char deck_import_name_next(DeckImportNameReader* reader) {
+    bool blank = false;
+    while (reader->i < reader->length) {
+        char c = deck_import_lower(reader->name[reader->i]);
+        if (c == '_' || deck_import_is_blank(c)) {
+            blank = reader->any;
+            reader->i++;
+            continue;
+        }
+        // The blank goes out first; c is read again on the next call
+        if (blank) return ' ';
+        reader->i++;
+        reader->any = true;
+        return c;
+    }
+    return '\0';
+}
+
+static uint32_t deck_import_name_hash(const char* name, size_t length) {
+    DeckImportNameReader reader = {name, length, 0, false};
+    uint32_t hash = MTG_CHECKSUM_SEED;
+    char c;
+    while ((c = deck_import_name_next(&reader)) != '\0') hash = mtg_checksum(hash, &c, 1);
+    return hash ? hash : 1;
+}
+
+static bool deck_import_names_match(const char* a, size_t a_length, const char* b, size_t b_length) {
+    DeckImportNameReader reader_a = {a, a_length, 0, false};
+    DeckImportNameReader reader_b = {b, b_length, 0, false};
+    char c;
+    do {
+        c = deck_import_name_next(&reader_a);
+        if (c != deck_import_name_next(&reader_b)) return false;
+    } while (c != '\0');
+    return true;
+}
+
+static void deck_import_hash_insert(DeckImport* import, uint32_t hash, size_t deck);
+
+static void deck_import_hash_grow(DeckImport* import, size_t capacity) {
+    uint32_t* old = import->hashes;
+    uint16_t* old_decks = import->hash_decks;
+    size_t old_capacity = import->hash_capacity;
+    import->hashes = malloc(capacity * sizeof(uint32_t));
+    memset(import->hashes, 0, capacity * sizeof(uint32_t));
+    import->hash_decks = malloc(capacity * sizeof(uint16_t));
+    import->hash_capacity = capacity;
+    import->hash_count = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i]) deck_import_hash_insert(import, old[i], old_decks[i]);
+    }
+    free(old);
+    free(old_decks);
+}
+
+// Kept at most half full, so a probe ends at a free slot soon
+static void deck_import_hash_insert(DeckImport* import, uint32_t hash, size_t deck) {
+    furi_assert(deck <= UINT16_MAX);
+    if ((import->hash_count + 1) * 2 > import->hash_capacity) {
+        deck_import_hash_grow(import, import->hash_capacity * 2);
+    }
+    size_t mask = import->hash_capacity - 1;
+    size_t slot = hash & mask;
+    while (import->hashes[slot] != 0) slot = (slot + 1) & mask;
+    import->hashes[slot] = hash;
+    import->hash_decks[slot] = deck;
+    import->hash_count++;
+}
+
+// Whether a deck with the same normalized name is in the store; equal hashes
+// alone could be two different names
+static bool deck_import_hash_contains(const DeckImport* import, uint32_t hash, const char* name, size_t length) {
+    size_t mask = import->hash_capacity - 1;
+    for (size_t slot = hash & mask; import->hashes[slot] != 0; slot = (slot + 1) & mask) {
+        if (import->hashes[slot] != hash) continue;
+        size_t deck = import->hash_decks[slot];
+        if (deck_import_names_match(
+               deck_store_get(import->store, deck), deck_store_get_length(import->store, deck), name, length)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool deck_import_find(const char* folder, char* path, size_t size) {
+    furi_assert(folder);
+    furi_assert(path);
+
+    bool found = false;
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* dir = storage_file_alloc(storage);
+    if (storage_dir_open(dir, folder)) {
+        FileInfo info;
+        char name[DECK_IMPORT_PATH_SIZE];
+        while (!found && storage_dir_read(dir, &info, name, sizeof(name))) {
+            if (info.flags & FSF_DIRECTORY) continue;
+            size_t length = strlen(name);
+            size_t extension = sizeof(DECK_IMPORT_EXTENSION) - 1;
+            if (length <= extension) continue;
+            bool matches = true;
+            for (size_t i = 0; i < extension; i++) {
+                if (deck_import_lower(name[length - extension + i]) != DECK_IMPORT_EXTENSION[i]) matches = false;
+            }
+            int written = snprintf(path, size, "%s/%s", folder, name);
+            found = matches && written > 0 && (size_t)written < size;
+        }
+    }
+    storage_dir_close(dir);
+    storage_file_free(dir);
+    furi_record_close(RECORD_STORAGE);
+    return found;
+}
+
+DeckImport* deck_import_open(const char* path, DeckStore* store) {
+    furi_assert(path);
+    furi_assert(store);
+
+    DeckImport* import = malloc(sizeof(DeckImport));
+    memset(import, 0, sizeof(DeckImport));
+    import->storage = furi_record_open(RECORD_STORAGE);
+    import->file = storage_file_alloc(import->storage);
+    import->store = store;
+    strncpy(import->path, path, sizeof(import->path) - 1);
+    import->status = DeckImportStatusRunning;
+
+    // Seeded with the decks already there, so re-importing an export adds nothing
+    size_t count = deck_store_count(store);
+    size_t capacity = DECK_IMPORT_HASHES_MIN;
+    while (capacity < (count + 1) * 2) capacity *= 2;
+    deck_import_hash_grow(import, capacity);
+    for (size_t i = 0; i < count; i++) {
+        deck_import_hash_insert(
+            import, deck_import_name_hash(deck_store_get(store, i), deck_store_get_length(store, i)), i);
+    }
+
+    if (!storage_file_open(import->file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        FURI_LOG_E("MTG", "Failed to open import %s", path);
+        import->status = DeckImportStatusNoFile;
+    } else {
+        import->progress.file_size = storage_file_size(import->file);
+    }
+    return import;
+}
+
+static void deck_import_column_map(DeckImport* import) {
+    if (import->column >= DECK_IMPORT_COLUMNS_MAX) return;
+
+    const char* start = import->header;
+    const char* end = import->header + import->header_length;
+    while (start < end && deck_import_is_blank(*start)) start++;
+    while (end > start && deck_import_is_blank(end[-1])) end--;
+
+    import->columns[import->column] = DeckImportFieldNone;
+    for (size_t i = 0; i < COUNT_OF(deck_import_columns); i++) {
+        const char* name = deck_import_columns[i].name;
+        size_t length = strlen(name);
+        if ((size_t)(end - start) != length) continue;
+        bool matches = true;
+        for (size_t j = 0; j < length; j++) {
+            if (deck_import_lower(start[j]) != name[j]) matches = false;
+        }
+        if (matches) {
+            import->columns[import->column] = deck_import_columns[i].field;
+            break;
+        }
+    }
+}
+
+static DeckImportField deck_import_column_field(const DeckImport* import) {
+    if (import->column >= DECK_IMPORT_COLUMNS_MAX) return DeckImportFieldNone;
+    return import->columns[import->column];
+}
+
+static void deck_import_put(DeckImport* import, char c) {
+    import->row_started = true;
+    if (!import->header_done) {
+        if (import->header_length < DECK_IMPORT_HEADER_SIZE - 1) import->header[import->header_length++] = c;
+        return;
+    }
+    DeckImportField field = deck_import_column_field(import);
+    if (field == DeckImportFieldNone) return;
+    size_t* length = &import->field_lengths[field];
+    if (*length < DECK_IMPORT_FIELD_SIZE - 1) import->fields[field][(*length)++] = c;
+}
+
+static void deck_import_field_end(DeckImport* import) {
+    if (!import->header_done) {
+        deck_import_column_map(import);
+        import->header_length = 0;
+    }
+    import->column++;
+    import->state = DeckImportCsvFieldStart;
+}
+
+// Copy a field with '|' and control characters replaced, blanks trimmed
+static size_t deck_import_clean(const DeckImport* import, DeckImportField field, char* out, size_t size) {
+    const char* text = import->fields[field];
+    size_t length = import->field_lengths[field];
+    size_t start = 0;
+    while (start < length && (deck_import_is_blank(text[start]) || (uint8_t)text[start] < 0x20)) start++;
+
+    size_t used = 0;
+    for (size_t i = start; i < length && used < size - 1; i++) {
+        char c = text[i];
+        if (c == '|') c = '/';
+        if ((uint8_t)c < 0x20 || c == 0x7F) c = ' ';
+        out[used++] = c;
+    }
+    while (used > 0 && deck_import_is_blank(out[used - 1])) used--;
+    out[used] = '\0';
+    return used;
+}
+
+// Color letters, or words like "White, Blue" or "Azorius", as WUBRG letters.
+// A word that is neither a known name nor made of color letters alone is
+// skipped, so "Boros" cannot read as its B and R
+static size_t deck_import_colors(const DeckImport* import, char* out, size_t size) {
+    const char* text = import->fields[DeckImportFieldColors];
+    size_t length = import->field_lengths[DeckImportFieldColors];
+    size_t used = 0;
+    size_t i = 0;
+    while (i < length) {
+        char c = deck_import_lower(text[i]);
+        if (c < 'a' || c > 'z') {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < length && deck_import_lower(text[i]) >= 'a' && deck_import_lower(text[i]) <= 'z') i++;
+        size_t word = i - start;
+
+        const char* letters = NULL;
+        for (size_t w = 0; w < COUNT_OF(deck_import_color_words) && !letters; w++) {
+            const char* name = deck_import_color_words[w].word;
+            if (strlen(name) != word) continue;
+            bool matches = true;
+            for (size_t j = 0; j < word; j++) {
+                if (deck_import_lower(text[start + j]) != name[j]) matches = false;
+            }
+            if (matches) letters = deck_import_color_words[w].letters;
+        }
+        if (letters) {
+            for (; *letters && used < size - 1; letters++) out[used++] = *letters;
+            continue;
+        }
+
+        bool all_letters = true;
+        for (size_t j = start; j < i; j++) {
+            if (!strchr(DECK_COLOR_NAMES "C", text[j] & ~0x20)) all_letters = false;
+        }
+        for (size_t j = start; all_letters && j < i && used < size - 1; j++) {
+            out[used++] = text[j] & ~0x20;
+        }
+    }
+    out[used] = '\0';
+    return used;
+}
+
+// The first number in the field, left out when it is no bracket
+static size_t deck_import_bracket(const DeckImport* import, char* out, size_t size) {
+    const char* text = import->fields[DeckImportFieldBracket];
+    size_t length = import->field_lengths[DeckImportFieldBracket];
+    size_t i = 0;
+    while (i < length && (text[i] < '0' || text[i] > '9')) i++;
+    uint32_t bracket = 0;
+    while (i < length && text[i] >= '0' && text[i] <= '9' && bracket <= DECK_META_BRACKET_MAX) {
+        bracket = bracket * 10 + (text[i++] - '0');
+    }
+    if (bracket == 0 || bracket > DECK_META_BRACKET_MAX) return 0;
+    int written = snprintf(out, size, "%lu", (unsigned long)bracket);
+    return written > 0 ? (size_t)written : 0;
+}
+
+static void deck_import_row(DeckImport* import) {
+    import->progress.rows++;
+
+    char line[DECK_IMPORT_NAME_SIZE + DECK_IMPORT_FIELD_SIZE * 2];
+    size_t used = deck_import_clean(import, DeckImportFieldName, line, DECK_IMPORT_NAME_SIZE);
+    if (used == 0) used = deck_import_clean(import, DeckImportFieldCommander, line, DECK_IMPORT_NAME_SIZE);
+    if (used == 0) {
+        import->progress.skipped++;
+        return;
+    }
+    uint32_t hash = deck_import_name_hash(line, used);
+    if (deck_import_hash_contains(import, hash, line, used)) {
+        import->progress.duplicates++;
+        return;
+    }
+
+    // Put back together as a deck list line so the metadata is read as on load
+    line[used++] = '|';
+    used += deck_import_colors(import, line + used, 16);
+    line[used++] = '|';
+    used += deck_import_bracket(import, line + used, 4);
+    line[used++] = '|';
+    used += deck_import_clean(import, DeckImportFieldTags, line + used, sizeof(line) - used);
+
+    DeckMeta meta;
+    size_t name_length = deck_meta_parse(import->store, line, used, &meta);
+    if (!deck_store_add(import->store, line, name_length)) {
+        FURI_LOG_W("MTG", "Deck store full, import stopped");
+        import->status = DeckImportStatusFull;
+        return;
+    }
+    size_t deck = deck_store_count(import->store) - 1;
+    deck_store_set_meta(import->store, deck, meta);
+    deck_import_hash_insert(import, hash, deck);
+    import->progress.added++;
+}
+
+static void deck_import_row_end(DeckImport* import) {
+    // A blank line ends no row
+    if (import->column == 0 && !import->row_started) return;
+    deck_import_field_end(import);
+
+    if (!import->header_done) {
+        import->header_done = true;
+        bool named = false;
+        for (size_t i = 0; i < MIN(import->column, (size_t)DECK_IMPORT_COLUMNS_MAX); i++) {
+            if (import->columns[i] == DeckImportFieldName || import->columns[i] == DeckImportFieldCommander) {
+                named = true;
+            }
+        }
+        if (!named) {
+            FURI_LOG_E("MTG", "Import has no name or commander column");
+            import->status = DeckImportStatusNoHeader;
+        }
+        // A header without any delimiter is a single column
+        if (!import->delimiter) import->delimiter = ',';
+    } else {
+        deck_import_row(import);
+    }
+
+    import->column = 0;
+    import->row_started = false;
+    memset(import->field_lengths, 0, sizeof(import->field_lengths));
+}
+
+static bool deck_import_is_delimiter(DeckImport* import, char c) {
+    if (import->delimiter) return c == import->delimiter;
+    if (c == ',' || c == ';' || c == '\t') {
+        import->delimiter = c;
+        return true;
+    }
+    return false;
+}
+
+// Feed one byte to the CSV parser
+//
+// @return true if it ended a row
+static bool deck_import_char(DeckImport* import, char c) {
+    switch (import->state) {
+        case DeckImportCsvQuoted:
+            if (c == '"') {
+                import->state = DeckImportCsvQuote;
+            } else {
+                deck_import_put(import, c);
+            }
+            return false;
+        case DeckImportCsvQuote:
+            if (c == '"') {
+                deck_import_put(import, c);
+                import->state = DeckImportCsvQuoted;
+                return false;
+            }
+            break;
+        case DeckImportCsvFieldStart:
+            if (c == '"') {
+                import->row_started = true;
+                import->state = DeckImportCsvQuoted;
+                return false;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (c == '\r') return false;
+    if (c == '\n') {
+        bool started = import->column > 0 || import->row_started;
+        deck_import_row_end(import);
+        return started;
+    }
+    if (deck_import_is_delimiter(import, c)) {
+        import->row_started = true;
+        deck_import_field_end(import);
+        return false;
+    }
+    // Text after a closing quote is kept, as most spreadsheets do
+    deck_import_put(import, c);
+    import->state = DeckImportCsvUnquoted;
+    return false;
+}
+
+static bool deck_import_fill(DeckImport* import) {
+    bool first = import->progress.bytes_read == 0;
+    import->block_length = mtg_file_read(import->file, import->block, DECK_IMPORT_BLOCK_SIZE);
+    import->block_next = 0;
+    import->progress.bytes_read += import->block_length;
+    if (import->block_length == 0) return false;
+
+    static const uint8_t bom[] = {0xEF, 0xBB, 0xBF};
+    if (first && import->block_length >= sizeof(bom) && memcmp(import->block, bom, sizeof(bom)) == 0) {
+        import->block_next = sizeof(bom);
+    }
+    return true;
+}
+
+DeckImportStatus deck_import_step(DeckImport* import, size_t rows) {
+    furi_assert(import);
+
+    // Bounded in bytes too, for a row that never ends
+    size_t budget = MAX(rows, (size_t)1) * DECK_IMPORT_BLOCK_SIZE;
+    size_t done = 0;
+    while (import->status == DeckImportStatusRunning && done < rows && budget > 0) {
+        if (import->block_next == import->block_length && !deck_import_fill(import)) {
+            if (storage_file_get_error(import->file) != FSE_OK) {
+                FURI_LOG_E("MTG", "Failed to read import %s", import->path);
+                import->status = DeckImportStatusReadError;
+                break;
+            }
+            // The last row needs no line break
+            if (import->state == DeckImportCsvQuoted) import->state = DeckImportCsvQuote;
+            deck_import_char(import, '\n');
+            if (import->status == DeckImportStatusRunning) import->status = DeckImportStatusDone;
+            break;
+        }
+        budget--;
+        if (deck_import_char(import, (char)import->block[import->block_next++])) done++;
+    }
+    return import->status;
+}
+
+DeckImportStatus deck_import_status(const DeckImport* import) {
+    furi_assert(import);
+    return import->status;
+}
+
+const DeckImportProgress* deck_import_progress(const DeckImport* import) {
+    furi_assert(import);
+    return &import->progress;
+}
+
+void deck_import_close(DeckImport* import) {
+    furi_assert(import);
+
+    storage_file_close(import->file);
+    storage_file_free(import->file);
+    if (import->status == DeckImportStatusDone) {
+        char done[DECK_IMPORT_PATH_SIZE + sizeof(DECK_IMPORT_DONE_SUFFIX)];
+        snprintf(done, sizeof(done), "%s" DECK_IMPORT_DONE_SUFFIX, import->path);
+        // An earlier import of the same name is replaced
+        if (storage_common_rename(import->storage, import->path, done) != FSE_OK) {
+            FURI_LOG_W("MTG", "Failed to mark %s imported", import->path);
+        }
+    }
+    furi_record_close(RECORD_STORAGE);
+    free(import->hashes);
+    free(import->hash_decks);
+    free(import);
+}
+
+const char* deck_import_status_text(DeckImportStatus status) {
+    switch (status) {
+        case DeckImportStatusRunning:
+            return "Importing";
+        case DeckImportStatusDone:
+            return "Done";
+        case DeckImportStatusNoFile:
+            return "No CSV in import/";
+        case DeckImportStatusNoHeader:
+            return "No name column";
+        case DeckImportStatusReadError:
+            return "Read error";
+        case DeckImportStatusFull:
+            return "Deck list full";
+    }
+    return "";
+}
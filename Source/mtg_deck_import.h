@@ -0,0 +1,90 @@
+#pragma once
+
+#include <furi.h>
+
+#include "mtg_deck_store.h"
+
+/* Bulk import of decks from deck-builder CSV exports
+ *
+ *   Deck Name,Commander,Colors,Bracket,Tags
+ *   "Urza's Saga, Again",Urza,U,4,"artifacts,combo"
+ *
+ * The first row maps columns to fields by name, in any case and order:
+ *
+ *   name       name, deck, deck name, title
+ *   commander  commander, commanders; stands in for an empty name
+ *   colors     colors, color identity, identity, ci; WUBRG letters, color
+ *              words or guild, shard and wedge names, anything else ignored
+ *   bracket    bracket, power; the first number in the field
+ *   tags       tags, tag, archetype; comma separated
+ *
+ * Other columns are skipped. Fields may be quoted, with "" for a quote and
+ * commas or line breaks inside; the delimiter is whichever of , ; or tab
+ * the header row uses first, and a UTF-8 byte order mark is skipped.
+ *
+ * The file is streamed a block at a time into fixed row buffers, so memory
+ * does not grow with the file: long fields are cut at their buffer and
+ * columns past DECK_IMPORT_COLUMNS_MAX are ignored. Decks go straight into
+ * the store; a deck whose normalized name (case folded, '_' as a space,
+ * blanks collapsed) matches one already there or imported before it is
+ * counted as a duplicate and left out. Names are looked up by hash and
+ * compared in the store on a match; the hash set costs a word and a store
+ * index per slot and is the only part that grows, with the store rather
+ * than the file.
+ *
+ * Nothing is written here; the caller saves the store once at the end.
+ */
+
+#define DECK_IMPORT_COLUMNS_MAX 32
+// Longest name kept, terminator included, as on the on-screen keyboard
+#define DECK_IMPORT_NAME_SIZE 48
+#define DECK_IMPORT_PATH_SIZE 96
+
+typedef enum {
+    DeckImportStatusRunning,
+    DeckImportStatusDone,
+    DeckImportStatusNoFile,
+    // The first row names neither a name nor a commander column
+    DeckImportStatusNoHeader,
+    DeckImportStatusReadError,
+    // The store ran out of room; decks added until then are kept
+    DeckImportStatusFull,
+} DeckImportStatus;
+
+typedef struct {
+    uint32_t rows;
+    uint32_t added;
+    uint32_t duplicates;
+    // Rows without a name or commander
+    uint32_t skipped;
+    uint32_t bytes_read;
+    uint32_t file_size;
+} DeckImportProgress;
+
+typedef struct DeckImport DeckImport;
+
+/** Find the first .csv file in folder
+ *
+ * @return false if there is none
+ */
+bool deck_import_find(const char* folder, char* path, size_t size);
+
+/** Start importing path into store; the store must stay alive until close */
+DeckImport* deck_import_open(const char* path, DeckStore* store);
+
+/** Import up to rows more rows
+ *
+ * @return DeckImportStatusRunning while there is more to do
+ */
+DeckImportStatus deck_import_step(DeckImport* import, size_t rows);
+
+DeckImportStatus deck_import_status(const DeckImport* import);
+
+const DeckImportProgress* deck_import_progress(const DeckImport* import);
+
+/** Stop, renaming the file to .done if it was imported to the end so it is
+ * not picked up again
+ */
+void deck_import_close(DeckImport* import);
+
+const char* deck_import_status_text(DeckImportStatus status);
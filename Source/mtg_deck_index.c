@@ -0,0 +1,287 @@
+#include "mtg_deck_index.h"
+#include "mtg_deck_search.h"
+#include "mtg_line_reader.h"
+#include "mtg_storage_helpers.h"
+
+#define DECK_INDEX_BLOCK_SIZE 512
+
+struct DeckIndex {
+    Storage* storage;
+    File* file;
+    DeckIndexHeader header;
+};
+
+typedef struct {
+    BlockWriter* writer;
+    uint32_t checksum;
+} DeckIndexWriter;
+
+static uint32_t deck_index_table_offset(const DeckIndex* index) {
+    return index->header.header_size;
+}
+
+static uint32_t deck_index_names_offset(const DeckIndex* index) {
+    return index->header.header_size + index->header.deck_count * sizeof(DeckIndexEntry);
+}
+
+static uint32_t deck_index_tags_offset(const DeckIndex* index) {
+    return deck_index_names_offset(index) + index->header.names_size;
+}
+
+static uint32_t deck_index_order_offset(const DeckIndex* index) {
+    return deck_index_tags_offset(index) + index->header.tag_count * DECK_META_TAG_SIZE;
+}
+
+static uint32_t deck_index_end_offset(const DeckIndex* index) {
+    return deck_index_order_offset(index) + index->header.deck_count * sizeof(uint16_t);
+}
+
+DeckIndex* deck_index_open(const char* index_path, const char* source_path) {
+    DeckIndex* index = malloc(sizeof(DeckIndex));
+    index->storage = furi_record_open(RECORD_STORAGE);
+    index->file = storage_file_alloc(index->storage);
+
+    bool valid = false;
+    do {
+        FileStamp stamp;
+        if (!file_stamp_get(index->storage, source_path, &stamp)) break;
+        if (!storage_file_open(index->file, index_path, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+
+        DeckIndexHeader* header = &index->header;
+        if (mtg_file_read(index->file, header, sizeof(DeckIndexHeader)) != sizeof(DeckIndexHeader)) break;
+        if (header->magic != DECK_INDEX_MAGIC || header->version != DECK_INDEX_VERSION ||
+           header->header_size < sizeof(DeckIndexHeader)) {
+            FURI_LOG_W("MTG", "Ignoring index with unknown format");
+            break;
+        }
+        if (header->source_size != stamp.size || header->source_mtime != stamp.mtime) {
+            FURI_LOG_I("MTG", "Index is stale, deck list changed");
+            break;
+        }
+
+        if (header->tag_count > DECK_META_TAGS_MAX || header->deck_count > DECK_STORE_ENTRIES_MAX ||
+           storage_file_size(index->file) != deck_index_end_offset(index)) {
+            FURI_LOG_W("MTG", "Ignoring truncated index");
+            break;
+        }
+        valid = true;
+    } while (false);
+
+    if (!valid) {
+        deck_index_close(index);
+        return NULL;
+    }
+    return index;
+}
+
+void deck_index_close(DeckIndex* index) {
+    furi_assert(index);
+    storage_file_close(index->file);
+    storage_file_free(index->file);
+    furi_record_close(RECORD_STORAGE);
+    free(index);
+}
+
+uint32_t deck_index_count(const DeckIndex* index) {
+    furi_assert(index);
+    return index->header.deck_count;
+}
+
+bool deck_index_read_name(DeckIndex* index, uint32_t position, char* name, size_t size) {
+    furi_assert(index);
+    furi_assert(position < index->header.deck_count);
+    furi_assert(size > 0);
+
+    DeckIndexEntry entry;
+    uint32_t entry_offset = deck_index_table_offset(index) + position * sizeof(DeckIndexEntry);
+    if (!storage_file_seek(index->file, entry_offset, true)) return false;
+    if (mtg_file_read(index->file, &entry, sizeof(entry)) != sizeof(entry)) return false;
+
+    size_t length = MIN((size_t)entry.length, size - 1);
+    if (!storage_file_seek(index->file, deck_index_names_offset(index) + entry.offset, true)) return false;
+    if (mtg_file_read(index->file, name, length) != length) return false;
+    name[length] = '\0';
+    return true;
+}
+
+bool deck_index_read_meta(DeckIndex* index, uint32_t first, DeckMeta* metas, size_t count) {
+    furi_assert(index);
+    furi_assert(first + count <= index->header.deck_count);
+
+    if (!storage_file_seek(index->file, deck_index_table_offset(index) + first * sizeof(DeckIndexEntry), true)) {
+        return false;
+    }
+    DeckIndexEntry entries[DECK_INDEX_BLOCK_SIZE / sizeof(DeckIndexEntry)];
+    while (count > 0) {
+        size_t chunk = MIN(count, COUNT_OF(entries));
+        size_t size = chunk * sizeof(DeckIndexEntry);
+        if (mtg_file_read(index->file, entries, size) != size) return false;
+        for (size_t i = 0; i < chunk; i++) {
+            *metas++ = entries[i].meta;
+        }
+        count -= chunk;
+    }
+    return true;
+}
+
+bool deck_index_load_tags(DeckIndex* index, DeckStore* store) {
+    furi_assert(index);
+    furi_assert(store);
+    furi_assert(deck_store_tag_count(store) == 0);
+
+    if (index->header.tag_count == 0) return true;
+    if (!storage_file_seek(index->file, deck_index_tags_offset(index), true)) return false;
+    char name[DECK_META_TAG_SIZE];
+    for (uint32_t id = 0; id < index->header.tag_count; id++) {
+        if (mtg_file_read(index->file, name, sizeof(name)) != sizeof(name)) return false;
+        if (deck_store_tag(store, name, strnlen(name, sizeof(name) - 1)) != (int)id) return false;
+    }
+    return true;
+}
+
+bool deck_index_read_order(DeckIndex* index, uint16_t* order) {
+    furi_assert(index);
+    furi_assert(order);
+
+    size_t size = index->header.deck_count * sizeof(uint16_t);
+    if (!storage_file_seek(index->file, deck_index_order_offset(index), true)) return false;
+    if (mtg_file_read(index->file, order, size) != size) return false;
+    for (uint32_t i = 0; i < index->header.deck_count; i++) {
+        if (order[i] >= index->header.deck_count) return false;
+    }
+    return true;
+}
+
+static bool deck_index_verify(DeckIndex* index) {
+    uint8_t* block = malloc(DECK_INDEX_BLOCK_SIZE);
+    uint32_t checksum = MTG_CHECKSUM_SEED;
+    uint32_t remaining = deck_index_end_offset(index) - deck_index_table_offset(index);
+
+    if (storage_file_seek(index->file, deck_index_table_offset(index), true)) {
+        while (remaining > 0) {
+            size_t size = MIN(remaining, (uint32_t)DECK_INDEX_BLOCK_SIZE);
+            if (mtg_file_read(index->file, block, size) != size) break;
+            checksum = mtg_checksum(checksum, block, size);
+            remaining -= size;
+        }
+    }
+
+    free(block);
+    return remaining == 0 && checksum == index->header.checksum;
+}
+
+bool deck_index_load(DeckIndex* index, DeckStore* store) {
+    furi_assert(index);
+    furi_assert(store);
+
+    deck_store_reset(store);
+    if (!deck_index_verify(index)) {
+        FURI_LOG_E("MTG", "Index checksum mismatch");
+        return false;
+    }
+    if (!storage_file_seek(index->file, deck_index_names_offset(index), true)) return false;
+
+    uint32_t count = index->header.deck_count;
+    LineReader* reader = line_reader_alloc(index->file, LINE_READER_DEFAULT_BLOCK_SIZE);
+    const char* line;
+    size_t length;
+    bool success = true;
+    // The names block ends where the tags begin
+    while (success && deck_store_count(store) < count && line_reader_next(reader, &line, &length)) {
+        success = deck_store_add(store, line, length);
+    }
+    line_reader_free(reader);
+    if (!success || deck_store_count(store) != count) return false;
+
+    // Metadata comes from the table, a block at a time
+    DeckMeta metas[DECK_INDEX_BLOCK_SIZE / sizeof(DeckIndexEntry)];
+    for (uint32_t first = 0; first < count; first += COUNT_OF(metas)) {
+        size_t chunk = MIN(count - first, COUNT_OF(metas));
+        if (!deck_index_read_meta(index, first, metas, chunk)) return false;
+        for (size_t i = 0; i < chunk; i++) {
+            deck_store_set_meta(store, first + i, metas[i]);
+        }
+    }
+    return deck_index_load_tags(index, store);
+}
+
+static void deck_index_writer_put(DeckIndexWriter* writer, const void* data, size_t size) {
+    writer->checksum = mtg_checksum(writer->checksum, data, size);
+    block_writer_put(writer->writer, data, size);
+}
+
+bool deck_index_write(const char* index_path, const char* source_path, const DeckStore* store) {
+    furi_assert(store);
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    DeckIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    DeckIndexWriter writer = {
+        .writer = block_writer_alloc(file, DECK_INDEX_BLOCK_SIZE),
+        .checksum = MTG_CHECKSUM_SEED,
+    };
+
+    bool success = false;
+    do {
+        FileStamp stamp;
+        if (!file_stamp_get(storage, source_path, &stamp)) break;
+        header.source_size = stamp.size;
+        header.source_mtime = stamp.mtime;
+        if (!storage_file_open(file, index_path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) break;
+
+        // Blank header first; the real one is written last so a torn write never validates
+        if (mtg_file_write(file, &header, sizeof(header)) != sizeof(header)) break;
+
+        size_t count = deck_store_count(store);
+        uint32_t offset = 0;
+        for (size_t i = 0; i < count; i++) {
+            DeckIndexEntry entry = {
+                .offset = offset,
+                .length = deck_store_get_length(store, i),
+                .reserved = 0,
+                .meta = deck_store_get_meta(store, i),
+            };
+            deck_index_writer_put(&writer, &entry, sizeof(entry));
+            offset += entry.length + 1;
+        }
+        for (size_t i = 0; i < count; i++) {
+            deck_index_writer_put(&writer, deck_store_get(store, i), deck_store_get_length(store, i));
+            deck_index_writer_put(&writer, "\n", 1);
+        }
+        size_t tag_count = deck_store_tag_count(store);
+        for (size_t id = 0; id < tag_count; id++) {
+            char name[DECK_META_TAG_SIZE] = {0};
+            strncpy(name, deck_store_tag_name(store, id), sizeof(name) - 1);
+            deck_index_writer_put(&writer, name, sizeof(name));
+        }
+        uint16_t* order = malloc(MAX(count, (size_t)1) * sizeof(uint16_t));
+        bool sorted = order && deck_search_sort(store, order);
+        if (sorted) deck_index_writer_put(&writer, order, count * sizeof(uint16_t));
+        free(order);
+        if (!sorted) break;
+        if (!block_writer_flush(writer.writer)) break;
+
+        header.magic = DECK_INDEX_MAGIC;
+        header.version = DECK_INDEX_VERSION;
+        header.header_size = sizeof(DeckIndexHeader);
+        header.deck_count = count;
+        header.names_size = offset;
+        header.checksum = writer.checksum;
+        header.tag_count = tag_count;
+        if (!storage_file_seek(file, 0, true)) break;
+        if (mtg_file_write(file, &header, sizeof(header)) != sizeof(header)) break;
+        success = true;
+    } while (false);
+
+    storage_file_close(file);
+    if (!success) {
+        FURI_LOG_E("MTG", "Failed to write deck index");
+        storage_common_remove(storage, index_path);
+    }
+
+    block_writer_free(writer.writer);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return success;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <furi.h>
+#include <storage/storage.h>
+
+#include "mtg_deck_store.h"
+
+/* Binary sidecar for a deck list text file
+ *
+ *   header   DeckIndexHeader, stamped with the source file size and mtime
+ *   table    deck_count fixed-width entries: name offset, length and metadata
+ *   names    packed names, each followed by a newline so the block reads
+ *            back like a plain deck list
+ *   tags     tag_count names of DECK_META_TAG_SIZE bytes, in tag id order
+ *   order    deck_count 16-bit positions sorted for search, see mtg_deck_search.h
+ *
+ * Opening an index costs one header read; names and metadata are then read by
+ * offset on demand. The checksum covers everything after the header and is
+ * verified whenever the whole index is read back into a DeckStore.
+ */
+
+#define DECK_INDEX_MAGIC   0x4944474DU // "MGDI"
+#define DECK_INDEX_VERSION 3
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t source_size;
+    uint32_t source_mtime;
+    uint32_t deck_count;
+    uint32_t names_size;
+    uint32_t checksum;
+    uint32_t tag_count;
+} __attribute__((packed)) DeckIndexHeader;
+
+typedef struct {
+    uint32_t offset;
+    uint16_t length;
+    uint16_t reserved;
+    DeckMeta meta;
+} __attribute__((packed)) DeckIndexEntry;
+
+typedef struct DeckIndex DeckIndex;
+
+/** Open an index if it exists and still matches its source file
+ *
+ * @return NULL when the index is missing, damaged or stale
+ */
+DeckIndex* deck_index_open(const char* index_path, const char* source_path);
+
+void deck_index_close(DeckIndex* index);
+
+uint32_t deck_index_count(const DeckIndex* index);
+
+/** Read a single name by position, NUL-terminated and truncated to size */
+bool deck_index_read_name(DeckIndex* index, uint32_t position, char* name, size_t size);
+
+/** Read the metadata of count decks starting at first */
+bool deck_index_read_meta(DeckIndex* index, uint32_t first, DeckMeta* metas, size_t count);
+
+/** Register the list's tags, in id order, in an empty store */
+bool deck_index_load_tags(DeckIndex* index, DeckStore* store);
+
+/** Read the search order, deck_count positions */
+bool deck_index_read_order(DeckIndex* index, uint16_t* order);
+
+/** Read every name and its metadata into a store after verifying the checksum */
+bool deck_index_load(DeckIndex* index, DeckStore* store);
+
+/** Build an index for a store whose contents match the source file on disk */
+bool deck_index_write(const char* index_path, const char* source_path, const DeckStore* store);
@@ -0,0 +1,233 @@
+#include "mtg_deck_journal.h"
+#include "mtg_storage_helpers.h"
+
+struct DeckJournal {
+    Storage* storage;
+    FuriString* path;
+    FuriString* source_path;
+    uint8_t* scratch;
+    size_t size;
+    uint32_t next_sequence;
+};
+
+#define DECK_JOURNAL_SCRATCH_SIZE (sizeof(DeckJournalRecord) + DECK_JOURNAL_NAME_MAX)
+
+DeckJournal* deck_journal_alloc(const char* journal_path, const char* source_path) {
+    furi_assert(journal_path);
+    furi_assert(source_path);
+
+    DeckJournal* journal = malloc(sizeof(DeckJournal));
+    journal->storage = furi_record_open(RECORD_STORAGE);
+    journal->path = furi_string_alloc_set(journal_path);
+    journal->source_path = furi_string_alloc_set(source_path);
+    journal->scratch = malloc(DECK_JOURNAL_SCRATCH_SIZE);
+    journal->size = 0;
+    journal->next_sequence = 1;
+    return journal;
+}
+
+void deck_journal_free(DeckJournal* journal) {
+    furi_assert(journal);
+    free(journal->scratch);
+    furi_string_free(journal->source_path);
+    furi_string_free(journal->path);
+    furi_record_close(RECORD_STORAGE);
+    free(journal);
+}
+
+// Read and validate the header of an open journal, leaving the file at the first record
+static bool deck_journal_check_header(DeckJournal* journal, File* file, DeckJournalHeader* header) {
+    if (mtg_file_read(file, header, sizeof(DeckJournalHeader)) != sizeof(DeckJournalHeader)) return false;
+    if (header->magic != DECK_JOURNAL_MAGIC || header->version != DECK_JOURNAL_VERSION ||
+       header->header_size < sizeof(DeckJournalHeader)) {
+        FURI_LOG_W("MTG", "Ignoring journal with unknown format");
+        return false;
+    }
+
+    FileStamp stamp;
+    if (!file_stamp_get(journal->storage, furi_string_get_cstr(journal->source_path), &stamp)) return false;
+    if (header->source_size != stamp.size || header->source_mtime != stamp.mtime) {
+        FURI_LOG_I("MTG", "Journal is stale, deck list was rewritten");
+        return false;
+    }
+    return storage_file_seek(file, header->header_size, true);
+}
+
+bool deck_journal_pending(DeckJournal* journal) {
+    furi_assert(journal);
+
+    const char* path = furi_string_get_cstr(journal->path);
+    if (!storage_common_exists(journal->storage, path)) return false;
+
+    File* file = storage_file_alloc(journal->storage);
+    DeckJournalHeader header;
+    bool valid = false;
+    bool pending = false;
+    if (storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        valid = deck_journal_check_header(journal, file, &header);
+        pending = valid && storage_file_size(file) > header.header_size;
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if (!valid) {
+        deck_journal_clear(journal);
+    }
+    return pending;
+}
+
+static uint32_t deck_journal_record_checksum(DeckJournalRecord record, const uint8_t* name) {
+    record.checksum = 0;
+    uint32_t checksum = mtg_checksum(MTG_CHECKSUM_SEED, &record, sizeof(record));
+    return mtg_checksum(checksum, name, record.length);
+}
+
+static bool deck_journal_apply(DeckStore* store, const DeckJournalRecord* record, const char* name) {
+    size_t count = deck_store_count(store);
+    switch (record->op) {
+        case DeckJournalOpAdd:
+            return record->position == count && deck_store_add(store, name, record->length);
+        case DeckJournalOpRename:
+            return record->position < count && deck_store_set(store, record->position, name, record->length);
+        case DeckJournalOpDelete:
+            if (record->position >= count) return false;
+            deck_store_remove(store, record->position);
+            return true;
+        default:
+            return false;
+    }
+}
+
+size_t deck_journal_replay(DeckJournal* journal, DeckStore* store) {
+    furi_assert(journal);
+    furi_assert(store);
+
+    File* file = storage_file_alloc(journal->storage);
+    DeckJournalHeader header;
+    size_t applied = 0;
+    uint32_t sequence = 1;
+    uint64_t offset = 0;
+    uint64_t file_size = 0;
+    bool valid = false;
+
+    if (storage_file_open(file, furi_string_get_cstr(journal->path), FSAM_READ_WRITE, FSOM_OPEN_EXISTING)) {
+        valid = deck_journal_check_header(journal, file, &header);
+    }
+
+    if (valid) {
+        file_size = storage_file_size(file);
+        offset = header.header_size;
+
+        DeckJournalRecord record;
+        char* name = (char*)journal->scratch;
+        while (mtg_file_read(file, &record, sizeof(record)) == sizeof(record)) {
+            if (mtg_file_read(file, name, record.length) != record.length) break;
+            if (record.sequence != sequence) break;
+            if (record.checksum != deck_journal_record_checksum(record, (const uint8_t*)name)) break;
+            if (!deck_journal_apply(store, &record, name)) {
+                FURI_LOG_W("MTG", "Journal record %lu does not fit the deck list", (unsigned long)sequence);
+                break;
+            }
+            offset += sizeof(record) + record.length;
+            sequence++;
+            applied++;
+        }
+
+        // Cut off a torn append so new records follow the last good one
+        if (offset < file_size) {
+            FURI_LOG_W("MTG", "Dropping %lu bytes of torn journal", (unsigned long)(file_size - offset));
+            if (!storage_file_seek(file, offset, true) || !storage_file_truncate(file)) {
+                valid = false;
+            }
+        }
+    }
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if (valid) {
+        journal->size = offset - header.header_size;
+        journal->next_sequence = sequence;
+        FURI_LOG_I("MTG", "Replayed %zu journal records", applied);
+    } else {
+        deck_journal_clear(journal);
+    }
+    return applied;
+}
+
+bool deck_journal_append(
+    DeckJournal* journal,
+    DeckJournalOp op,
+    size_t position,
+    const char* name,
+    size_t length) {
+    furi_assert(journal);
+    furi_assert(position <= UINT16_MAX);
+    furi_assert(length <= DECK_JOURNAL_NAME_MAX);
+    furi_assert(name || length == 0);
+
+    DeckJournalRecord record = {
+        .sequence = journal->next_sequence,
+        .position = position,
+        .op = op,
+        .length = length,
+        .checksum = 0,
+    };
+    uint8_t* buffer = journal->scratch;
+    if (length > 0) memcpy(buffer + sizeof(record), name, length);
+    record.checksum = deck_journal_record_checksum(record, buffer + sizeof(record));
+    memcpy(buffer, &record, sizeof(record));
+    size_t record_size = sizeof(record) + length;
+
+    File* file = storage_file_alloc(journal->storage);
+    bool success = false;
+    do {
+        if (!storage_file_open(file, furi_string_get_cstr(journal->path), FSAM_WRITE, FSOM_OPEN_APPEND)) break;
+
+        uint64_t end = storage_file_size(file);
+        if (end < sizeof(DeckJournalHeader)) {
+            FileStamp stamp;
+            if (!file_stamp_get(journal->storage, furi_string_get_cstr(journal->source_path), &stamp)) break;
+            DeckJournalHeader header = {
+                .magic = DECK_JOURNAL_MAGIC,
+                .version = DECK_JOURNAL_VERSION,
+                .header_size = sizeof(DeckJournalHeader),
+                .source_size = stamp.size,
+                .source_mtime = stamp.mtime,
+            };
+            if (!storage_file_seek(file, 0, true) || !storage_file_truncate(file)) break;
+            if (mtg_file_write(file, &header, sizeof(header)) != sizeof(header)) break;
+            end = sizeof(header);
+        }
+
+        if (mtg_file_write(file, buffer, record_size) != record_size) {
+            // Don't leave a partial record for later appends to land behind
+            if (storage_file_seek(file, end, true)) storage_file_truncate(file);
+            break;
+        }
+        success = true;
+    } while (false);
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if (success) {
+        journal->size += record_size;
+        journal->next_sequence++;
+    } else {
+        FURI_LOG_E("MTG", "Failed to append to deck journal");
+    }
+    return success;
+}
+
+size_t deck_journal_size(const DeckJournal* journal) {
+    furi_assert(journal);
+    return journal->size;
+}
+
+void deck_journal_clear(DeckJournal* journal) {
+    furi_assert(journal);
+    storage_common_remove(journal->storage, furi_string_get_cstr(journal->path));
+    journal->size = 0;
+    journal->next_sequence = 1;
+}
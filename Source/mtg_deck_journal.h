@@ -0,0 +1,84 @@
+#pragma once
+
+#include <furi.h>
+#include <storage/storage.h>
+
+#include "mtg_deck_store.h"
+
+/* Append-only log of deck edits made since the list was last written out
+ *
+ *   header   DeckJournalHeader, stamped with the size and mtime of the deck
+ *            list it applies to
+ *   records  DeckJournalRecord followed by length bytes of name, one
+ *            storage_file_write per record
+ *
+ * Records carry consecutive sequence numbers and a checksum over the record
+ * and its name. Replay stops at the first record that fails either check and
+ * truncates the torn tail, so a power loss mid-append loses at most that edit.
+ * A journal whose stamp no longer matches the list (the list was compacted or
+ * changed on the computer) is discarded.
+ */
+
+#define DECK_JOURNAL_MAGIC   0x4A44474DU // "MGDJ"
+#define DECK_JOURNAL_VERSION 1
+
+typedef enum {
+    DeckJournalOpAdd = 1,
+    DeckJournalOpRename = 2,
+    DeckJournalOpDelete = 3,
+} DeckJournalOp;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t source_size;
+    uint32_t source_mtime;
+} __attribute__((packed)) DeckJournalHeader;
+
+typedef struct {
+    uint32_t sequence;
+    uint16_t position;
+    uint8_t op;
+    uint8_t length;
+    uint32_t checksum;
+} __attribute__((packed)) DeckJournalRecord;
+
+// Names are at most this long in a record
+#define DECK_JOURNAL_NAME_MAX UINT8_MAX
+
+typedef struct DeckJournal DeckJournal;
+
+DeckJournal* deck_journal_alloc(const char* journal_path, const char* source_path);
+
+void deck_journal_free(DeckJournal* journal);
+
+/** Check for records that still apply to the source file
+ *
+ * A stale or unreadable journal is removed.
+ */
+bool deck_journal_pending(DeckJournal* journal);
+
+/** Apply every intact record to a store holding the source file's decks
+ *
+ * @return number of records applied
+ */
+size_t deck_journal_replay(DeckJournal* journal, DeckStore* store);
+
+/** Append one edit, writing the header first if the journal is empty
+ *
+ * Add records must use the position the deck was appended at; the name is
+ * ignored for deletes.
+ */
+bool deck_journal_append(
+    DeckJournal* journal,
+    DeckJournalOp op,
+    size_t position,
+    const char* name,
+    size_t length);
+
+/** Bytes of records as of the last replay or append, 0 if there are none */
+size_t deck_journal_size(const DeckJournal* journal);
+
+/** Drop the journal once its edits have reached the source file */
+void deck_journal_clear(DeckJournal* journal);
@@ -0,0 +1,295 @@
+#include "mtg_deck_lists.h"
+#include "mtg_deck_index.h"
+#include "mtg_line_reader.h"
+#include "mtg_storage_helpers.h"
+
+#include <stdio.h>
+#include <storage/storage.h>
+
+#define DECK_LISTS_EXTENSION ".txt"
+
+struct DeckLists {
+    Storage* storage;
+    FuriString* folder;
+    FuriString* manifest_path;
+    DeckListInfo entries[DECK_LISTS_MAX];
+    size_t count;
+    size_t active;
+    bool dirty;
+};
+
+static uint32_t deck_lists_checksum(const DeckLists* lists) {
+    return mtg_checksum(MTG_CHECKSUM_SEED, lists->entries, lists->count * sizeof(DeckListInfo));
+}
+
+static bool deck_lists_read(DeckLists* lists) {
+    File* file = storage_file_alloc(lists->storage);
+    bool success = false;
+    do {
+        if (!storage_file_open(file, furi_string_get_cstr(lists->manifest_path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+            break;
+        }
+        DeckListsHeader header;
+        if (mtg_file_read(file, &header, sizeof(header)) != sizeof(header)) break;
+        if (header.magic != DECK_LISTS_MAGIC || header.version != DECK_LISTS_VERSION ||
+           header.header_size < sizeof(header) || header.count > DECK_LISTS_MAX ||
+           (header.count > 0 && header.active >= header.count)) {
+            FURI_LOG_W("MTG", "Ignoring list manifest with unknown format");
+            break;
+        }
+        if (!storage_file_seek(file, header.header_size, true)) break;
+        size_t size = header.count * sizeof(DeckListInfo);
+        if (mtg_file_read(file, lists->entries, size) != size) break;
+
+        lists->count = header.count;
+        if (deck_lists_checksum(lists) != header.checksum) {
+            FURI_LOG_W("MTG", "List manifest checksum mismatch");
+            lists->count = 0;
+            break;
+        }
+        for (size_t i = 0; i < lists->count; i++) {
+            lists->entries[i].name[DECK_LIST_NAME_SIZE - 1] = '\0';
+        }
+        lists->active = header.active;
+        success = true;
+    } while (false);
+
+    storage_file_close(file);
+    storage_file_free(file);
+    return success;
+}
+
+static int deck_lists_find(const DeckLists* lists, const char* name) {
+    for (size_t i = 0; i < lists->count; i++) {
+        if (strcmp(lists->entries[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static int deck_lists_add(DeckLists* lists, const char* name) {
+    if (lists->count >= DECK_LISTS_MAX) return -1;
+
+    // Keep the entries sorted by name, and the active one pointed at
+    size_t place = 0;
+    while (place < lists->count && strcmp(lists->entries[place].name, name) < 0) {
+        place++;
+    }
+    memmove(&lists->entries[place + 1], &lists->entries[place], (lists->count - place) * sizeof(DeckListInfo));
+    memset(&lists->entries[place], 0, sizeof(DeckListInfo));
+    strncpy(lists->entries[place].name, name, DECK_LIST_NAME_SIZE - 1);
+    lists->count++;
+    if (lists->count > 1 && lists->active >= place) lists->active++;
+    lists->dirty = true;
+    return place;
+}
+
+static void deck_lists_remove(DeckLists* lists, size_t list) {
+    memmove(
+        &lists->entries[list], &lists->entries[list + 1], (lists->count - list - 1) * sizeof(DeckListInfo));
+    lists->count--;
+    if (lists->active > list) lists->active--;
+    lists->dirty = true;
+}
+
+// Decks in a list, from its index when that is current, else from its lines
+static uint32_t deck_lists_count_decks(DeckLists* lists, size_t list) {
+    DeckListPaths paths;
+    deck_lists_paths(lists, list, &paths);
+
+    DeckIndex* index = deck_index_open(paths.index, paths.text);
+    if (index) {
+        uint32_t count = deck_index_count(index);
+        deck_index_close(index);
+        return count;
+    }
+
+    uint32_t count = 0;
+    File* file = storage_file_alloc(lists->storage);
+    if (storage_file_open(file, paths.text, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        LineReader* reader = line_reader_alloc(file, LINE_READER_DEFAULT_BLOCK_SIZE);
+        const char* line;
+        size_t length;
+        while (line_reader_next(reader, &line, &length)) {
+            if (length > 0) count++;
+        }
+        line_reader_free(reader);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    return MIN(count, (uint32_t)DECK_STORE_ENTRIES_MAX);
+}
+
+DeckLists* deck_lists_open(const char* folder, const char* manifest_path, const char* default_name) {
+    furi_assert(folder);
+    furi_assert(manifest_path);
+    furi_assert(default_name);
+    furi_assert(strlen(default_name) < DECK_LIST_NAME_SIZE);
+
+    DeckLists* lists = malloc(sizeof(DeckLists));
+    lists->storage = furi_record_open(RECORD_STORAGE);
+    lists->folder = furi_string_alloc_set(folder);
+    lists->manifest_path = furi_string_alloc_set(manifest_path);
+    lists->count = 0;
+    lists->active = 0;
+    lists->dirty = false;
+
+    if (!deck_lists_read(lists)) {
+        FURI_LOG_I("MTG", "Building list manifest");
+        lists->count = 0;
+        lists->active = 0;
+        deck_lists_add(lists, default_name);
+        deck_lists_refresh(lists);
+    }
+    return lists;
+}
+
+void deck_lists_close(DeckLists* lists) {
+    furi_assert(lists);
+    furi_string_free(lists->folder);
+    furi_string_free(lists->manifest_path);
+    furi_record_close(RECORD_STORAGE);
+    free(lists);
+}
+
+bool deck_lists_sync(DeckLists* lists) {
+    furi_assert(lists);
+    if (!lists->dirty) return true;
+
+    DeckListsHeader header = {
+        .magic = DECK_LISTS_MAGIC,
+        .version = DECK_LISTS_VERSION,
+        .header_size = sizeof(DeckListsHeader),
+        .count = lists->count,
+        .active = lists->active,
+        .checksum = deck_lists_checksum(lists),
+    };
+    size_t size = lists->count * sizeof(DeckListInfo);
+
+    // The checksum covers the entries, so a torn write is rebuilt on the next open
+    File* file = storage_file_alloc(lists->storage);
+    bool success =
+        storage_file_open(file, furi_string_get_cstr(lists->manifest_path), FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+        mtg_file_write(file, &header, sizeof(header)) == sizeof(header) &&
+        mtg_file_write(file, lists->entries, size) == size;
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if (success) {
+        lists->dirty = false;
+    } else {
+        FURI_LOG_E("MTG", "Failed to write list manifest");
+    }
+    return success;
+}
+
+void deck_lists_refresh(DeckLists* lists) {
+    furi_assert(lists);
+
+    bool seen[DECK_LISTS_MAX] = {false};
+    File* dir = storage_file_alloc(lists->storage);
+    if (storage_dir_open(dir, furi_string_get_cstr(lists->folder))) {
+        FileInfo info;
+        char name[DECK_LIST_PATH_SIZE];
+        while (storage_dir_read(dir, &info, name, sizeof(name))) {
+            if (info.flags & FSF_DIRECTORY) continue;
+            size_t length = strlen(name);
+            size_t stem = length - (sizeof(DECK_LISTS_EXTENSION) - 1);
+            if (length <= sizeof(DECK_LISTS_EXTENSION) - 1 || stem >= DECK_LIST_NAME_SIZE ||
+               strcmp(name + stem, DECK_LISTS_EXTENSION) != 0) {
+                continue;
+            }
+            name[stem] = '\0';
+
+            int list = deck_lists_find(lists, name);
+            if (list < 0) {
+                // Entries after the new one move up, and so do their marks
+                list = deck_lists_add(lists, name);
+                if (list < 0) {
+                    FURI_LOG_W("MTG", "Too many deck lists, ignoring %s", name);
+                    continue;
+                }
+                memmove(&seen[list + 1], &seen[list], (lists->count - list - 1) * sizeof(bool));
+            }
+            seen[list] = true;
+        }
+    }
+    storage_dir_close(dir);
+    storage_file_free(dir);
+
+    // Lists whose file is gone are dropped, except the active one, which is
+    // written out again on its next save
+    for (size_t i = lists->count; i-- > 0;) {
+        if (!seen[i] && i != lists->active) deck_lists_remove(lists, i);
+    }
+
+    // Count again only what changed since the manifest was written
+    for (size_t i = 0; i < lists->count; i++) {
+        DeckListInfo* entry = &lists->entries[i];
+        DeckListPaths paths;
+        deck_lists_paths(lists, i, &paths);
+        FileStamp stamp;
+        if (!file_stamp_get(lists->storage, paths.text, &stamp)) continue;
+        if (stamp.size == entry->source_size && stamp.mtime == entry->source_mtime) continue;
+
+        entry->deck_count = deck_lists_count_decks(lists, i);
+        entry->source_size = stamp.size;
+        entry->source_mtime = stamp.mtime;
+        lists->dirty = true;
+    }
+}
+
+size_t deck_lists_count(const DeckLists* lists) {
+    furi_assert(lists);
+    return lists->count;
+}
+
+const DeckListInfo* deck_lists_get(const DeckLists* lists, size_t list) {
+    furi_assert(lists);
+    furi_assert(list < lists->count);
+    return &lists->entries[list];
+}
+
+size_t deck_lists_active(const DeckLists* lists) {
+    furi_assert(lists);
+    return lists->active;
+}
+
+void deck_lists_set_active(DeckLists* lists, size_t list, uint32_t timestamp) {
+    furi_assert(lists);
+    furi_assert(list < lists->count);
+    lists->active = list;
+    lists->entries[list].last_used = timestamp;
+    lists->dirty = true;
+}
+
+void deck_lists_set_count(DeckLists* lists, uint32_t deck_count) {
+    furi_assert(lists);
+    furi_assert(lists->count > 0);
+
+    DeckListInfo* entry = &lists->entries[lists->active];
+    DeckListPaths paths;
+    deck_lists_paths(lists, lists->active, &paths);
+    FileStamp stamp = {0, 0};
+    file_stamp_get(lists->storage, paths.text, &stamp);
+    if (entry->deck_count == deck_count && entry->source_size == stamp.size && entry->source_mtime == stamp.mtime) {
+        return;
+    }
+    entry->deck_count = deck_count;
+    entry->source_size = stamp.size;
+    entry->source_mtime = stamp.mtime;
+    lists->dirty = true;
+}
+
+void deck_lists_paths(const DeckLists* lists, size_t list, DeckListPaths* paths) {
+    furi_assert(lists);
+    furi_assert(list < lists->count);
+    furi_assert(paths);
+
+    const char* folder = furi_string_get_cstr(lists->folder);
+    const char* name = lists->entries[list].name;
+    snprintf(paths->text, sizeof(paths->text), "%s/%s.txt", folder, name);
+    snprintf(paths->index, sizeof(paths->index), "%s/%s.idx", folder, name);
+    snprintf(paths->tmp, sizeof(paths->tmp), "%s/%s.tmp", folder, name);
+    snprintf(paths->journal, sizeof(paths->journal), "%s/%s.journal", folder, name);
+    snprintf(paths->picker, sizeof(paths->picker), "%s/%s.picker", folder, name);
+}
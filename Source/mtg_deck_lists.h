@@ -0,0 +1,85 @@
+#pragma once
+
+#include <furi.h>
+
+/* Named deck lists and their manifest
+ *
+ * Every .txt file in the app folder is a deck list. Its index, journal and
+ * picker state sit next to it under the same name, so the original
+ * mtg_decks.txt keeps its files as they were.
+ *
+ * The manifest caches, for each list, its deck count and last use along with
+ * the size and mtime of the file the count was taken from:
+ *
+ *   header   DeckListsHeader, with a checksum over the entries
+ *   entries  count DeckListInfo, sorted by name
+ *
+ * Startup reads the manifest alone and loads only the active list. The folder
+ * is listed when the list picker opens; lists that appeared are added, lists
+ * that were deleted are dropped, and only lists whose file changed since the
+ * manifest was written are counted again, from their index when it is
+ * current. A missing or damaged manifest is rebuilt the same way.
+ */
+
+#define DECK_LISTS_MAGIC   0x4C44474DU // "MGDL"
+#define DECK_LISTS_VERSION 1
+#define DECK_LISTS_MAX     16
+// Longest list name, terminator included
+#define DECK_LIST_NAME_SIZE 32
+#define DECK_LIST_PATH_SIZE 64
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint16_t count;
+    uint16_t active;
+    uint32_t checksum;
+} __attribute__((packed)) DeckListsHeader;
+
+typedef struct {
+    char name[DECK_LIST_NAME_SIZE];
+    uint32_t deck_count;
+    uint32_t last_used;
+    uint32_t source_size;
+    uint32_t source_mtime;
+} __attribute__((packed)) DeckListInfo;
+
+/** Files belonging to one list */
+typedef struct {
+    char text[DECK_LIST_PATH_SIZE];
+    char index[DECK_LIST_PATH_SIZE];
+    char tmp[DECK_LIST_PATH_SIZE];
+    char journal[DECK_LIST_PATH_SIZE];
+    char picker[DECK_LIST_PATH_SIZE];
+} DeckListPaths;
+
+typedef struct DeckLists DeckLists;
+
+/** Read the manifest, or scan the folder if there is none
+ *
+ * @param default_name  list to start with when none is known yet
+ */
+DeckLists* deck_lists_open(const char* folder, const char* manifest_path, const char* default_name);
+
+void deck_lists_close(DeckLists* lists);
+
+/** Write the manifest if anything changed since it was read */
+bool deck_lists_sync(DeckLists* lists);
+
+/** Bring the manifest up to date with the files in the folder */
+void deck_lists_refresh(DeckLists* lists);
+
+size_t deck_lists_count(const DeckLists* lists);
+
+const DeckListInfo* deck_lists_get(const DeckLists* lists, size_t list);
+
+size_t deck_lists_active(const DeckLists* lists);
+
+/** Make a list the active one and stamp its last use */
+void deck_lists_set_active(DeckLists* lists, size_t list, uint32_t timestamp);
+
+/** Record the active list's deck count, as of its file on disk now */
+void deck_lists_set_count(DeckLists* lists, uint32_t deck_count);
+
+void deck_lists_paths(const DeckLists* lists, size_t list, DeckListPaths* paths);
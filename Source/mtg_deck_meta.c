@@ -0,0 +1,151 @@
+#include "mtg_deck_meta.h"
+#include "mtg_deck_store.h"
+
+#include <stdio.h>
+
+typedef enum {
+    DeckMetaFieldColors,
+    DeckMetaFieldBracket,
+    DeckMetaFieldTags,
+    DeckMetaFieldCount,
+} DeckMetaField;
+
+static bool deck_meta_is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static void deck_meta_trim(const char** start, const char** end) {
+    while (*start < *end && deck_meta_is_blank(**start)) (*start)++;
+    while (*end > *start && deck_meta_is_blank((*end)[-1])) (*end)--;
+}
+
+static DeckMeta deck_meta_parse_colors(const char* start, const char* end) {
+    if (start == end) return DECK_META_NONE;
+
+    DeckMeta meta = DECK_META_COLORS_KNOWN;
+    for (const char* c = start; c < end; c++) {
+        char letter = *c & ~0x20; // upper case
+        const char* color = strchr(DECK_COLOR_NAMES, letter);
+        if (letter && color) meta |= 1U << (color - DECK_COLOR_NAMES);
+    }
+    return meta;
+}
+
+static DeckMeta deck_meta_parse_bracket(const char* start, const char* end) {
+    uint32_t bracket = 0;
+    for (const char* c = start; c < end; c++) {
+        if (*c < '0' || *c > '9') return DECK_META_NONE;
+        bracket = bracket * 10 + (*c - '0');
+        if (bracket > DECK_META_BRACKET_MAX) return DECK_META_NONE;
+    }
+    return bracket << DECK_META_BRACKET_SHIFT;
+}
+
+static DeckMeta deck_meta_parse_tags(DeckStore* store, const char* start, const char* end) {
+    DeckMeta meta = DECK_META_NONE;
+    while (start < end) {
+        const char* comma = memchr(start, ',', end - start);
+        const char* tag_end = comma ? comma : end;
+        const char* tag = start;
+        deck_meta_trim(&tag, &tag_end);
+        if (tag < tag_end) {
+            int id = deck_store_tag(store, tag, tag_end - tag);
+            if (id >= 0) {
+                meta |= 1U << (DECK_META_TAGS_SHIFT + id);
+            } else {
+                FURI_LOG_W("MTG", "Too many tags, ignoring %.*s", (int)(tag_end - tag), tag);
+            }
+        }
+        start = comma ? comma + 1 : end;
+    }
+    return meta;
+}
+
+size_t deck_meta_parse(DeckStore* store, const char* line, size_t length, DeckMeta* meta) {
+    furi_assert(store);
+    furi_assert(line);
+    furi_assert(meta);
+
+    *meta = DECK_META_NONE;
+    const char* bar = memchr(line, '|', length);
+    if (!bar) return length;
+
+    // Leading blanks are kept as they would be in a plain name
+    size_t name_length = bar - line;
+    while (name_length > 0 && deck_meta_is_blank(line[name_length - 1])) name_length--;
+
+    const char* end = line + length;
+    const char* cursor = bar + 1;
+    for (DeckMetaField field = 0; field < DeckMetaFieldCount; field++) {
+        const char* field_end = memchr(cursor, '|', end - cursor);
+        if (!field_end) field_end = end;
+        const char* start = cursor;
+        const char* stop = field_end;
+        deck_meta_trim(&start, &stop);
+
+        switch (field) {
+            case DeckMetaFieldColors:
+                *meta |= deck_meta_parse_colors(start, stop);
+                break;
+            case DeckMetaFieldBracket:
+                *meta |= deck_meta_parse_bracket(start, stop);
+                break;
+            default:
+                *meta |= deck_meta_parse_tags(store, start, stop);
+                break;
+        }
+
+        if (field_end == end) break;
+        cursor = field_end + 1;
+    }
+    return name_length;
+}
+
+static void deck_meta_append(char* buffer, size_t size, size_t* used, const char* text, size_t length) {
+    length = MIN(length, size - 1 - *used);
+    memcpy(buffer + *used, text, length);
+    *used += length;
+}
+
+size_t deck_meta_format(const DeckStore* store, DeckMeta meta, char* buffer, size_t size) {
+    furi_assert(store);
+    furi_assert(buffer);
+    furi_assert(size > 0);
+
+    size_t used = 0;
+    // Trailing empty fields are left off
+    size_t kept = 0;
+
+    deck_meta_append(buffer, size, &used, "|", 1);
+    if (deck_meta_has_colors(meta)) {
+        uint8_t colors = deck_meta_colors(meta);
+        for (size_t i = 0; i < DECK_COLOR_COUNT; i++) {
+            if (colors & (1 << i)) deck_meta_append(buffer, size, &used, &DECK_COLOR_NAMES[i], 1);
+        }
+        if (!colors) deck_meta_append(buffer, size, &used, "C", 1);
+        kept = used;
+    }
+
+    deck_meta_append(buffer, size, &used, "|", 1);
+    if (deck_meta_bracket(meta)) {
+        char digits[4];
+        int length = snprintf(digits, sizeof(digits), "%u", deck_meta_bracket(meta));
+        deck_meta_append(buffer, size, &used, digits, length);
+        kept = used;
+    }
+
+    deck_meta_append(buffer, size, &used, "|", 1);
+    uint32_t tags = deck_meta_tags(meta);
+    bool first = true;
+    for (size_t id = 0; tags && id < deck_store_tag_count(store); id++) {
+        if (!(tags & (1U << id))) continue;
+        if (!first) deck_meta_append(buffer, size, &used, ",", 1);
+        const char* name = deck_store_tag_name(store, id);
+        deck_meta_append(buffer, size, &used, name, strlen(name));
+        first = false;
+        kept = used;
+    }
+
+    buffer[kept] = '\0';
+    return kept;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <furi.h>
+
+/* Optional deck metadata, carried in mtg_decks.txt after the name
+ *
+ *   Atraxa|WUBG|4|superfriends,counters
+ *
+ * Fields are separated by '|' and each may be left empty or dropped from the
+ * end; a line without '|' is a plain name.
+ *
+ *   colors   color identity as WUBRG letters in any case, C for colorless
+ *   bracket  power bracket, 1..DECK_META_BRACKET_MAX
+ *   tags     comma separated, up to DECK_META_TAGS_MAX distinct per list
+ *
+ * Metadata is packed into one 32-bit word per deck:
+ *
+ *   bits 0-4    WUBRG
+ *   bit 5       color identity given
+ *   bits 6-9    bracket, 0 when not given
+ *   bits 10-31  one bit per tag id, see deck_store_tag
+ */
+
+typedef uint32_t DeckMeta;
+
+typedef enum {
+    DeckColorWhite = (1 << 0),
+    DeckColorBlue = (1 << 1),
+    DeckColorBlack = (1 << 2),
+    DeckColorRed = (1 << 3),
+    DeckColorGreen = (1 << 4),
+} DeckColor;
+
+#define DECK_COLOR_COUNT 5
+#define DECK_COLORS_ALL  0x1F
+#define DECK_COLOR_NAMES "WUBRG"
+
+#define DECK_META_NONE        0
+#define DECK_META_BRACKET_MAX 15
+#define DECK_META_TAGS_MAX    22
+// Longest tag name kept, terminator included
+#define DECK_META_TAG_SIZE 16
+// Longest suffix deck_meta_format can produce, terminator included
+#define DECK_META_FORMAT_SIZE (10 + DECK_META_TAGS_MAX * DECK_META_TAG_SIZE)
+
+#define DECK_META_COLORS_KNOWN (1U << 5)
+#define DECK_META_BRACKET_SHIFT 6
+#define DECK_META_TAGS_SHIFT    10
+
+static inline bool deck_meta_has_colors(DeckMeta meta) {
+    return (meta & DECK_META_COLORS_KNOWN) != 0;
+}
+
+static inline uint8_t deck_meta_colors(DeckMeta meta) {
+    return meta & DECK_COLORS_ALL;
+}
+
+static inline uint8_t deck_meta_bracket(DeckMeta meta) {
+    return (meta >> DECK_META_BRACKET_SHIFT) & DECK_META_BRACKET_MAX;
+}
+
+static inline uint32_t deck_meta_tags(DeckMeta meta) {
+    return meta >> DECK_META_TAGS_SHIFT;
+}
+
+typedef struct DeckStore DeckStore;
+
+/** Split a deck list line into its name and metadata
+ *
+ * Tags are registered in the store's tag table as they are met.
+ *
+ * @return length of the name at the start of line
+ */
+size_t deck_meta_parse(DeckStore* store, const char* line, size_t length, DeckMeta* meta);
+
+/** Format metadata as the "|colors|bracket|tags" suffix of a deck list line
+ *
+ * @return length written, 0 for a deck without metadata
+ */
+size_t deck_meta_format(const DeckStore* store, DeckMeta meta, char* buffer, size_t size);
@@ -0,0 +1,637 @@
+#include "mtg_deck_picker.h"
+#include "mtg_storage_helpers.h"
+
+#include <furi_hal.h>
+#include <storage/storage.h>
+
+/* Picker state file (<list>.picker, next to the deck list)
+ *
+ *   header   DeckPickerHeader
+ *   weights  one byte per deck, present when has_weights is set
+ *   played   one bit per deck, present when has_played is set
+ *
+ * A shuffle pick rewrites only the header; a weight change patches its byte.
+ * Inserting or removing a deck shifts every later weight, so those only mark
+ * the file dirty and it is rewritten by the next sync. If the app stops before
+ * that, the stored count no longer matches and the weights start over.
+ *
+ * The bag is a permutation of the whole list and cannot follow a list that
+ * changes under it. An insert or remove mid-round therefore writes the decks
+ * already drawn into the played bits and starts a fresh permutation that skips
+ * them; the bits are dropped when that round runs out.
+ */
+
+#define DECK_PICKER_MAGIC   0x504B474D // "MGKP"
+#define DECK_PICKER_VERSION 1
+
+#define DECK_PICKER_CLASSES        (DECK_PICKER_WEIGHT_MAX + 1)
+#define DECK_PICKER_ALIAS_FULL     (1ULL << 32)
+#define DECK_PICKER_FEISTEL_ROUNDS 4
+#define DECK_PICKER_MIN_CAPACITY   16
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint8_t mode;
+    uint8_t has_weights;
+    uint8_t has_played;
+    uint8_t reserved;
+    uint32_t count;
+    uint32_t bag_key;
+    uint32_t bag_position;
+} DeckPickerHeader;
+
+struct DeckPicker {
+    Storage* storage;
+    FuriString* path;
+    DeckPickerMode mode;
+    size_t count;
+    // The file is behind on more than the header
+    bool dirty;
+
+    // NULL while every deck has the default weight. Deck positions are kept in
+    // members grouped by weight, class c in [class_start[c], class_start[c + 1]),
+    // and slots maps a position back to its place in members
+    uint8_t* weights;
+    uint16_t* members;
+    uint16_t* slots;
+    size_t capacity;
+    uint32_t class_start[DECK_PICKER_CLASSES + 1];
+    uint64_t alias_threshold[DECK_PICKER_CLASSES];
+    uint8_t alias[DECK_PICKER_CLASSES];
+    bool alias_empty;
+
+    // The bag is position -> permute(position) under bag_key
+    uint32_t bag_key;
+    uint32_t bag_position;
+    uint8_t bag_half_bits;
+    // NULL unless the list changed mid-round: decks the round already drew
+    uint8_t* played;
+};
+
+// xorshift32 state while a seed is set, 0 while draws come from the hardware
+static uint32_t deck_picker_seed_state = 0;
+
+void deck_picker_random_seed(uint32_t seed) {
+    deck_picker_seed_state = seed;
+}
+
+static uint32_t deck_picker_random(void) {
+    if (!deck_picker_seed_state) return furi_hal_random_get();
+    uint32_t x = deck_picker_seed_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    deck_picker_seed_state = x;
+    return x;
+}
+
+uint32_t deck_picker_random_below(uint32_t bound) {
+    furi_assert(bound > 0);
+
+    // 2^32 mod bound values at the bottom would make low results more likely
+    uint32_t floor = -bound % bound;
+    uint32_t value;
+    do {
+        value = deck_picker_random();
+    } while (value < floor);
+    return value % bound;
+}
+
+DeckPicker* deck_picker_alloc(const char* state_path) {
+    furi_assert(state_path);
+
+    DeckPicker* picker = malloc(sizeof(DeckPicker));
+    picker->storage = furi_record_open(RECORD_STORAGE);
+    picker->path = furi_string_alloc_set(state_path);
+    picker->mode = DeckPickerModeUniform;
+    picker->count = 0;
+    picker->dirty = false;
+    picker->weights = NULL;
+    picker->members = NULL;
+    picker->slots = NULL;
+    picker->capacity = 0;
+    picker->alias_empty = true;
+    picker->bag_key = 0;
+    picker->bag_position = 0;
+    picker->bag_half_bits = 1;
+    picker->played = NULL;
+    return picker;
+}
+
+static void deck_picker_drop_weights(DeckPicker* picker) {
+    free(picker->weights);
+    free(picker->members);
+    free(picker->slots);
+    picker->weights = NULL;
+    picker->members = NULL;
+    picker->slots = NULL;
+    picker->capacity = 0;
+}
+
+static void deck_picker_drop_played(DeckPicker* picker) {
+    free(picker->played);
+    picker->played = NULL;
+}
+
+static size_t deck_picker_played_size(size_t count) {
+    return (count + 7) / 8;
+}
+
+static bool deck_picker_is_played(const DeckPicker* picker, size_t deck) {
+    return picker->played && (picker->played[deck / 8] & (1U << (deck % 8)));
+}
+
+void deck_picker_free(DeckPicker* picker) {
+    furi_assert(picker);
+    deck_picker_drop_weights(picker);
+    deck_picker_drop_played(picker);
+    furi_string_free(picker->path);
+    furi_record_close(RECORD_STORAGE);
+    free(picker);
+}
+
+// Vose's method over the weight classes, exact in integers: class c carries
+// c * size(c), every entry is scaled so the mean equals the total, and each
+// short entry is topped up from a long one
+static void deck_picker_build_alias(DeckPicker* picker) {
+    uint64_t scaled[DECK_PICKER_CLASSES];
+    uint64_t total = 0;
+    for (size_t c = 0; c < DECK_PICKER_CLASSES; c++) {
+        scaled[c] = (uint64_t)c * (picker->class_start[c + 1] - picker->class_start[c]);
+        total += scaled[c];
+    }
+    picker->alias_empty = total == 0;
+    if (picker->alias_empty) return;
+
+    uint8_t small[DECK_PICKER_CLASSES];
+    uint8_t large[DECK_PICKER_CLASSES];
+    size_t small_count = 0;
+    size_t large_count = 0;
+    for (size_t c = 0; c < DECK_PICKER_CLASSES; c++) {
+        scaled[c] *= DECK_PICKER_CLASSES;
+        if (scaled[c] < total) {
+            small[small_count++] = c;
+        } else {
+            large[large_count++] = c;
+        }
+    }
+
+    while (small_count > 0 && large_count > 0) {
+        uint8_t short_class = small[--small_count];
+        uint8_t long_class = large[--large_count];
+        picker->alias_threshold[short_class] = scaled[short_class] * DECK_PICKER_ALIAS_FULL / total;
+        picker->alias[short_class] = long_class;
+        scaled[long_class] -= total - scaled[short_class];
+        if (scaled[long_class] < total) {
+            small[small_count++] = long_class;
+        } else {
+            large[large_count++] = long_class;
+        }
+    }
+    // The arithmetic is exact, so whatever is left stands at exactly the mean
+    while (large_count > 0) {
+        uint8_t c = large[--large_count];
+        picker->alias_threshold[c] = DECK_PICKER_ALIAS_FULL;
+        picker->alias[c] = c;
+    }
+    while (small_count > 0) {
+        uint8_t c = small[--small_count];
+        picker->alias_threshold[c] = DECK_PICKER_ALIAS_FULL;
+        picker->alias[c] = c;
+    }
+}
+
+static void deck_picker_reserve(DeckPicker* picker, size_t count) {
+    if (count <= picker->capacity) return;
+    size_t capacity = picker->capacity ? picker->capacity : DECK_PICKER_MIN_CAPACITY;
+    while (capacity < count) capacity *= 2;
+    picker->weights = realloc(picker->weights, capacity);
+    picker->members = realloc(picker->members, capacity * sizeof(uint16_t));
+    picker->slots = realloc(picker->slots, capacity * sizeof(uint16_t));
+    picker->capacity = capacity;
+}
+
+// Group decks by the weights already in place: a counting sort into members
+static void deck_picker_index_weights(DeckPicker* picker) {
+    uint32_t next[DECK_PICKER_CLASSES + 1] = {0};
+    for (size_t i = 0; i < picker->count; i++) {
+        next[picker->weights[i] + 1]++;
+    }
+    for (size_t c = 1; c <= DECK_PICKER_CLASSES; c++) {
+        next[c] += next[c - 1];
+    }
+    memcpy(picker->class_start, next, sizeof(picker->class_start));
+    for (size_t i = 0; i < picker->count; i++) {
+        uint32_t slot = next[picker->weights[i]]++;
+        picker->members[slot] = i;
+        picker->slots[i] = slot;
+    }
+    deck_picker_build_alias(picker);
+}
+
+// Start carrying weights, all at the default
+static bool deck_picker_track_weights(DeckPicker* picker) {
+    if (picker->weights) return true;
+    if (picker->count > DECK_PICKER_WEIGHTED_MAX) return false;
+
+    deck_picker_reserve(picker, picker->count);
+    memset(picker->weights, DECK_PICKER_WEIGHT_DEFAULT, picker->count);
+    deck_picker_index_weights(picker);
+    return true;
+}
+
+static void deck_picker_swap_slots(DeckPicker* picker, uint32_t a, uint32_t b) {
+    uint16_t deck_a = picker->members[a];
+    uint16_t deck_b = picker->members[b];
+    picker->members[a] = deck_b;
+    picker->members[b] = deck_a;
+    picker->slots[deck_b] = a;
+    picker->slots[deck_a] = b;
+}
+
+// Walk a deck across the class boundaries between its weight and the new one,
+// one swap per boundary
+static void deck_picker_move(DeckPicker* picker, size_t deck, uint8_t weight) {
+    uint8_t c = picker->weights[deck];
+    while (c < weight) {
+        uint32_t last = picker->class_start[c + 1] - 1;
+        deck_picker_swap_slots(picker, picker->slots[deck], last);
+        picker->class_start[c + 1]--;
+        c++;
+    }
+    while (c > weight) {
+        uint32_t first = picker->class_start[c];
+        deck_picker_swap_slots(picker, picker->slots[deck], first);
+        picker->class_start[c]++;
+        c--;
+    }
+    picker->weights[deck] = weight;
+}
+
+static void deck_picker_reset_bag(DeckPicker* picker) {
+    picker->bag_key = deck_picker_random();
+    picker->bag_position = 0;
+}
+
+static void deck_picker_set_count(DeckPicker* picker, size_t count) {
+    picker->count = count;
+    uint8_t half_bits = 1;
+    while (half_bits < 16 && ((uint64_t)1 << (2 * half_bits)) < count) half_bits++;
+    picker->bag_half_bits = half_bits;
+}
+
+static bool deck_picker_write(DeckPicker* picker, bool header_only) {
+    DeckPickerHeader header = {
+        .magic = DECK_PICKER_MAGIC,
+        .version = DECK_PICKER_VERSION,
+        .header_size = sizeof(DeckPickerHeader),
+        .mode = picker->mode,
+        .has_weights = picker->weights != NULL,
+        .has_played = picker->played != NULL,
+        .reserved = 0,
+        .count = picker->count,
+        .bag_key = picker->bag_key,
+        .bag_position = picker->bag_position,
+    };
+
+    File* file = storage_file_alloc(picker->storage);
+    const char* path = furi_string_get_cstr(picker->path);
+    bool success = false;
+    if (header_only) {
+        success = storage_file_open(file, path, FSAM_WRITE, FSOM_OPEN_EXISTING) &&
+                  mtg_file_write(file, &header, sizeof(header)) == sizeof(header);
+    } else if (storage_file_open(file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        success = mtg_file_write(file, &header, sizeof(header)) == sizeof(header);
+        if (success && picker->weights) {
+            success = mtg_file_write(file, picker->weights, picker->count) == picker->count;
+        }
+        if (success && picker->played) {
+            size_t size = deck_picker_played_size(picker->count);
+            success = mtg_file_write(file, picker->played, size) == size;
+        }
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if (!success) FURI_LOG_E("MTG", "Failed to write picker state");
+    return success;
+}
+
+void deck_picker_sync(DeckPicker* picker) {
+    furi_assert(picker);
+    if (!picker->dirty) return;
+    if (deck_picker_write(picker, false)) picker->dirty = false;
+}
+
+// Persist the mode and bag position, falling back to a full write if needed
+static void deck_picker_save_header(DeckPicker* picker) {
+    if (picker->dirty || !deck_picker_write(picker, true)) {
+        picker->dirty = true;
+        deck_picker_sync(picker);
+    }
+}
+
+void deck_picker_load(DeckPicker* picker, size_t count) {
+    furi_assert(picker);
+
+    deck_picker_drop_weights(picker);
+    deck_picker_drop_played(picker);
+    deck_picker_set_count(picker, count);
+    deck_picker_reset_bag(picker);
+    picker->dirty = true;
+
+    File* file = storage_file_alloc(picker->storage);
+    DeckPickerHeader header;
+    if (storage_file_open(file, furi_string_get_cstr(picker->path), FSAM_READ, FSOM_OPEN_EXISTING) &&
+       mtg_file_read(file, &header, sizeof(header)) == sizeof(header) &&
+       header.magic == DECK_PICKER_MAGIC && header.version == DECK_PICKER_VERSION &&
+       header.header_size >= sizeof(header)) {
+        // The mode is a preference and survives a list change; the rest does not
+        if (header.mode < DeckPickerModeCount) picker->mode = header.mode;
+
+        if (header.count != count) {
+            FURI_LOG_I("MTG", "Deck list changed, picker state starts over");
+        } else if (header.bag_position <= count) {
+            picker->bag_key = header.bag_key;
+            picker->bag_position = header.bag_position;
+            picker->dirty = false;
+
+            if (header.has_weights && count <= DECK_PICKER_WEIGHTED_MAX) {
+                deck_picker_reserve(picker, count);
+                bool valid = storage_file_seek(file, header.header_size, true) &&
+                             mtg_file_read(file, picker->weights, count) == count;
+                for (size_t i = 0; valid && i < count; i++) {
+                    valid = picker->weights[i] <= DECK_PICKER_WEIGHT_MAX;
+                }
+                if (valid) {
+                    deck_picker_index_weights(picker);
+                } else {
+                    FURI_LOG_W("MTG", "Ignoring damaged deck weights");
+                    deck_picker_drop_weights(picker);
+                    picker->dirty = true;
+                }
+            }
+
+            if (header.has_played) {
+                size_t offset = header.header_size + (header.has_weights ? count : 0);
+                size_t size = deck_picker_played_size(count);
+                picker->played = malloc(size);
+                if (!storage_file_seek(file, offset, true) ||
+                   mtg_file_read(file, picker->played, size) != size) {
+                    // Without the played bits the round would repeat decks
+                    FURI_LOG_W("MTG", "Ignoring damaged shuffle round");
+                    deck_picker_drop_played(picker);
+                    deck_picker_reset_bag(picker);
+                    picker->dirty = true;
+                }
+            }
+        }
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+}
+
+void deck_picker_set_mode(DeckPicker* picker, DeckPickerMode mode) {
+    furi_assert(picker);
+    furi_assert(mode < DeckPickerModeCount);
+    if (picker->mode == mode) return;
+    picker->mode = mode;
+    deck_picker_save_header(picker);
+}
+
+DeckPickerMode deck_picker_get_mode(const DeckPicker* picker) {
+    furi_assert(picker);
+    return picker->mode;
+}
+
+const char* deck_picker_mode_name(DeckPickerMode mode) {
+    switch (mode) {
+        case DeckPickerModeUniform:
+            return "Random";
+        case DeckPickerModeWeighted:
+            return "Weighted";
+        case DeckPickerModeShuffle:
+            return "Shuffle";
+        default:
+            return "?";
+    }
+}
+
+static size_t deck_picker_pick_weighted(DeckPicker* picker) {
+    if (!picker->weights || picker->alias_empty) {
+        return deck_picker_random_below(picker->count);
+    }
+
+    size_t c = deck_picker_random_below(DECK_PICKER_CLASSES);
+    if (deck_picker_random() >= picker->alias_threshold[c]) c = picker->alias[c];
+    uint32_t first = picker->class_start[c];
+    uint32_t size = picker->class_start[c + 1] - first;
+    furi_assert(size > 0);
+    return picker->members[first + deck_picker_random_below(size)];
+}
+
+static uint32_t deck_picker_round(uint32_t key, uint32_t round, uint32_t value) {
+    uint32_t hash = (value ^ key) + round * 0x9E3779B9U;
+    hash ^= hash >> 16;
+    hash *= 0x7FEB352DU;
+    hash ^= hash >> 15;
+    hash *= 0x846CA68BU;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// A balanced Feistel network is a bijection on [0, 4^half_bits); walking the
+// cycle until the result lands inside the list narrows it to [0, count). The
+// domain is under four times the count, so the walk stays short
+static size_t deck_picker_permute(const DeckPicker* picker, uint32_t position) {
+    uint32_t half_bits = picker->bag_half_bits;
+    uint32_t mask = (1U << half_bits) - 1;
+    uint32_t value = position;
+    do {
+        uint32_t left = value >> half_bits;
+        uint32_t right = value & mask;
+        for (uint32_t round = 0; round < DECK_PICKER_FEISTEL_ROUNDS; round++) {
+            uint32_t next = left ^ (deck_picker_round(picker->bag_key, round, right) & mask);
+            left = right;
+            right = next;
+        }
+        value = (left << half_bits) | right;
+    } while (value >= picker->count);
+    return value;
+}
+
+// Each skipped deck was drawn earlier in the round, so the skips over a whole
+// round add up to at most the list size
+static size_t deck_picker_pick_shuffle(DeckPicker* picker) {
+    size_t deck;
+    do {
+        if (picker->bag_position >= picker->count) {
+            if (picker->played) {
+                deck_picker_drop_played(picker);
+                picker->dirty = true;
+            }
+            deck_picker_reset_bag(picker);
+        }
+        deck = deck_picker_permute(picker, picker->bag_position++);
+    } while (deck_picker_is_played(picker, deck));
+    deck_picker_save_header(picker);
+    return deck;
+}
+
+size_t deck_picker_pick(DeckPicker* picker) {
+    furi_assert(picker);
+    furi_assert(picker->count > 0);
+
+    switch (picker->mode) {
+        case DeckPickerModeWeighted:
+            return deck_picker_pick_weighted(picker);
+        case DeckPickerModeShuffle:
+            return deck_picker_pick_shuffle(picker);
+        default:
+            return deck_picker_random_below(picker->count);
+    }
+}
+
+uint8_t deck_picker_get_weight(const DeckPicker* picker, size_t index) {
+    furi_assert(picker);
+    furi_assert(index < picker->count);
+    return picker->weights ? picker->weights[index] : DECK_PICKER_WEIGHT_DEFAULT;
+}
+
+bool deck_picker_set_weight(DeckPicker* picker, size_t index, uint8_t weight) {
+    furi_assert(picker);
+    furi_assert(index < picker->count);
+    furi_assert(weight <= DECK_PICKER_WEIGHT_MAX);
+
+    if (deck_picker_get_weight(picker, index) == weight) return true;
+    bool had_weights = picker->weights != NULL;
+    if (!deck_picker_track_weights(picker)) return false;
+
+    deck_picker_move(picker, index, weight);
+    deck_picker_build_alias(picker);
+
+    if (!had_weights || picker->dirty) {
+        picker->dirty = true;
+        deck_picker_sync(picker);
+        return true;
+    }
+
+    File* file = storage_file_alloc(picker->storage);
+    bool patched =
+        storage_file_open(file, furi_string_get_cstr(picker->path), FSAM_WRITE, FSOM_OPEN_EXISTING) &&
+        storage_file_seek(file, sizeof(DeckPickerHeader) + index, true) &&
+        mtg_file_write(file, &weight, 1) == 1;
+    storage_file_close(file);
+    storage_file_free(file);
+    if (!patched) {
+        picker->dirty = true;
+        deck_picker_sync(picker);
+    }
+    return true;
+}
+
+// Where a deck of the old list lands after an insert (added) or a remove
+// (!added) at index; the removed deck itself has no place
+static size_t deck_picker_shift(size_t deck, size_t index, bool added) {
+    if (deck < index) return deck;
+    return added ? deck + 1 : deck - 1;
+}
+
+// Carry the round across a list change: collect every deck drawn so far at
+// its new position and start a fresh bag that skips them. A removed deck
+// leaves the round; an added one has not been drawn yet
+static void deck_picker_follow_bag(DeckPicker* picker, size_t index, bool added) {
+    size_t count = added ? picker->count + 1 : picker->count - 1;
+    bool round_over = picker->bag_position >= picker->count;
+    bool round_started = picker->bag_position > 0 || picker->played;
+
+    uint8_t* played = NULL;
+    size_t played_count = 0;
+    if (round_started && !round_over) {
+        size_t size = deck_picker_played_size(count);
+        played = malloc(size);
+        memset(played, 0, size);
+        for (size_t deck = 0; deck < picker->count; deck++) {
+            if (!deck_picker_is_played(picker, deck)) continue;
+            if (!added && deck == index) continue;
+            size_t moved = deck_picker_shift(deck, index, added);
+            played[moved / 8] |= 1U << (moved % 8);
+            played_count++;
+        }
+        // The bag never draws a deck that is already in the played bits
+        for (uint32_t position = 0; position < picker->bag_position; position++) {
+            size_t deck = deck_picker_permute(picker, position);
+            if (deck_picker_is_played(picker, deck)) continue;
+            if (!added && deck == index) continue;
+            size_t moved = deck_picker_shift(deck, index, added);
+            played[moved / 8] |= 1U << (moved % 8);
+            played_count++;
+        }
+    }
+
+    deck_picker_drop_played(picker);
+    if (played_count > 0 && played_count < count) {
+        picker->played = played;
+    } else {
+        // Nothing drawn yet, or nothing left to draw: a plain bag will do
+        free(played);
+    }
+    deck_picker_set_count(picker, count);
+    deck_picker_reset_bag(picker);
+}
+
+void deck_picker_insert(DeckPicker* picker, size_t index) {
+    furi_assert(picker);
+    furi_assert(index <= picker->count);
+
+    size_t count = picker->count;
+    if (picker->weights && count + 1 > DECK_PICKER_WEIGHTED_MAX) {
+        FURI_LOG_W("MTG", "Deck list too long for weights");
+        deck_picker_drop_weights(picker);
+    }
+
+    if (picker->weights) {
+        deck_picker_reserve(picker, count + 1);
+        for (size_t slot = 0; slot < count; slot++) {
+            if (picker->members[slot] >= index) picker->members[slot]++;
+        }
+        memmove(&picker->weights[index + 1], &picker->weights[index], count - index);
+        memmove(&picker->slots[index + 1], &picker->slots[index], (count - index) * sizeof(uint16_t));
+
+        // Enter at the end of the heaviest class, then walk down to the default
+        picker->members[count] = index;
+        picker->slots[index] = count;
+        picker->weights[index] = DECK_PICKER_WEIGHT_MAX;
+        picker->class_start[DECK_PICKER_CLASSES] = count + 1;
+        deck_picker_move(picker, index, DECK_PICKER_WEIGHT_DEFAULT);
+        deck_picker_build_alias(picker);
+    }
+
+    deck_picker_follow_bag(picker, index, true);
+    picker->dirty = true;
+}
+
+void deck_picker_remove(DeckPicker* picker, size_t index) {
+    furi_assert(picker);
+    furi_assert(index < picker->count);
+
+    size_t count = picker->count - 1;
+    if (picker->weights) {
+        // Walk up to the heaviest class and out of its last slot
+        deck_picker_move(picker, index, DECK_PICKER_WEIGHT_MAX);
+        deck_picker_swap_slots(picker, picker->slots[index], count);
+        picker->class_start[DECK_PICKER_CLASSES] = count;
+
+        memmove(&picker->weights[index], &picker->weights[index + 1], count - index);
+        memmove(&picker->slots[index], &picker->slots[index + 1], (count - index) * sizeof(uint16_t));
+        for (size_t slot = 0; slot < count; slot++) {
+            if (picker->members[slot] > index) picker->members[slot]--;
+        }
+        deck_picker_build_alias(picker);
+    }
+
+    deck_picker_follow_bag(picker, index, false);
+    picker->dirty = true;
+}
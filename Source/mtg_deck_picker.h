@@ -0,0 +1,79 @@
+#pragma once
+
+#include <furi.h>
+
+/* Random deck selection
+ *
+ *   uniform   every deck equally likely
+ *   weighted  decks drawn in proportion to a 0..DECK_PICKER_WEIGHT_MAX weight;
+ *             0 takes a deck out of the draw
+ *   shuffle   every deck once, in random order, before any deck repeats
+ *
+ * All randomness comes from furi_hal_random through rejection sampling, so no
+ * deck is favoured by modulo bias. Picks are O(1) in every mode, amortised
+ * over a round for shuffle after the list changed. A seed swaps
+ * the hardware source for a repeatable one, so a recorded session can be
+ * replayed draw for draw.
+ *
+ * Weighted picks use a Vose alias table over the weight classes rather than
+ * over the decks: the table has DECK_PICKER_WEIGHT_MAX + 1 entries whatever
+ * the list size, and a weight change moves one deck between classes and
+ * rebuilds that small table. The shuffle bag is a keyed permutation of the
+ * list, so its whole state is a key and a position. Inserting or removing a
+ * deck mid-round keeps the round: the decks already drawn are held as one bit
+ * per deck and skipped until the round ends, and a new deck joins the decks
+ * still to come.
+ *
+ * Mode, weights and bag state are persisted in a small state file that
+ * follows deck positions; it is reset when the deck count no longer matches.
+ */
+
+#define DECK_PICKER_WEIGHT_MAX     9
+#define DECK_PICKER_WEIGHT_DEFAULT 1
+// Weights are kept for lists up to this size; longer lists are drawn uniformly
+#define DECK_PICKER_WEIGHTED_MAX   UINT16_MAX
+
+typedef enum {
+    DeckPickerModeUniform,
+    DeckPickerModeWeighted,
+    DeckPickerModeShuffle,
+    DeckPickerModeCount,
+} DeckPickerMode;
+
+typedef struct DeckPicker DeckPicker;
+
+DeckPicker* deck_picker_alloc(const char* state_path);
+
+void deck_picker_free(DeckPicker* picker);
+
+/** Restore the persisted state for a list of count decks, or start afresh */
+void deck_picker_load(DeckPicker* picker, size_t count);
+
+/** Write the state file if anything beyond the bag position changed */
+void deck_picker_sync(DeckPicker* picker);
+
+void deck_picker_set_mode(DeckPicker* picker, DeckPickerMode mode);
+
+DeckPickerMode deck_picker_get_mode(const DeckPicker* picker);
+
+const char* deck_picker_mode_name(DeckPickerMode mode);
+
+/** Pick a deck position; the list must not be empty */
+size_t deck_picker_pick(DeckPicker* picker);
+
+uint8_t deck_picker_get_weight(const DeckPicker* picker, size_t index);
+
+/** @return false if the list is too long to carry weights */
+bool deck_picker_set_weight(DeckPicker* picker, size_t index, uint8_t weight);
+
+/** Follow the deck list: a deck was inserted at index, with the default weight */
+void deck_picker_insert(DeckPicker* picker, size_t index);
+
+/** Follow the deck list: the deck at index was removed */
+void deck_picker_remove(DeckPicker* picker, size_t index);
+
+/** Uniform integer in [0, bound) without modulo bias */
+uint32_t deck_picker_random_below(uint32_t bound);
+
+/** Draw from a repeatable sequence started at seed, or from furi_hal_random again for 0 */
+void deck_picker_random_seed(uint32_t seed);
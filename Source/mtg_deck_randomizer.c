@@ -1,513 +1,2239 @@
-#include <furi.h>
-#include <gui/gui.h>
-#include <input/input.h>
-#include <stdlib.h>
-#include <string.h>
-#include <storage/storage.h>
-#include <furi_hal.h>
-
-#define MAX_DECKS 10
-#define MAX_NAME_LENGTH 20
-#define SPIN_DURATION 3000
-#define BLINK_INTERVAL 500
-#define SPIN_SPEED 8
-#define BLINK_DURATION 3000
-#define KEYBOARD_ROW_COUNT 3
-
-typedef struct {
-    char name[MAX_NAME_LENGTH];
-} Deck;
-
-typedef enum {
-    StateMainMenu,
-    StateSpinning,
-    StateSelected,
-    StateDeckList,
-    StateKeyboard,
-    StateEditDeletePopup
-} AppState;
-
-typedef struct {
-    char text;
-    uint8_t x;
-    uint8_t y;
-} KeyboardKey;
-
-typedef struct {
-    Deck decks[MAX_DECKS];
-    int deck_count;
-    int current_deck;
-    int selected_deck;
-    AppState state;
-    uint32_t spin_start_time;
-    char edit_buffer[MAX_NAME_LENGTH];
-    int spin_offset;
-    uint32_t blink_start_time;
-    bool is_blinking;
-    uint8_t selected_row;
-    uint8_t selected_column;
-    int scroll_position;
-} MTGDeckRandomizer;
-
-static const uint8_t keyboard_origin_x = 1;
-static const uint8_t keyboard_origin_y = 29;
-
-#define ENTER_KEY '\r'
-#define BACKSPACE_KEY '\b'
-
-static const KeyboardKey keyboard_keys_row_1[] = {
-    {'q', 1, 8},  {'w', 10, 8}, {'e', 19, 8}, {'r', 28, 8},  {'t', 37, 8},  {'y', 46, 8},
-    {'u', 55, 8}, {'i', 64, 8}, {'o', 73, 8}, {'p', 82, 8},  {'1', 91, 8},  {'2', 100, 8},
-    {'3', 109, 8}
-};
-
-static const KeyboardKey keyboard_keys_row_2[] = {
-    {'a', 1, 20},  {'s', 10, 20}, {'d', 19, 20}, {'f', 28, 20}, {'g', 37, 20}, {'h', 46, 20},
-    {'j', 55, 20}, {'k', 64, 20}, {'l', 73, 20}, {BACKSPACE_KEY, 82, 20},
-    {'4', 100, 20}, {'5', 109, 20}, {'6', 118, 20}
-};
-
-static const KeyboardKey keyboard_keys_row_3[] = {
-    {'z', 1, 32},  {'x', 10, 32}, {'c', 19, 32}, {'v', 28, 32}, {'b', 37, 32}, {'n', 46, 32},
-    {'m', 55, 32}, {'_', 64, 32}, {ENTER_KEY, 73, 32},
-    {'7', 100, 32}, {'8', 109, 32}, {'9', 118, 32}
-};
-
-static void save_decks(MTGDeckRandomizer* mtg) {
-    Storage* storage = furi_record_open(RECORD_STORAGE);
-    FuriString* path = furi_string_alloc_set("/ext/apps/MTG/mtg_decks.txt");
-    File* file = storage_file_alloc(storage);
-
-    FURI_LOG_I("MTG", "Saving decks to %s", furi_string_get_cstr(path));
-
-    if (storage_file_open(file, furi_string_get_cstr(path), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
-        for (int i = 0; i < mtg->deck_count; i++) {
-            storage_file_write(file, mtg->decks[i].name, strlen(mtg->decks[i].name));
-            storage_file_write(file, "\n", 1);
-            FURI_LOG_I("MTG", "Saved deck: %s", mtg->decks[i].name);
-        }
-        FURI_LOG_I("MTG", "Successfully saved %d decks", mtg->deck_count);
-    } else {
-        FURI_LOG_E("MTG", "Failed to open file for writing");
-    }
-
-    storage_file_close(file);
-    storage_file_free(file);
-    furi_string_free(path);
-    furi_record_close(RECORD_STORAGE);
-}
-
-static void load_decks(MTGDeckRandomizer* mtg) {
-    Storage* storage = furi_record_open(RECORD_STORAGE);
-    FuriString* path = furi_string_alloc_set("/ext/apps/MTG/mtg_decks.txt");
-    File* file = storage_file_alloc(storage);
-
-    FURI_LOG_I("MTG", "Loading decks from %s", furi_string_get_cstr(path));
-
-    mtg->deck_count = 0;
-
-    if (storage_file_open(file, furi_string_get_cstr(path), FSAM_READ, FSOM_OPEN_EXISTING)) {
-        char buffer[MAX_NAME_LENGTH];
-        size_t bytes_read;
-        size_t line_start = 0;
-
-        while ((bytes_read = storage_file_read(file, buffer + line_start, sizeof(buffer) - line_start - 1)) > 0) {
-            buffer[line_start + bytes_read] = '\0';
-            char* line_end;
-            char* line = buffer;
-
-            while ((line_end = strchr(line, '\n')) != NULL && mtg->deck_count < MAX_DECKS) {
-                *line_end = '\0';
-                if (line_end > line) {  // Ignore empty lines
-                    strncpy(mtg->decks[mtg->deck_count].name, line, MAX_NAME_LENGTH - 1);
-                    mtg->decks[mtg->deck_count].name[MAX_NAME_LENGTH - 1] = '\0';
-                    FURI_LOG_I("MTG", "Loaded deck: %s", mtg->decks[mtg->deck_count].name);
-                    mtg->deck_count++;
-                }
-                line = line_end + 1;
-            }
-
-            line_start = strlen(line);
-            memmove(buffer, line, line_start);
-        }
-
-        // Handle last line if file doesn't end with a newline
-        if (line_start > 0 && mtg->deck_count < MAX_DECKS) {
-            strncpy(mtg->decks[mtg->deck_count].name, buffer, MAX_NAME_LENGTH - 1);
-            mtg->decks[mtg->deck_count].name[MAX_NAME_LENGTH - 1] = '\0';
-            FURI_LOG_I("MTG", "Loaded deck: %s", mtg->decks[mtg->deck_count].name);
-            mtg->deck_count++;
-        }
-
-        FURI_LOG_I("MTG", "Successfully loaded %d decks", mtg->deck_count);
-        for (int i = 0; i < mtg->deck_count; i++) {
-            FURI_LOG_I("MTG", "Loaded deck %d: %s", i, mtg->decks[i].name);
-        }
-    } else {
-        FURI_LOG_W("MTG", "Failed to open file for reading, creating default decks");
-        strcpy(mtg->decks[0].name, "Red Aggro");
-        strcpy(mtg->decks[1].name, "Blue Control");
-        strcpy(mtg->decks[2].name, "Green Ramp");
-        mtg->deck_count = 3;
-        FURI_LOG_I("MTG", "Created default decks");
-        save_decks(mtg);
-    }
-
-    storage_file_close(file);
-    storage_file_free(file);
-    furi_string_free(path);
-    furi_record_close(RECORD_STORAGE);
-
-    if (mtg->deck_count == 0) {
-        FURI_LOG_E("MTG", "No decks loaded or created. This should not happen.");
-    }
-}
-
-static uint8_t get_row_size(uint8_t row_index) {
-    switch(row_index) {
-        case 0: return sizeof(keyboard_keys_row_1) / sizeof(keyboard_keys_row_1[0]);
-        case 1: return sizeof(keyboard_keys_row_2) / sizeof(keyboard_keys_row_2[0]);
-        case 2: return sizeof(keyboard_keys_row_3) / sizeof(keyboard_keys_row_3[0]);
-        default: return 0;
-    }
-}
-
-static const KeyboardKey* get_row(uint8_t row_index) {
-    switch(row_index) {
-        case 0: return keyboard_keys_row_1;
-        case 1: return keyboard_keys_row_2;
-        case 2: return keyboard_keys_row_3;
-        default: return NULL;
-    }
-}
-
-static void draw_keyboard(Canvas* canvas, MTGDeckRandomizer* mtg) {
-    canvas_set_font(canvas, FontSecondary);
-    canvas_draw_str(canvas, 2, 10, "Add your deckname:");
-    canvas_draw_str(canvas, 2, 22, mtg->edit_buffer);
-
-    canvas_set_font(canvas, FontKeyboard);
-
-    for(uint8_t row = 0; row < KEYBOARD_ROW_COUNT; row++) {
-        const uint8_t column_count = get_row_size(row);
-        const KeyboardKey* keys = get_row(row);
-
-        for(size_t column = 0; column < column_count; column++) {
-            int x = keyboard_origin_x + keys[column].x;
-            int y = keyboard_origin_y + keys[column].y;
-
-            if(keys[column].text == ENTER_KEY) {
-                canvas_set_font(canvas, FontSecondary);
-                canvas_draw_str(canvas, x, y, "save");
-                if(mtg->selected_row == row && mtg->selected_column == column) {
-                    canvas_draw_frame(canvas, x - 1, y - 8, 24, 11);
-                }
-            } else if(keys[column].text == BACKSPACE_KEY) {
-                canvas_set_font(canvas, FontSecondary);
-                canvas_draw_str(canvas, x, y, "bck");
-                if(mtg->selected_row == row && mtg->selected_column == column) {
-                    canvas_draw_frame(canvas, x - 1, y - 8, 18, 11);
-                }
-            } else {
-                canvas_set_font(canvas, FontKeyboard);
-                if(mtg->selected_row == row && mtg->selected_column == column) {
-                    canvas_draw_frame(canvas, x - 1, y - 8, 7, 10);
-                }
-                canvas_draw_glyph(canvas, x, y, keys[column].text);
-            }
-        }
-    }
-}
-
-static void mtg_deck_randomizer_draw_callback(Canvas* canvas, void* ctx) {
-    MTGDeckRandomizer* mtg = ctx;
-    canvas_clear(canvas);
-    canvas_set_font(canvas, FontSecondary);
-
-    switch (mtg->state) {
-        case StateMainMenu:
-            canvas_draw_str_aligned(canvas, 64, 10, AlignCenter, AlignTop, "MTG Deck Randomizer");
-            canvas_draw_str_aligned(canvas, 64, 32, AlignCenter, AlignCenter, mtg->decks[mtg->current_deck].name);
-            canvas_set_font(canvas, FontSecondary);
-            canvas_draw_str_aligned(canvas, 64, 60, AlignCenter, AlignBottom, "OK: Spin | Down: Edit Decks");
-            break;
-        case StateSpinning:
-            {
-                uint32_t elapsed = furi_get_tick() - mtg->spin_start_time;
-                if (elapsed < SPIN_DURATION) {
-                    mtg->spin_offset = (mtg->spin_offset + SPIN_SPEED) % 128;
-                    for (int i = 0; i < mtg->deck_count; i++) {
-                        int y = 32 + (i * 16 - mtg->spin_offset + 128) % 128 - 64;
-                        canvas_draw_str_aligned(canvas, 64, y, AlignCenter, AlignCenter, mtg->decks[i].name);
-                    }
-                } else {
-                    mtg->state = StateSelected;
-                    mtg->blink_start_time = furi_get_tick();
-                }
-            }
-            break;
-        case StateSelected:
-            {
-                uint32_t elapsed = furi_get_tick() - mtg->blink_start_time;
-                if (elapsed < BLINK_DURATION) {
-                    if ((elapsed / BLINK_INTERVAL) % 2 == 0) {
-                        canvas_draw_str_aligned(canvas, 64, 32, AlignCenter, AlignCenter, mtg->decks[mtg->current_deck].name);
-                    }
-                } else {
-                    mtg->state = StateMainMenu;
-                }
-            }
-            break;
-        case StateDeckList:
-            canvas_draw_str_aligned(canvas, 64, 0, AlignCenter, AlignTop, "Deck List");
-            int visible_items = 6;
-            int start_index = MAX(0, mtg->selected_deck - visible_items / 2);
-            int end_index = MIN(start_index + visible_items, mtg->deck_count + 1);
-
-            for (int i = start_index; i < end_index; i++) {
-                int y = 10 + (i - start_index) * 9;
-                if (i < mtg->deck_count) {
-                    canvas_draw_str_aligned(canvas, 5, y, AlignLeft, AlignTop, mtg->decks[i].name);
-                } else {
-                    canvas_draw_str_aligned(canvas, 5, y, AlignLeft, AlignTop, "Add New Deck");
-                }
-                if (i == mtg->selected_deck) {
-                    canvas_draw_str_aligned(canvas, 0, y, AlignLeft, AlignTop, ">");
-                }
-            }
-
-            if (start_index > 0) {
-                canvas_draw_str_aligned(canvas, 124, 10, AlignRight, AlignTop, "^");
-            }
-            if (end_index < mtg->deck_count + 1) {
-                canvas_draw_str_aligned(canvas, 124, 62, AlignRight, AlignBottom, "v");
-            }
-            break;
-        case StateKeyboard:
-            draw_keyboard(canvas, mtg);
-            break;
-        case StateEditDeletePopup: {
-            // Draw the deck list in the background
-            mtg->state = StateDeckList;
-            mtg_deck_randomizer_draw_callback(canvas, ctx);
-            mtg->state = StateEditDeletePopup;
-
-            // Draw the popup
-            canvas_set_color(canvas, ColorWhite);
-            canvas_draw_box(canvas, 22, 17, 84, 32);
-            canvas_set_color(canvas, ColorBlack);
-            canvas_draw_frame(canvas, 22, 17, 84, 32);
-            canvas_draw_str_aligned(canvas, 64, 20, AlignCenter, AlignTop, "Left: Delete");
-            canvas_draw_str_aligned(canvas, 64, 30, AlignCenter, AlignTop, "Right: Edit");
-            canvas_draw_str_aligned(canvas, 64, 40, AlignCenter, AlignTop, "Back: Cancel");
-            break;
-        }
-        default:
-            FURI_LOG_E("MTG", "Unknown state in draw callback");
-            break;
-    }
-}
-
-static void handle_keyboard_input(MTGDeckRandomizer* mtg, InputEvent input) {
-    if (input.type == InputTypeShort || input.type == InputTypeLong) {
-        switch (input.key) {
-            case InputKeyUp:
-                if (mtg->selected_row > 0) mtg->selected_row--;
-                break;
-            case InputKeyDown:
-                if (mtg->selected_row < KEYBOARD_ROW_COUNT - 1) mtg->selected_row++;
-                break;
-            case InputKeyLeft:
-                if (mtg->selected_column > 0) mtg->selected_column--;
-                break;
-            case InputKeyRight:
-                if (mtg->selected_column < get_row_size(mtg->selected_row) - 1) mtg->selected_column++;
-                break;
-            case InputKeyOk:
-                {
-                    const KeyboardKey* keys = get_row(mtg->selected_row);
-                    char key = keys[mtg->selected_column].text;
-                    size_t len = strlen(mtg->edit_buffer);
-                    if (key == BACKSPACE_KEY) {
-                        if (len > 0) mtg->edit_buffer[len - 1] = '\0';
-                    } else if (key == ENTER_KEY) {
-                        if (len > 0) {
-                            if (mtg->selected_deck < mtg->deck_count) {
-                                // Editing existing deck
-                                strcpy(mtg->decks[mtg->selected_deck].name, mtg->edit_buffer);
-                            } else if (mtg->deck_count < MAX_DECKS) {
-                                // Adding new deck
-                                strcpy(mtg->decks[mtg->deck_count].name, mtg->edit_buffer);
-                                mtg->deck_count++;
-                            }
-                            save_decks(mtg);
-                            mtg->state = StateDeckList;
-                        }
-                    } else if (len < MAX_NAME_LENGTH - 1) {
-                        if (input.type == InputTypeLong && key >= 'a' && key <= 'z') {
-                            key = key - 'a' + 'A';
-                        }
-                        mtg->edit_buffer[len] = key;
-                        mtg->edit_buffer[len + 1] = '\0';
-                    }
-                }
-                break;
-            default:
-                break;
-        }
-    }
-}
-
-static void mtg_deck_randomizer_input_callback(InputEvent* input_event, void* ctx) {
-    furi_assert(ctx);
-    FuriMessageQueue* event_queue = ctx;
-    furi_message_queue_put(event_queue, input_event, FuriWaitForever);
-}
-
-static void mtg_deck_randomizer_update_state(MTGDeckRandomizer* mtg, InputEvent input) {
-    switch (mtg->state) {
-        case StateMainMenu:
-            if (input.key == InputKeyOk) {
-                mtg->state = StateSpinning;
-                mtg->spin_start_time = furi_get_tick();
-                mtg->spin_offset = 0;
-                mtg->current_deck = rand() % mtg->deck_count;
-            } else if (input.key == InputKeyDown) {
-                mtg->state = StateDeckList;
-                mtg->selected_deck = 0;
-            }
-            break;
-        case StateSpinning:
-            // Handle spinning state if needed
-            break;
-        case StateSelected:
-            if (input.key == InputKeyOk) {
-                mtg->state = StateMainMenu;
-            }
-            break;
-        case StateDeckList:
-            if (input.type == InputTypeShort) {
-                if (input.key == InputKeyOk) {
-                    if (mtg->selected_deck == mtg->deck_count) {
-                        mtg->state = StateKeyboard;
-                        memset(mtg->edit_buffer, 0, sizeof(mtg->edit_buffer));
-                        mtg->selected_row = 0;
-                        mtg->selected_column = 0;
-                    } else {
-                        mtg->current_deck = mtg->selected_deck;
-                        mtg->state = StateMainMenu;
-                    }
-                } else if (input.key == InputKeyUp) {
-                    if (mtg->selected_deck > 0) {
-                        mtg->selected_deck--;
-                        if (mtg->selected_deck < mtg->scroll_position) {
-                            mtg->scroll_position = mtg->selected_deck;
-                        }
-                    }
-                } else if (input.key == InputKeyDown) {
-                    if (mtg->selected_deck < mtg->deck_count) {
-                        mtg->selected_deck++;
-                        if (mtg->selected_deck >= mtg->scroll_position + 4) {
-                            mtg->scroll_position = mtg->selected_deck - 3;
-                        }
-                    }
-                }
-            } else if (input.type == InputTypeLong && input.key == InputKeyOk && mtg->selected_deck < mtg->deck_count) {
-                mtg->state = StateEditDeletePopup;
-            }
-            break;
-        case StateKeyboard:
-            handle_keyboard_input(mtg, input);
-            break;
-        case StateEditDeletePopup:
-            if (input.type == InputTypeShort) {
-                if (input.key == InputKeyLeft) {
-                    // Delete deck
-                    for (int i = mtg->selected_deck; i < mtg->deck_count - 1; i++) {
-                        strcpy(mtg->decks[i].name, mtg->decks[i + 1].name);
-                    }
-                    mtg->deck_count--;
-                    save_decks(mtg);
-                    mtg->state = StateDeckList;
-                } else if (input.key == InputKeyRight) {
-                    // Edit deck
-                    strcpy(mtg->edit_buffer, mtg->decks[mtg->selected_deck].name);
-                    mtg->state = StateKeyboard;
-                } else if (input.key == InputKeyBack) {
-                    mtg->state = StateDeckList;
-                }
-            }
-            break;
-    }
-
-    if (input.key == InputKeyBack) {
-        switch (mtg->state) {
-            case StateMainMenu:
-                // Exit the app
-                break;
-            case StateSpinning:
-            case StateSelected:
-            case StateDeckList:
-                mtg->state = StateMainMenu;
-                break;
-            case StateKeyboard:
-            case StateEditDeletePopup:
-                mtg->state = StateDeckList;
-                break;
-        }
-    }
-}
-
-int32_t mtg_deck_randomizer_app(void* p) {
-    UNUSED(p);
-    MTGDeckRandomizer* mtg = malloc(sizeof(MTGDeckRandomizer));
-
-    // Initialize MTGDeckRandomizer
-    mtg->current_deck = 0;
-    mtg->selected_deck = 0;
-    mtg->state = StateMainMenu;
-    mtg->spin_start_time = 0;
-    mtg->spin_offset = 0;
-    mtg->blink_start_time = 0;
-    mtg->is_blinking = false;
-    mtg->selected_row = 0;
-    mtg->selected_column = 0;
-    mtg->scroll_position = 0;
-    
-    // Load decks from storage
-    load_decks(mtg);
-
-    // Create GUI
-    Gui* gui = furi_record_open(RECORD_GUI);
-    ViewPort* view_port = view_port_alloc();
-    view_port_draw_callback_set(view_port, mtg_deck_randomizer_draw_callback, mtg);
-    gui_add_view_port(gui, view_port, GuiLayerFullscreen);
-
-    // Create event queue
-    FuriMessageQueue* event_queue = furi_message_queue_alloc(8, sizeof(InputEvent));
-    view_port_input_callback_set(view_port, mtg_deck_randomizer_input_callback, event_queue);
-
-    // Main loop
-    InputEvent event;
-    bool running = true;
-    while(running) {
-        if(furi_message_queue_get(event_queue, &event, 100) == FuriStatusOk) {
-            if(event.key == InputKeyBack && event.type == InputTypeLong && mtg->state == StateMainMenu) {
-                running = false;
-            } else {
-                mtg_deck_randomizer_update_state(mtg, event);
-            }
-        }
-        view_port_update(view_port);
-    }
-
-    // Cleanup
-    view_port_enabled_set(view_port, false);
-    gui_remove_view_port(gui, view_port);
-    view_port_free(view_port);
-    furi_message_queue_free(event_queue);
-    furi_record_close(RECORD_GUI);
-    free(mtg);
-
-    return 0;
-}
\ No newline at end of file
+#include <furi.h>
+#include <gui/gui.h>
+#include <input/input.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <storage/storage.h>
+#include <furi_hal.h>
+
+#include "mtg_line_reader.h"
+#include "mtg_deck_store.h"
+#include "mtg_deck_index.h"
+#include "mtg_name_cache.h"
+#include "mtg_deck_journal.h"
+#include "mtg_storage_helpers.h"
+#include "mtg_storage_worker.h"
+#include "mtg_deck_picker.h"
+#include "mtg_play_log.h"
+#include "mtg_deck_meta.h"
+#include "mtg_deck_filter.h"
+#include "mtg_pod.h"
+#include "mtg_deck_search.h"
+#include "mtg_deck_lists.h"
+#include "mtg_input.h"
+#include "mtg_perf.h"
+#include "mtg_trace.h"
+#include "mtg_keyboard.h"
+#include "mtg_deck_import.h"
+
+#define MAX_NAME_LENGTH 48
+#define APP_FOLDER "/ext/apps/MTG"
+#define DECK_LISTS_PATH "/ext/apps/MTG/mtg_lists.bin"
+#define DECK_LIST_DEFAULT "mtg_decks"
+#define PLAY_HISTORY_PATH "/ext/apps/MTG/mtg_history.bin"
+#define PLAY_STATS_PATH "/ext/apps/MTG/mtg_stats.bin"
+#define PLAY_HISTORY_SIZE 256
+#define PERF_CSV_PATH "/ext/apps/MTG/mtg_perf.csv"
+#define TRACE_PATH "/ext/apps/MTG/mtg_trace.bin"
+#define REPLAY_REPORT_PATH "/ext/apps/MTG/mtg_replay.log"
+#define REPLAY_REPORT_BLOCK_SIZE 512
+#define IMPORT_FOLDER "/ext/apps/MTG/import"
+#define IMPORT_ROWS_PER_FRAME 64
+#define DECKS_JOURNAL_COMPACT_SIZE 4096
+#define DECKS_SAVE_BLOCK_SIZE 512
+#define NAME_CACHE_SLOTS 16
+#define DECK_LIST_VISIBLE_ITEMS 6
+#define DECK_LIST_PREFETCH 4
+#define SCROLL_PAGES 32 // a held key's page jumps cross any list in about this many
+#define STATS_VISIBLE_ITEMS 5
+#define SEARCH_VISIBLE_ITEMS 5
+#define LISTS_VISIBLE_ITEMS 5
+#define FILTER_META_BATCH 64
+#define FILTER_PICK_TRIES 32
+#define FRAME_RATE 30
+#define SPIN_DURATION 3000
+#define BLINK_INTERVAL 500
+#define SPIN_SPEED 80 // average px per second
+#define SPIN_ROW_HEIGHT 16
+#define SPIN_VISIBLE_ROWS 5 // rows around the centre line that can reach the 64 px screen
+#define SPIN_WIDTH_CACHE_SIZE 32 // power of two, comfortably above SPIN_VISIBLE_ROWS
+#define BLINK_DURATION 3000
+#define POD_SEATS_DEFAULT 4
+#define POD_REEL_STEPS 24 // names each seat runs through before it stops
+#define POD_SEAT_STAGGER 300 // ms between seats coming to rest
+
+typedef enum {
+    StateMainMenu,
+    StateSpinning,
+    StateSelected,
+    StateDeckList,
+    StateKeyboard,
+    StateEditDeletePopup,
+    StateStats,
+    StateFilter,
+    StatePodSetup,
+    StatePodSpinning,
+    StatePodSelected,
+    StateSearch,
+    StateSearchResults,
+    StateLists,
+    StateImport
+} AppState;
+
+typedef enum {
+    MTGEventTypeInput,
+    MTGEventTypeStorage,
+    MTGEventTypeFrame,
+} MTGEventType;
+
+typedef struct {
+    MTGEventType type;
+} MTGEvent;
+
+typedef struct {
+    int index;
+    uint16_t width;
+} SpinTextWidth;
+
+typedef enum {
+    FilterRowColors,
+    FilterRowBracket,
+    FilterRowTag,
+    FilterRowClear,
+    FilterRowCount
+} FilterRow;
+
+typedef enum {
+    PodRowSeats,
+    PodRowSpread,
+    PodRowCount
+} PodRow;
+
+typedef struct {
+    FuriMutex* mutex;
+    FuriMessageQueue* event_queue;
+    InputPipeline* input;
+    bool running;
+    bool perf_overlay;
+    TraceRecorder* trace;
+    // While replaying, time comes from the trace rather than the system clocks
+    bool replaying;
+    uint32_t replay_tick;
+    uint32_t replay_timestamp;
+    FuriTimer* frame_timer;
+    bool dirty;
+    StorageWorker* storage;
+    DeckLists* lists;
+    DeckListPaths paths;
+    size_t lists_selected;
+    DeckPicker* picker;
+    PlayLog* plays;
+    DeckFilter* filter;
+    DeckFilterRule filter_rule;
+    bool filter_stale;
+    uint8_t filter_row;
+    uint8_t filter_column;
+    PodRule pod_rule;
+    uint8_t pod_row;
+    PodResult pod_result;
+    size_t pod_available;
+    uint32_t pod_decks[POD_SEATS_MAX];
+    int pod_reels[POD_SEATS_MAX];
+    DeckSearch* search;
+    bool search_stale;
+    size_t search_first;
+    size_t search_count;
+    size_t search_selected;
+    // Open only while a file is being read in; the rest outlives it for the result screen
+    DeckImport* import;
+    DeckImportStatus import_status;
+    DeckImportProgress import_progress;
+    char import_path[DECK_IMPORT_PATH_SIZE];
+    PlayStats stats_rows[STATS_VISIBLE_ITEMS];
+    int stats_rows_start;
+    DeckStore* decks;
+    DeckIndex* index;
+    NameCache* names;
+    DeckJournal* journal;
+    size_t journal_size;
+    bool save_pending;
+    bool save_failed;
+    // The list file holds more decks than were loaded, so nothing may be
+    // written back over it
+    bool read_only;
+    int deck_count;
+    int current_deck;
+    int selected_deck;
+    AppState state;
+    uint32_t spin_start_time;
+    char edit_buffer[MAX_NAME_LENGTH];
+    int spin_offset;
+    SpinTextWidth spin_widths[SPIN_WIDTH_CACHE_SIZE];
+    uint32_t blink_start_time;
+    bool blink_visible;
+    bool is_blinking;
+    KeyboardLayout keyboard_layout;
+    uint8_t selected_row;
+    uint8_t selected_column;
+    int scroll_position;
+    int scroll_direction;
+} MTGDeckRandomizer;
+
+static bool mtg_deck_name_fetch(void* ctx, uint32_t index, char* name, size_t size) {
+    MTGDeckRandomizer* mtg = ctx;
+    if (!deck_index_read_name(mtg->index, index, name, size)) {
+        FURI_LOG_E("MTG", "Failed to read deck %lu from index", (unsigned long)index);
+        return false;
+    }
+    return true;
+}
+
+// Names come from the store once it is resident, otherwise they are paged in from the index
+static const char* mtg_deck_name(MTGDeckRandomizer* mtg, int index) {
+    if (!mtg->index) {
+        return deck_store_get(mtg->decks, index);
+    }
+    return name_cache_get(mtg->names, index);
+}
+
+// An empty list has no current deck, whatever current_deck still says
+static const char* mtg_current_deck_name(MTGDeckRandomizer* mtg) {
+    if (mtg->deck_count == 0) {
+        return "No decks";
+    }
+    return mtg_deck_name(mtg, mtg->current_deck);
+}
+
+// Widths of names on the spin strip, keyed by deck index. Consecutive decks
+// map to distinct slots, so every row on screen is measured once and then
+// reused for as long as it stays in view
+static void spin_widths_reset(MTGDeckRandomizer* mtg) {
+    for (size_t i = 0; i < SPIN_WIDTH_CACHE_SIZE; i++) {
+        mtg->spin_widths[i].index = -1;
+    }
+}
+
+static uint16_t spin_text_width(MTGDeckRandomizer* mtg, Canvas* canvas, int index, const char* name) {
+    SpinTextWidth* slot = &mtg->spin_widths[index & (SPIN_WIDTH_CACHE_SIZE - 1)];
+    if (slot->index != index) {
+        slot->index = index;
+        slot->width = canvas_string_width(canvas, name);
+    }
+    return slot->width;
+}
+
+// Strip offset that puts current_deck on the centre line once the spin ends.
+// The strip eases out: the distance left shrinks with the square of the time left
+static int spin_offset_at(MTGDeckRandomizer* mtg, uint32_t elapsed) {
+    int strip = mtg->deck_count * SPIN_ROW_HEIGHT;
+    if (strip == 0) return 0;
+
+    uint64_t remaining = SPIN_DURATION - MIN(elapsed, (uint32_t)SPIN_DURATION);
+    uint64_t distance = (uint64_t)SPIN_SPEED * SPIN_DURATION / 1000;
+    int left = (int)(distance * remaining * remaining / ((uint64_t)SPIN_DURATION * SPIN_DURATION));
+    int offset = (mtg->current_deck * SPIN_ROW_HEIGHT - left) % strip;
+    return offset < 0 ? offset + strip : offset;
+}
+
+// Page in the rows the spin can show at its current offset, so the draw
+// callback only reads names already cached
+static void spin_rows_prefetch(MTGDeckRandomizer* mtg) {
+    if (!mtg->index || mtg->deck_count == 0) return;
+    int centre = mtg->spin_offset / SPIN_ROW_HEIGHT;
+    for (int row = -(SPIN_VISIBLE_ROWS / 2); row <= SPIN_VISIBLE_ROWS / 2; row++) {
+        name_cache_prefetch(mtg->names, (centre + row + mtg->deck_count) % mtg->deck_count, 1);
+    }
+}
+
+// Rows of the deck list on screen; the extra row past the decks is "Add New Deck"
+static void deck_list_window(MTGDeckRandomizer* mtg, int* start_index, int* end_index) {
+    *start_index = MAX(0, mtg->selected_deck - DECK_LIST_VISIBLE_ITEMS / 2);
+    *end_index = MIN(*start_index + DECK_LIST_VISIBLE_ITEMS, mtg->deck_count + 1);
+}
+
+// Page in the visible rows plus a few more in the direction of travel, so the
+// next scroll step finds its row already cached
+static void deck_list_prefetch(MTGDeckRandomizer* mtg) {
+    if (!mtg->index) return;
+
+    int start_index, end_index;
+    deck_list_window(mtg, &start_index, &end_index);
+    end_index = MIN(end_index, mtg->deck_count);
+
+    int first = start_index;
+    int last = end_index;
+    if (mtg->scroll_direction > 0) {
+        last = MIN(end_index + DECK_LIST_PREFETCH, mtg->deck_count);
+    } else if (mtg->scroll_direction < 0) {
+        first = MAX(start_index - DECK_LIST_PREFETCH, 0);
+    }
+    if (last > first) {
+        name_cache_prefetch(mtg->names, first, last - first);
+    }
+}
+
+// Move the deck list selection, clamped to the list and its "Add New Deck" row
+static void deck_list_move(MTGDeckRandomizer* mtg, int delta) {
+    int target = MAX(0, MIN(mtg->selected_deck + delta, mtg->deck_count));
+    if (target == mtg->selected_deck) return;
+
+    mtg->scroll_direction = target > mtg->selected_deck ? 1 : -1;
+    mtg->selected_deck = target;
+    if (mtg->selected_deck < mtg->scroll_position) {
+        mtg->scroll_position = mtg->selected_deck;
+    } else if (mtg->selected_deck >= mtg->scroll_position + 4) {
+        mtg->scroll_position = mtg->selected_deck - 3;
+    }
+    deck_list_prefetch(mtg);
+}
+
+// Rows a page jump of a held key covers in a list of count rows
+static int scroll_page(int count) {
+    return MAX(DECK_LIST_VISIBLE_ITEMS, count / SCROLL_PAGES);
+}
+
+// Milliseconds and Unix time as the state machine sees them
+static uint32_t mtg_tick(MTGDeckRandomizer* mtg) {
+    return mtg->replaying ? mtg->replay_tick : furi_get_tick();
+}
+
+static uint32_t mtg_timestamp(MTGDeckRandomizer* mtg) {
+    return mtg->replaying ? mtg->replay_timestamp + mtg->replay_tick / 1000 : furi_hal_rtc_get_timestamp();
+}
+
+static uint32_t mtg_deck_id(MTGDeckRandomizer* mtg, int index) {
+    const char* name = mtg_deck_name(mtg, index);
+    return play_log_deck_id(name, strlen(name));
+}
+
+static void mtg_log_play(MTGDeckRandomizer* mtg, int index, PlayResult result) {
+    play_log_append(mtg->plays, mtg_deck_id(mtg, index), mtg_timestamp(mtg), result);
+}
+
+static void stats_window(MTGDeckRandomizer* mtg, int* start_index, int* end_index) {
+    *start_index = MAX(0, MIN(mtg->selected_deck - STATS_VISIBLE_ITEMS / 2, mtg->deck_count - STATS_VISIBLE_ITEMS));
+    *end_index = MIN(*start_index + STATS_VISIBLE_ITEMS, mtg->deck_count);
+}
+
+// Look the rows in view up in the stats block once per move, not on every draw
+static void stats_rows_load(MTGDeckRandomizer* mtg) {
+    int start_index, end_index;
+    stats_window(mtg, &start_index, &end_index);
+    if (mtg->index && end_index > start_index) {
+        name_cache_prefetch(mtg->names, start_index, end_index - start_index);
+    }
+    for (int i = start_index; i < end_index; i++) {
+        play_log_get(mtg->plays, mtg_deck_id(mtg, i), &mtg->stats_rows[i - start_index]);
+    }
+    mtg->stats_rows_start = start_index;
+}
+
+static void format_time_ago(char* buffer, size_t size, uint32_t timestamp) {
+    uint32_t now = furi_hal_rtc_get_timestamp();
+    uint32_t ago = now > timestamp ? now - timestamp : 0;
+    if (ago < 60) {
+        snprintf(buffer, size, "just now");
+    } else if (ago < 3600) {
+        snprintf(buffer, size, "%lum ago", (unsigned long)(ago / 60));
+    } else if (ago < 86400) {
+        snprintf(buffer, size, "%luh ago", (unsigned long)(ago / 3600));
+    } else {
+        snprintf(buffer, size, "%lud ago", (unsigned long)(ago / 86400));
+    }
+}
+
+// The bitplanes are built on first use and again after the list changes;
+// in paged mode the metadata comes straight from the index table
+static void mtg_filter_prepare(MTGDeckRandomizer* mtg) {
+    if (!mtg->filter_stale) return;
+
+    deck_filter_reset(mtg->filter, mtg->deck_count);
+    DeckMeta metas[FILTER_META_BATCH];
+    for (int first = 0; first < mtg->deck_count; first += FILTER_META_BATCH) {
+        size_t count = MIN(mtg->deck_count - first, FILTER_META_BATCH);
+        if (mtg->index) {
+            if (!deck_index_read_meta(mtg->index, first, metas, count)) {
+                FURI_LOG_E("MTG", "Failed to read deck metadata");
+                memset(metas, 0, sizeof(metas));
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                metas[i] = deck_store_get_meta(mtg->decks, first + i);
+            }
+        }
+        deck_filter_set_meta(mtg->filter, first, metas, count);
+    }
+    deck_filter_apply(mtg->filter, &mtg->filter_rule);
+    mtg->filter_stale = false;
+}
+
+static void mtg_filter_update(MTGDeckRandomizer* mtg) {
+    if (mtg->filter_stale) {
+        mtg_filter_prepare(mtg);
+    } else {
+        deck_filter_apply(mtg->filter, &mtg->filter_rule);
+    }
+}
+
+// Pick from the decks the filter lets through, or -1 if there are none. A
+// uniform pick selects among the matches directly; weighted and shuffle picks
+// keep their own odds and order and skip decks that don't match, falling back
+// to a uniform match if that takes too long
+static int mtg_pick_deck(MTGDeckRandomizer* mtg) {
+    if (!deck_filter_rule_active(&mtg->filter_rule)) {
+        return deck_picker_pick(mtg->picker);
+    }
+
+    mtg_filter_prepare(mtg);
+    size_t matches = deck_filter_count(mtg->filter);
+    if (matches == 0) return -1;
+
+    if (deck_picker_get_mode(mtg->picker) != DeckPickerModeUniform) {
+        for (int i = 0; i < FILTER_PICK_TRIES; i++) {
+            size_t deck = deck_picker_pick(mtg->picker);
+            if (deck_filter_matches(mtg->filter, deck)) return deck;
+        }
+    }
+    return deck_filter_select(mtg->filter, deck_picker_random_below(matches));
+}
+
+static const char* mtg_tag_name(MTGDeckRandomizer* mtg, int tag) {
+    return tag >= 0 ? deck_store_tag_name(mtg->decks, tag) : "any";
+}
+
+static const char* mtg_search_name(void* ctx, uint32_t position) {
+    return mtg_deck_name(ctx, position);
+}
+
+// The search order is sorted on first use after a load: from the store, or
+// read ready-made from the index when the list is paged
+static bool mtg_search_prepare(MTGDeckRandomizer* mtg) {
+    if (!mtg->search_stale) return true;
+
+    uint16_t* order = deck_search_reset(mtg->search, mtg->deck_count);
+    bool ready = order != NULL;
+    if (ready && mtg->index) {
+        ready = deck_index_read_order(mtg->index, order);
+    } else if (ready) {
+        ready = deck_search_sort(mtg->decks, order);
+    }
+    if (!ready) {
+        FURI_LOG_E("MTG", "Failed to build the search order");
+        deck_search_reset(mtg->search, 0);
+        return false;
+    }
+    mtg->search_stale = false;
+    return true;
+}
+
+static void search_window(MTGDeckRandomizer* mtg, int* start_index, int* end_index) {
+    *start_index = MAX(0, (int)mtg->search_selected - SEARCH_VISIBLE_ITEMS / 2);
+    *end_index = MIN(*start_index + SEARCH_VISIBLE_ITEMS, (int)mtg->search_count);
+    *start_index = MAX(0, MIN(*start_index, *end_index - SEARCH_VISIBLE_ITEMS));
+}
+
+// Matches sit anywhere in the list, so the rows in view are paged in one by
+// one whenever the results or the selection change, never by the draw
+static void search_rows_prefetch(MTGDeckRandomizer* mtg) {
+    if (!mtg->index) return;
+    int start_index, end_index;
+    search_window(mtg, &start_index, &end_index);
+    for (int i = start_index; i < end_index; i++) {
+        name_cache_prefetch(mtg->names, deck_search_get(mtg->search, mtg->search_first + i), 1);
+    }
+}
+
+// Narrow the results to the names starting with what has been typed so far
+static void mtg_search_update(MTGDeckRandomizer* mtg) {
+    mtg->search_count = deck_search_find(mtg->search, mtg->edit_buffer, &mtg->search_first);
+    mtg->search_selected = 0;
+    search_rows_prefetch(mtg);
+}
+
+// Deck showing on a pod seat's reel. Each seat runs down the list towards its
+// deck and eases out like the single spin; later seats stop later
+static int pod_reel_at(MTGDeckRandomizer* mtg, int seat, uint32_t elapsed) {
+    uint32_t stop = SPIN_DURATION - (mtg->pod_rule.seats - 1 - seat) * POD_SEAT_STAGGER;
+    uint64_t remaining = stop - MIN(elapsed, stop);
+    int left = (int)(POD_REEL_STEPS * remaining * remaining / ((uint64_t)stop * stop));
+    int deck = ((int)mtg->pod_decks[seat] - left) % mtg->deck_count;
+    return deck < 0 ? deck + mtg->deck_count : deck;
+}
+
+// The deck on every reel, paged in before the draw needs it
+static void pod_reels_prefetch(MTGDeckRandomizer* mtg) {
+    if (!mtg->index) return;
+    for (int seat = 0; seat < mtg->pod_rule.seats; seat++) {
+        name_cache_prefetch(mtg->names, mtg->pod_reels[seat], 1);
+    }
+}
+
+static void pod_spin_start(MTGDeckRandomizer* mtg) {
+    mtg_filter_prepare(mtg);
+    mtg->pod_result = pod_assign(mtg->filter, &mtg->filter_rule, &mtg->pod_rule, mtg->pod_decks, &mtg->pod_available);
+    if (mtg->pod_result != PodResultOk) return;
+
+    mtg->state = StatePodSpinning;
+    mtg->spin_start_time = mtg_tick(mtg);
+    for (int seat = 0; seat < mtg->pod_rule.seats; seat++) {
+        mtg->pod_reels[seat] = pod_reel_at(mtg, seat, 0);
+    }
+    pod_reels_prefetch(mtg);
+}
+
+static void save_decks(MTGDeckRandomizer* mtg);
+static bool write_decks(const DeckListPaths* paths, DeckJournal* journal, const DeckStore* decks);
+static void load_decks_from_text(MTGDeckRandomizer* mtg);
+
+// Edits need every name in RAM, so pull the whole list in from the index first.
+// An unusable index falls back to the text file, which may turn out read-only
+// or shorter than before: callers check the result and their position again
+static bool mtg_decks_make_resident(MTGDeckRandomizer* mtg) {
+    if (!mtg->index) return !mtg->read_only;
+
+    bool loaded = deck_index_load(mtg->index, mtg->decks);
+    deck_index_close(mtg->index);
+    mtg->index = NULL;
+    name_cache_reset(mtg->names);
+
+    if (!loaded) {
+        FURI_LOG_W("MTG", "Index unusable, reloading the deck list");
+        storage_common_remove(furi_record_open(RECORD_STORAGE), mtg->paths.index);
+        furi_record_close(RECORD_STORAGE);
+        load_decks_from_text(mtg);
+        mtg->filter_stale = true;
+        mtg->search_stale = true;
+    }
+    mtg->deck_count = deck_store_count(mtg->decks);
+    return !mtg->read_only;
+}
+
+// Hand a snapshot of the list to the storage worker for a full rewrite
+static void mtg_decks_save_async(MTGDeckRandomizer* mtg) {
+    if (mtg->read_only) {
+        FURI_LOG_W("MTG", "Deck list only partly loaded, not saving");
+        return;
+    }
+    DeckStore* snapshot = deck_store_clone(mtg->decks);
+    if (!snapshot) {
+        FURI_LOG_E("MTG", "Not enough memory to snapshot the deck list");
+        mtg->save_failed = true;
+        return;
+    }
+    storage_worker_save(mtg->storage, snapshot);
+    mtg->save_pending = true;
+}
+
+// Record an edit already applied to the store. The journal append happens on
+// the storage worker; if it has fallen behind, one full save replaces its queue
+static void mtg_decks_commit(MTGDeckRandomizer* mtg, DeckJournalOp op, int position) {
+    furi_assert(!mtg->read_only);
+    spin_widths_reset(mtg);
+    mtg->filter_stale = true;
+    // Keep the match count on the main menu current
+    if (deck_filter_rule_active(&mtg->filter_rule)) mtg_filter_prepare(mtg);
+
+    // Move the one deck within the search order rather than sort again
+    if (!mtg->search_stale) {
+        switch (op) {
+            case DeckJournalOpAdd:
+                mtg->search_stale = !deck_search_insert(mtg->search, position);
+                break;
+            case DeckJournalOpRename:
+                deck_search_update(mtg->search, position);
+                break;
+            case DeckJournalOpDelete:
+                deck_search_remove(mtg->search, position);
+                break;
+        }
+    }
+
+    const char* name = NULL;
+    size_t length = 0;
+    if (op != DeckJournalOpDelete) {
+        name = deck_store_get(mtg->decks, position);
+        length = deck_store_get_length(mtg->decks, position);
+    }
+
+    if (!storage_worker_append(mtg->storage, op, position, name, length)) {
+        mtg_decks_save_async(mtg);
+    }
+}
+
+// Hand the decks read in so far to the picker, filter and search, and save
+// them all with one full rewrite rather than a journal entry each
+static void mtg_import_finish(MTGDeckRandomizer* mtg) {
+    if (!mtg->import) return;
+
+    mtg->import_progress = *deck_import_progress(mtg->import);
+    deck_import_close(mtg->import);
+    mtg->import = NULL;
+
+    int count = deck_store_count(mtg->decks);
+    if (count == mtg->deck_count) return;
+    // Imported decks are appended, so no index already handed out moves
+    for (int i = mtg->deck_count; i < count; i++) {
+        deck_picker_insert(mtg->picker, i);
+    }
+    mtg->deck_count = count;
+    spin_widths_reset(mtg);
+    mtg->filter_stale = true;
+    mtg->search_stale = true;
+    if (deck_filter_rule_active(&mtg->filter_rule)) mtg_filter_prepare(mtg);
+    mtg_decks_save_async(mtg);
+}
+
+// Import the first CSV in the import folder; the rows are read in a batch per
+// frame so the progress screen stays live on a long file
+static void mtg_import_start(MTGDeckRandomizer* mtg) {
+    mtg->state = StateImport;
+    memset(&mtg->import_progress, 0, sizeof(mtg->import_progress));
+    mtg->import_path[0] = '\0';
+
+    // Made on first use, so there is a folder to drop files into
+    storage_simply_mkdir(furi_record_open(RECORD_STORAGE), IMPORT_FOLDER);
+    furi_record_close(RECORD_STORAGE);
+    if (!deck_import_find(IMPORT_FOLDER, mtg->import_path, sizeof(mtg->import_path))) {
+        mtg->import_path[0] = '\0';
+        mtg->import_status = DeckImportStatusNoFile;
+        return;
+    }
+
+    if (!mtg_decks_make_resident(mtg)) {
+        mtg->state = StateDeckList;
+        return;
+    }
+    mtg->import = deck_import_open(mtg->import_path, mtg->decks);
+    mtg->import_status = deck_import_status(mtg->import);
+    if (mtg->import_status != DeckImportStatusRunning) mtg_import_finish(mtg);
+}
+
+static void mtg_import_step(MTGDeckRandomizer* mtg) {
+    mtg->import_status = deck_import_step(mtg->import, IMPORT_ROWS_PER_FRAME);
+    mtg->import_progress = *deck_import_progress(mtg->import);
+    if (mtg->import_status != DeckImportStatusRunning) mtg_import_finish(mtg);
+    mtg->dirty = true;
+}
+
+// Runs on the main loop whenever the storage worker reports finished jobs
+static void mtg_deck_randomizer_storage_event(MTGDeckRandomizer* mtg) {
+    uint32_t events = storage_worker_take_events(mtg->storage, &mtg->journal_size);
+
+    if (events & (StorageWorkerEventSaved | StorageWorkerEventSaveFailed)) {
+        bool failed = (events & StorageWorkerEventSaveFailed) != 0;
+        mtg->dirty |= failed != mtg->save_failed;
+        mtg->save_pending = false;
+        mtg->save_failed = failed;
+    }
+
+    if (events & StorageWorkerEventAppendFailed) {
+        FURI_LOG_W("MTG", "Journal append failed, saving the whole list");
+        mtg_decks_save_async(mtg);
+    } else if (mtg->journal_size >= DECKS_JOURNAL_COMPACT_SIZE && !mtg->save_pending) {
+        FURI_LOG_I("MTG", "Journal reached %zu bytes, compacting", mtg->journal_size);
+        mtg_decks_save_async(mtg);
+    }
+}
+
+static bool mtg_decks_save_callback(void* ctx, const DeckStore* decks) {
+    MTGDeckRandomizer* mtg = ctx;
+    return write_decks(&mtg->paths, mtg->journal, decks);
+}
+
+static void mtg_deck_randomizer_storage_callback(void* ctx) {
+    MTGDeckRandomizer* mtg = ctx;
+    MTGEvent event = {.type = MTGEventTypeStorage};
+    // Never stall the worker on a full queue; events are collected in bulk, so
+    // the next one delivered picks up anything this one would have reported
+    furi_message_queue_put(mtg->event_queue, &event, 0);
+}
+
+// Write the whole list to a temporary file and rename it over the old one, so
+// a power loss at any point leaves either the old or the new list in place.
+// Runs on the storage worker, or on the main loop while the worker is idle
+static bool write_decks(const DeckListPaths* paths, DeckJournal* journal, const DeckStore* decks) {
+    PERF_SCOPE(PerfScopeSave);
+    int deck_count = deck_store_count(decks);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool written = false;
+
+    FURI_LOG_I("MTG", "Saving decks to %s", paths->text);
+
+    if (storage_file_open(file, paths->tmp, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        BlockWriter* writer = block_writer_alloc(file, DECKS_SAVE_BLOCK_SIZE);
+        char meta[DECK_META_FORMAT_SIZE];
+        for (int i = 0; i < deck_count; i++) {
+            block_writer_put(writer, deck_store_get(decks, i), deck_store_get_length(decks, i));
+            block_writer_put(writer, meta, deck_meta_format(decks, deck_store_get_meta(decks, i), meta, sizeof(meta)));
+            block_writer_put(writer, "\n", 1);
+        }
+        written = block_writer_flush(writer) && storage_file_sync(file);
+        block_writer_free(writer);
+    } else {
+        FURI_LOG_E("MTG", "Failed to open file for writing");
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+
+    bool saved = written && storage_common_rename(storage, paths->tmp, paths->text) == FSE_OK;
+    if (saved) {
+        FURI_LOG_I("MTG", "Successfully saved %d decks", deck_count);
+        // The journal is stamped against the old file, so it would be discarded
+        // anyway; clearing it here just saves the stat on the next load
+        deck_journal_clear(journal);
+        // Stamp the index against the file just written
+        deck_index_write(paths->index, paths->text, decks);
+    } else {
+        FURI_LOG_E("MTG", "Failed to save decks, keeping the previous list");
+        storage_common_remove(storage, paths->tmp);
+    }
+    furi_record_close(RECORD_STORAGE);
+    return saved;
+}
+
+// Save on the calling thread, for when the list must be on disk before going on
+static void save_decks(MTGDeckRandomizer* mtg) {
+    furi_assert(!mtg->index);
+    furi_assert(!mtg->read_only);
+    storage_worker_flush(mtg->storage);
+    write_decks(&mtg->paths, mtg->journal, mtg->decks);
+    mtg->journal_size = 0;
+}
+
+// Finish or undo a save that was interrupted before or during the rename
+static void recover_decks(const DeckListPaths* paths) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    if (storage_common_exists(storage, paths->tmp)) {
+        if (!storage_common_exists(storage, paths->text)) {
+            FURI_LOG_W("MTG", "Recovering deck list from interrupted save");
+            storage_common_rename(storage, paths->tmp, paths->text);
+        } else {
+            storage_common_remove(storage, paths->tmp);
+        }
+    }
+    furi_record_close(RECORD_STORAGE);
+}
+
+static void load_decks(MTGDeckRandomizer* mtg) {
+    PERF_SCOPE(PerfScopeLoad);
+    // Files are only read once the worker has nothing left in flight
+    storage_worker_flush(mtg->storage);
+    deck_store_reset(mtg->decks);
+    name_cache_reset(mtg->names);
+    spin_widths_reset(mtg);
+    if (mtg->index) {
+        deck_index_close(mtg->index);
+        mtg->index = NULL;
+    }
+    recover_decks(&mtg->paths);
+    mtg->read_only = false;
+
+    // A current index makes startup a single header read
+    mtg->index = deck_index_open(mtg->paths.index, mtg->paths.text);
+    if (mtg->index && !deck_index_load_tags(mtg->index, mtg->decks)) {
+        deck_index_close(mtg->index);
+        mtg->index = NULL;
+    }
+    if (mtg->index) {
+        mtg->deck_count = deck_index_count(mtg->index);
+        FURI_LOG_I("MTG", "Opened deck index with %d decks", mtg->deck_count);
+    } else {
+        load_decks_from_text(mtg);
+    }
+
+    // Edits since the last full save sit in the journal on top of the list. A
+    // read-only list is not the one they were made to, so they are left there
+    if (deck_journal_pending(mtg->journal) && mtg_decks_make_resident(mtg)) {
+        deck_journal_replay(mtg->journal, mtg->decks);
+        mtg->deck_count = deck_store_count(mtg->decks);
+    }
+    mtg->journal_size = deck_journal_size(mtg->journal);
+    deck_picker_load(mtg->picker, mtg->deck_count);
+    deck_lists_set_count(mtg->lists, mtg->deck_count);
+    mtg->filter_stale = true;
+    mtg->search_stale = true;
+}
+
+static void load_decks_from_text(MTGDeckRandomizer* mtg) {
+    deck_store_reset(mtg->decks);
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    FuriString* path = furi_string_alloc_set(mtg->paths.text);
+    File* file = storage_file_alloc(storage);
+    bool parsed = false;
+
+    FURI_LOG_I("MTG", "Loading decks from %s", furi_string_get_cstr(path));
+
+    if (storage_file_open(file, furi_string_get_cstr(path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+        LineReader* reader = line_reader_alloc(file, LINE_READER_DEFAULT_BLOCK_SIZE);
+        const char* line;
+        size_t length;
+
+        while (line_reader_next(reader, &line, &length)) {
+            if (length == 0) continue;  // Ignore empty lines
+            DeckMeta meta;
+            size_t name_length = deck_meta_parse(mtg->decks, line, length, &meta);
+            if (name_length == 0) continue;
+            if (name_length > MAX_NAME_LENGTH - 1) {
+                // The cut name would go back into the file on the next save
+                FURI_LOG_E("MTG", "Deck name too long, list is read-only");
+                mtg->read_only = true;
+                name_length = MAX_NAME_LENGTH - 1;
+            }
+            if (!deck_store_add(mtg->decks, line, name_length)) {
+                // Saving what did fit would drop the rest from the file for good
+                FURI_LOG_E("MTG", "Deck store full, list is read-only");
+                mtg->read_only = true;
+                break;
+            }
+            deck_store_set_meta(mtg->decks, deck_store_count(mtg->decks) - 1, meta);
+            FURI_LOG_D("MTG", "Loaded deck: %s", line);
+        }
+        mtg->deck_count = deck_store_count(mtg->decks);
+
+        const LineReaderStats* stats = line_reader_get_stats(reader);
+        if (stats->overlong_lines > 0) {
+            FURI_LOG_E("MTG", "Deck line too long, list is read-only");
+            mtg->read_only = true;
+        }
+        FURI_LOG_I(
+            "MTG",
+            "Successfully loaded %d decks (%lu lines, %lu bytes, %lu blocks, %lu overlong)",
+            mtg->deck_count,
+            (unsigned long)stats->lines,
+            (unsigned long)stats->bytes,
+            (unsigned long)stats->blocks,
+            (unsigned long)stats->overlong_lines);
+        line_reader_free(reader);
+        parsed = true;
+    } else {
+        FURI_LOG_W("MTG", "Failed to open file for reading, creating default decks");
+        static const char* const default_decks[] = {"Red Aggro", "Blue Control", "Green Ramp"};
+        for (size_t i = 0; i < COUNT_OF(default_decks); i++) {
+            deck_store_add(mtg->decks, default_decks[i], strlen(default_decks[i]));
+        }
+        mtg->deck_count = deck_store_count(mtg->decks);
+        FURI_LOG_I("MTG", "Created default decks");
+        save_decks(mtg);
+    }
+
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_string_free(path);
+    furi_record_close(RECORD_STORAGE);
+
+    // An index of part of the list would open next time as if it were all of it
+    if (parsed && !mtg->read_only) {
+        deck_index_write(mtg->paths.index, mtg->paths.text, mtg->decks);
+    }
+
+    if (mtg->deck_count == 0) {
+        FURI_LOG_E("MTG", "No decks loaded or created. This should not happen.");
+    }
+    FURI_LOG_I(
+        "MTG",
+        "Deck store: %zu bytes of names, %zu bytes allocated",
+        deck_store_pool_used(mtg->decks),
+        deck_store_memory_used(mtg->decks));
+}
+
+// The journal, the storage worker and the picker state all belong to the
+// active list's files
+static void mtg_list_attach(MTGDeckRandomizer* mtg) {
+    deck_lists_paths(mtg->lists, deck_lists_active(mtg->lists), &mtg->paths);
+    mtg->journal = deck_journal_alloc(mtg->paths.journal, mtg->paths.text);
+    mtg->journal_size = 0;
+    mtg->save_pending = false;
+    mtg->save_failed = false;
+    mtg->read_only = false;
+    mtg->storage = storage_worker_alloc(
+        mtg->journal, mtg_decks_save_callback, mtg_deck_randomizer_storage_callback, mtg);
+    mtg->picker = deck_picker_alloc(mtg->paths.picker);
+}
+
+// Stopping the worker lets it finish any queued writes first
+static void mtg_list_detach(MTGDeckRandomizer* mtg) {
+    storage_worker_free(mtg->storage);
+    deck_picker_free(mtg->picker);
+    deck_journal_free(mtg->journal);
+}
+
+// Fold the edits made this session into the deck list; detaching waits for
+// the worker to write it
+static void mtg_list_finish(MTGDeckRandomizer* mtg) {
+    mtg_import_finish(mtg);
+    storage_worker_flush(mtg->storage);
+    mtg_deck_randomizer_storage_event(mtg);
+    if ((mtg->journal_size > 0 || mtg->save_failed) && !mtg->save_pending) {
+        mtg_decks_save_async(mtg);
+    }
+    deck_picker_sync(mtg->picker);
+}
+
+// Only the active list is held in memory. The old list's names, search order
+// and bitplanes are freed outright rather than reset, so a small list never
+// keeps the pool a large one grew
+static void mtg_list_switch(MTGDeckRandomizer* mtg, size_t list) {
+    mtg_list_finish(mtg);
+    mtg_list_detach(mtg);
+    deck_lists_set_count(mtg->lists, mtg->deck_count);
+
+    if (mtg->index) {
+        deck_index_close(mtg->index);
+        mtg->index = NULL;
+    }
+    deck_store_free(mtg->decks);
+    mtg->decks = deck_store_alloc();
+    deck_search_free(mtg->search);
+    mtg->search = deck_search_alloc(mtg_search_name, mtg);
+    deck_filter_free(mtg->filter);
+    mtg->filter = deck_filter_alloc();
+    // Colors and brackets carry over, but tag ids are numbered per list
+    mtg->filter_rule.tag = -1;
+    mtg->search_first = 0;
+    mtg->search_count = 0;
+    mtg->search_selected = 0;
+    mtg->current_deck = 0;
+    mtg->selected_deck = 0;
+    mtg->scroll_position = 0;
+
+    deck_lists_set_active(mtg->lists, list, mtg_timestamp(mtg));
+    mtg_list_attach(mtg);
+    load_decks(mtg);
+    deck_lists_sync(mtg->lists);
+}
+
+static void lists_window(MTGDeckRandomizer* mtg, int* start_index, int* end_index) {
+    int count = deck_lists_count(mtg->lists);
+    *start_index = MAX(0, MIN((int)mtg->lists_selected - LISTS_VISIBLE_ITEMS / 2, count - LISTS_VISIBLE_ITEMS));
+    *end_index = MIN(*start_index + LISTS_VISIBLE_ITEMS, count);
+}
+
+// Two passes, one per font: the prompt, the text and the special keys' labels
+// in FontSecondary, then every character key in FontKeyboard. status, if set,
+// goes at the right of the text line
+static void draw_keyboard(
+    Canvas* canvas, MTGDeckRandomizer* mtg, const char* prompt, const char* status, const char* enter) {
+    canvas_set_font(canvas, FontSecondary);
+    canvas_draw_str(canvas, 2, 10, prompt);
+    canvas_draw_str(canvas, 2, 22, mtg->edit_buffer);
+    if (status) canvas_draw_str_aligned(canvas, 127, 22, AlignRight, AlignBottom, status);
+
+    for (uint8_t row = 0; row < KEYBOARD_ROWS; row++) {
+        const KeyboardRow* keys = keyboard_row(mtg->keyboard_layout, row);
+        for (uint8_t column = 0; column < keys->count; column++) {
+            const KeyboardKey* key = &keys->keys[column];
+            const char* label = NULL;
+            switch (key->text) {
+                case KEYBOARD_KEY_ENTER:
+                    label = enter;
+                    break;
+                case KEYBOARD_KEY_BACKSPACE:
+                    label = "bck";
+                    break;
+                case KEYBOARD_KEY_LAYOUT:
+                    label = keyboard_layout_label(mtg->keyboard_layout);
+                    break;
+                case KEYBOARD_KEY_SPACE:
+                    label = "spc";
+                    break;
+                default:
+                    break;
+            }
+            if (label) canvas_draw_str(canvas, key->x + KEYBOARD_TEXT_X, key->y + KEYBOARD_TEXT_Y, label);
+        }
+    }
+
+    canvas_set_font(canvas, FontKeyboard);
+    for (uint8_t row = 0; row < KEYBOARD_ROWS; row++) {
+        const KeyboardRow* keys = keyboard_row(mtg->keyboard_layout, row);
+        for (uint8_t column = 0; column < keys->count; column++) {
+            const KeyboardKey* key = &keys->keys[column];
+            if (!keyboard_key_is_special(key)) {
+                canvas_draw_glyph(canvas, key->x + KEYBOARD_TEXT_X, key->y + KEYBOARD_TEXT_Y, key->text);
+            }
+        }
+    }
+
+    const KeyboardKey* selected = &keyboard_row(mtg->keyboard_layout, mtg->selected_row)->keys[mtg->selected_column];
+    canvas_draw_frame(canvas, selected->x, selected->y, selected->width, selected->height);
+}
+
+// Hidden diagnostics along the bottom: median and worst draw time, storage
+// traffic so far, free and least free heap, and the stack watermarks
+static void draw_perf_overlay(Canvas* canvas) {
+    PerfSummary draw;
+    perf_summary(PerfScopeDraw, &draw);
+    PerfIo io = perf_io_totals();
+    char line[64];
+
+    canvas_set_font(canvas, FontSecondary);
+    canvas_set_color(canvas, ColorWhite);
+    canvas_draw_box(canvas, 0, 45, 128, 19);
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_line(canvas, 0, 45, 127, 45);
+    snprintf(
+        line,
+        sizeof(line),
+        "F %lu/%luus R%lu W%lu",
+        (unsigned long)draw.p50_micros,
+        (unsigned long)draw.max_micros,
+        (unsigned long)io.reads,
+        (unsigned long)io.writes);
+    canvas_draw_str(canvas, 1, 54, line);
+    snprintf(
+        line,
+        sizeof(line),
+        "H %zuk/%zuk S %lu/%lu",
+        memmgr_get_free_heap() / 1024,
+        memmgr_get_minimum_free_heap() / 1024,
+        (unsigned long)perf_stack_space(PerfThreadMain),
+        (unsigned long)perf_stack_space(PerfThreadWorker));
+    canvas_draw_str(canvas, 1, 63, line);
+}
+
+static void mtg_deck_randomizer_draw(Canvas* canvas, MTGDeckRandomizer* mtg) {
+    PERF_SCOPE(PerfScopeDraw);
+    canvas_clear(canvas);
+    canvas_set_font(canvas, FontSecondary);
+
+    switch (mtg->state) {
+        case StateMainMenu:
+            // Once there is more than one list, say which one is in play
+            canvas_draw_str_aligned(
+                canvas,
+                64,
+                10,
+                AlignCenter,
+                AlignTop,
+                deck_lists_count(mtg->lists) > 1 ? deck_lists_get(mtg->lists, deck_lists_active(mtg->lists))->name :
+                                                   "MTG Deck Randomizer");
+            canvas_draw_str_aligned(canvas, 64, 32, AlignCenter, AlignCenter, mtg_current_deck_name(mtg));
+            canvas_set_font(canvas, FontSecondary);
+            {
+                // Left opens the filter, Right cycles the pick mode
+                char line[24];
+                if (deck_filter_rule_active(&mtg->filter_rule)) {
+                    snprintf(line, sizeof(line), "< %u/%d", (unsigned)deck_filter_count(mtg->filter), mtg->deck_count);
+                } else {
+                    snprintf(line, sizeof(line), "< Filter");
+                }
+                canvas_draw_str_aligned(canvas, 0, 44, AlignLeft, AlignCenter, line);
+                snprintf(line, sizeof(line), "%s >", deck_picker_mode_name(deck_picker_get_mode(mtg->picker)));
+                canvas_draw_str_aligned(canvas, 127, 44, AlignRight, AlignCenter, line);
+            }
+            canvas_draw_str_aligned(canvas, 64, 60, AlignCenter, AlignBottom, "OK:Spin Up:Stats Down:Decks");
+            break;
+        case StateSpinning:
+            if (mtg->deck_count > 0) {
+                // The whole list is one circular strip; only the rows next to
+                // the one on the centre line can intersect the screen
+                int centre = mtg->spin_offset / SPIN_ROW_HEIGHT;
+                int shift = mtg->spin_offset % SPIN_ROW_HEIGHT;
+                int half_height = canvas_current_font_height(canvas) / 2;
+                for (int row = -(SPIN_VISIBLE_ROWS / 2); row <= SPIN_VISIBLE_ROWS / 2; row++) {
+                    int y = 32 + row * SPIN_ROW_HEIGHT - shift;
+                    if (y + half_height <= 0 || y - half_height >= 64) continue;
+                    int deck = (centre + row + mtg->deck_count) % mtg->deck_count;
+                    const char* name = mtg_deck_name(mtg, deck);
+                    uint16_t width = spin_text_width(mtg, canvas, deck, name);
+                    canvas_draw_str(canvas, 64 - width / 2, y + half_height, name);
+                }
+            }
+            break;
+        case StateSelected:
+            if (mtg->blink_visible) {
+                canvas_draw_str_aligned(canvas, 64, 32, AlignCenter, AlignCenter, mtg_current_deck_name(mtg));
+            }
+            break;
+        case StateDeckList:
+            canvas_draw_str_aligned(
+                canvas,
+                64,
+                0,
+                AlignCenter,
+                AlignTop,
+                mtg->read_only   ? "Deck List (read-only)" :
+                mtg->save_failed ? "Deck List (not saved!)" :
+                                   "Deck List");
+            int start_index, end_index;
+            deck_list_window(mtg, &start_index, &end_index);
+
+            for (int i = start_index; i < end_index; i++) {
+                int y = 10 + (i - start_index) * 9;
+                if (i < mtg->deck_count) {
+                    canvas_draw_str_aligned(canvas, 5, y, AlignLeft, AlignTop, mtg_deck_name(mtg, i));
+                } else {
+                    canvas_draw_str_aligned(canvas, 5, y, AlignLeft, AlignTop, mtg->read_only ? "(list not editable)" : "Add New Deck");
+                }
+                if (i == mtg->selected_deck) {
+                    canvas_draw_str_aligned(canvas, 0, y, AlignLeft, AlignTop, ">");
+                }
+            }
+
+            if (start_index > 0) {
+                canvas_draw_str_aligned(canvas, 124, 10, AlignRight, AlignTop, "^");
+            }
+            if (end_index < mtg->deck_count + 1) {
+                canvas_draw_str_aligned(canvas, 124, 62, AlignRight, AlignBottom, "v");
+            }
+            break;
+        case StateKeyboard:
+            draw_keyboard(canvas, mtg, "Add your deckname:", NULL, "save");
+            break;
+        case StateSearch: {
+            // The best match so far stands in for the prompt
+            const char* prompt = "No matching deck";
+            if (mtg->search_count > 0) {
+                prompt = mtg_deck_name(mtg, deck_search_get(mtg->search, mtg->search_first));
+            }
+            char count[12];
+            snprintf(count, sizeof(count), "%u", (unsigned)mtg->search_count);
+            draw_keyboard(canvas, mtg, prompt, count, "list");
+            break;
+        }
+        case StateSearchResults: {
+            char line[MAX_NAME_LENGTH + 16];
+            snprintf(line, sizeof(line), "%u decks: %s", (unsigned)mtg->search_count, mtg->edit_buffer);
+            canvas_draw_str_aligned(canvas, 64, 0, AlignCenter, AlignTop, line);
+
+            int start_index, end_index;
+            search_window(mtg, &start_index, &end_index);
+            for (int i = start_index; i < end_index; i++) {
+                int y = 12 + (i - start_index) * 10;
+                uint32_t deck = deck_search_get(mtg->search, mtg->search_first + i);
+                canvas_draw_str_aligned(canvas, 5, y, AlignLeft, AlignTop, mtg_deck_name(mtg, deck));
+                if (i == (int)mtg->search_selected) {
+                    canvas_draw_str_aligned(canvas, 0, y, AlignLeft, AlignTop, ">");
+                }
+            }
+            break;
+        }
+        case StateEditDeletePopup: {
+            // Draw the deck list in the background
+            mtg->state = StateDeckList;
+            mtg_deck_randomizer_draw(canvas, mtg);
+            mtg->state = StateEditDeletePopup;
+
+            // Draw the popup
+            canvas_set_color(canvas, ColorWhite);
+            canvas_draw_box(canvas, 22, 12, 84, 42);
+            canvas_set_color(canvas, ColorBlack);
+            canvas_draw_frame(canvas, 22, 12, 84, 42);
+            if (mtg->read_only) {
+                canvas_draw_str_aligned(canvas, 64, 20, AlignCenter, AlignTop, "List is read-only");
+            } else {
+                canvas_draw_str_aligned(canvas, 64, 15, AlignCenter, AlignTop, "Left: Delete");
+                canvas_draw_str_aligned(canvas, 64, 25, AlignCenter, AlignTop, "Right: Edit");
+            }
+            char weight[24];
+            snprintf(weight, sizeof(weight), "Up/Dn: Weight %u", deck_picker_get_weight(mtg->picker, mtg->selected_deck));
+            canvas_draw_str_aligned(canvas, 64, 35, AlignCenter, AlignTop, weight);
+            canvas_draw_str_aligned(canvas, 64, 45, AlignCenter, AlignTop, "Back: Cancel");
+            break;
+        }
+        case StateImport: {
+            const DeckImportProgress* progress = &mtg->import_progress;
+            canvas_draw_str_aligned(canvas, 64, 0, AlignCenter, AlignTop, "Import");
+            const char* file = strrchr(mtg->import_path, '/');
+            canvas_draw_str_aligned(canvas, 64, 10, AlignCenter, AlignTop, file ? file + 1 : IMPORT_FOLDER);
+
+            // Bytes read rather than rows, since the row count is not known up front
+            uint32_t filled = 0;
+            if (progress->file_size > 0) {
+                filled = (uint64_t)MIN(progress->bytes_read, progress->file_size) * 124 / progress->file_size;
+            }
+            canvas_draw_frame(canvas, 0, 21, 128, 8);
+            canvas_draw_box(canvas, 2, 23, filled, 4);
+
+            char line[40];
+            snprintf(
+                line,
+                sizeof(line),
+                "Added %lu Dupes %lu",
+                (unsigned long)progress->added,
+                (unsigned long)progress->duplicates);
+            canvas_draw_str_aligned(canvas, 64, 32, AlignCenter, AlignTop, line);
+            if (progress->skipped > 0) {
+                snprintf(line, sizeof(line), "%lu rows without a name", (unsigned long)progress->skipped);
+                canvas_draw_str_aligned(canvas, 64, 42, AlignCenter, AlignTop, line);
+            }
+            if (mtg->import) {
+                canvas_draw_str_aligned(canvas, 64, 63, AlignCenter, AlignBottom, "Back: Stop");
+            } else {
+                snprintf(line, sizeof(line), "%s  OK: Decks", deck_import_status_text(mtg->import_status));
+                canvas_draw_str_aligned(canvas, 64, 63, AlignCenter, AlignBottom, line);
+            }
+            break;
+        }
+        case StateLists: {
+            canvas_draw_str_aligned(canvas, 64, 0, AlignCenter, AlignTop, "Deck Lists");
+            size_t active = deck_lists_active(mtg->lists);
+            char line[24];
+            int start_index, end_index;
+            lists_window(mtg, &start_index, &end_index);
+            for (int i = start_index; i < end_index; i++) {
+                const DeckListInfo* info = deck_lists_get(mtg->lists, i);
+                int y = 10 + (i - start_index) * 9;
+                snprintf(line, sizeof(line), "%.18s", info->name);
+                canvas_draw_str_aligned(canvas, 6, y, AlignLeft, AlignTop, line);
+                snprintf(line, sizeof(line), "%lu", (unsigned long)info->deck_count);
+                canvas_draw_str_aligned(canvas, 120, y, AlignRight, AlignTop, line);
+                if ((size_t)i == active) {
+                    canvas_draw_str_aligned(canvas, 127, y, AlignRight, AlignTop, "*");
+                }
+                if ((size_t)i == mtg->lists_selected) {
+                    canvas_draw_str_aligned(canvas, 0, y, AlignLeft, AlignTop, ">");
+                }
+            }
+
+            uint32_t last_used = deck_lists_get(mtg->lists, mtg->lists_selected)->last_used;
+            if (last_used) {
+                char ago[16];
+                format_time_ago(ago, sizeof(ago), last_used);
+                snprintf(line, sizeof(line), "Used %s", ago);
+            } else {
+                snprintf(line, sizeof(line), "Never used");
+            }
+            canvas_draw_str_aligned(canvas, 64, 63, AlignCenter, AlignBottom, line);
+            break;
+        }
+        case StateStats: {
+            const PlayTotals* totals = play_log_totals(mtg->plays);
+            char line[40];
+            snprintf(line, sizeof(line), "Stats: %lu games", (unsigned long)totals->games);
+            canvas_draw_str_aligned(canvas, 64, 0, AlignCenter, AlignTop, line);
+
+            int start_index, end_index;
+            stats_window(mtg, &start_index, &end_index);
+            for (int i = start_index; i < end_index; i++) {
+                int y = 10 + (i - start_index) * 9;
+                snprintf(line, sizeof(line), "%u", mtg->stats_rows[i - start_index].plays);
+                canvas_draw_str_aligned(canvas, 20, y, AlignRight, AlignTop, line);
+                canvas_draw_str_aligned(canvas, 24, y, AlignLeft, AlignTop, mtg_deck_name(mtg, i));
+                if (i == mtg->selected_deck) {
+                    canvas_draw_str_aligned(canvas, 0, y, AlignLeft, AlignTop, ">");
+                }
+            }
+
+            // Details of the selected deck along the bottom
+            if (mtg->selected_deck >= start_index && mtg->selected_deck < end_index) {
+                const PlayStats* stats = &mtg->stats_rows[mtg->selected_deck - start_index];
+                if (stats->plays == 0 && stats->wins == 0 && stats->losses == 0) {
+                    snprintf(line, sizeof(line), "Not played yet");
+                } else {
+                    char ago[16] = "";
+                    if (stats->plays > 0) format_time_ago(ago, sizeof(ago), stats->last_played);
+                    unsigned games = stats->wins + stats->losses;
+                    snprintf(
+                        line,
+                        sizeof(line),
+                        "%uW %uL %u%% %s",
+                        stats->wins,
+                        stats->losses,
+                        games ? stats->wins * 100 / games : 0,
+                        ago);
+                }
+                canvas_draw_str_aligned(canvas, 64, 63, AlignCenter, AlignBottom, line);
+            }
+            break;
+        }
+        case StateFilter: {
+            char line[40];
+            snprintf(
+                line, sizeof(line), "Filter: %u of %d decks", (unsigned)deck_filter_count(mtg->filter), mtg->deck_count);
+            canvas_draw_str_aligned(canvas, 64, 0, AlignCenter, AlignTop, line);
+
+            // Each color shows as its letter followed by + (required), - (excluded) or nothing
+            canvas_draw_str_aligned(canvas, 6, 12, AlignLeft, AlignTop, "Colors");
+            for (int c = 0; c < DECK_COLOR_COUNT; c++) {
+                char cell[3] = {DECK_COLOR_NAMES[c], '\0', '\0'};
+                if (mtg->filter_rule.with_colors & (1 << c)) cell[1] = '+';
+                if (mtg->filter_rule.without_colors & (1 << c)) cell[1] = '-';
+                int x = 48 + c * 16;
+                canvas_draw_str_aligned(canvas, x, 12, AlignLeft, AlignTop, cell);
+                if (mtg->filter_row == FilterRowColors && mtg->filter_column == c) {
+                    canvas_draw_frame(canvas, x - 2, 11, 14, 11);
+                }
+            }
+
+            if (mtg->filter_rule.bracket_max) {
+                snprintf(line, sizeof(line), "Bracket  < %u >", mtg->filter_rule.bracket_max);
+            } else {
+                snprintf(line, sizeof(line), "Bracket  < any >");
+            }
+            canvas_draw_str_aligned(canvas, 6, 24, AlignLeft, AlignTop, line);
+            snprintf(line, sizeof(line), "Tag  < %s >", mtg_tag_name(mtg, mtg->filter_rule.tag));
+            canvas_draw_str_aligned(canvas, 6, 36, AlignLeft, AlignTop, line);
+            canvas_draw_str_aligned(canvas, 6, 48, AlignLeft, AlignTop, "Clear filter");
+            canvas_draw_str_aligned(canvas, 0, 12 + mtg->filter_row * 12, AlignLeft, AlignTop, ">");
+            break;
+        }
+        case StatePodSetup: {
+            char line[40];
+            snprintf(line, sizeof(line), "Pod from %u decks", (unsigned)deck_filter_count(mtg->filter));
+            canvas_draw_str_aligned(canvas, 64, 0, AlignCenter, AlignTop, line);
+            snprintf(line, sizeof(line), "Players  < %u >", mtg->pod_rule.seats);
+            canvas_draw_str_aligned(canvas, 6, 14, AlignLeft, AlignTop, line);
+            if (mtg->pod_rule.spread < 0) {
+                snprintf(line, sizeof(line), "Balance  < off >");
+            } else if (mtg->pod_rule.spread == 0) {
+                snprintf(line, sizeof(line), "Balance  < same bracket >");
+            } else {
+                snprintf(line, sizeof(line), "Balance  < within %d >", mtg->pod_rule.spread);
+            }
+            canvas_draw_str_aligned(canvas, 6, 26, AlignLeft, AlignTop, line);
+            canvas_draw_str_aligned(canvas, 0, 14 + mtg->pod_row * 12, AlignLeft, AlignTop, ">");
+
+            // A pod that can't be drawn is reported here instead of spinning
+            if (mtg->pod_result == PodResultTooFewDecks) {
+                snprintf(line, sizeof(line), "Only %u decks match", (unsigned)mtg->pod_available);
+            } else if (mtg->pod_result == PodResultUnbalanced) {
+                snprintf(line, sizeof(line), "Only %u decks in range", (unsigned)mtg->pod_available);
+            } else {
+                snprintf(line, sizeof(line), "OK: Spin");
+            }
+            canvas_draw_str_aligned(canvas, 64, 60, AlignCenter, AlignBottom, line);
+            break;
+        }
+        case StatePodSpinning:
+        case StatePodSelected: {
+            // One band per seat, top to bottom
+            int seats = mtg->pod_rule.seats;
+            int band = 64 / seats;
+            for (int seat = 0; seat < seats; seat++) {
+                int y = seat * band;
+                if (seat > 0) canvas_draw_line(canvas, 0, y - 1, 127, y - 1);
+                char number[2] = {'1' + seat, '\0'};
+                canvas_draw_str_aligned(canvas, 1, y + band / 2, AlignLeft, AlignCenter, number);
+                int deck = mtg->state == StatePodSpinning ? mtg->pod_reels[seat] : (int)mtg->pod_decks[seat];
+                canvas_draw_str_aligned(canvas, 10, y + band / 2, AlignLeft, AlignCenter, mtg_deck_name(mtg, deck));
+            }
+            break;
+        }
+        default:
+            FURI_LOG_E("MTG", "Unknown state in draw callback");
+            break;
+    }
+
+    if (mtg->perf_overlay) draw_perf_overlay(canvas);
+}
+
+static void mtg_deck_randomizer_draw_callback(Canvas* canvas, void* ctx) {
+    MTGDeckRandomizer* mtg = ctx;
+    furi_check(furi_mutex_acquire(mtg->mutex, FuriWaitForever) == FuriStatusOk);
+    mtg_deck_randomizer_draw(canvas, mtg);
+    furi_mutex_release(mtg->mutex);
+}
+
+// Move around the keyboard and type into edit_buffer. Returns the key pressed
+// with OK once applied, so callers only act on Enter and on changed text.
+// Up and Down land on the key under the middle of the current one; a long OK
+// on a letter types it in the other case
+static char keyboard_input(MTGDeckRandomizer* mtg, InputEvent input) {
+    char pressed = 0;
+    if (input.type == InputTypeShort || input.type == InputTypeLong) {
+        const KeyboardRow* keys = keyboard_row(mtg->keyboard_layout, mtg->selected_row);
+        const KeyboardKey* key = &keys->keys[mtg->selected_column];
+        uint8_t middle = key->x + key->width / 2;
+        switch (input.key) {
+            case InputKeyUp:
+                if (mtg->selected_row > 0) {
+                    mtg->selected_row--;
+                    mtg->selected_column = keyboard_column_at(mtg->keyboard_layout, mtg->selected_row, middle);
+                }
+                break;
+            case InputKeyDown:
+                if (mtg->selected_row < KEYBOARD_ROWS - 1) {
+                    mtg->selected_row++;
+                    mtg->selected_column = keyboard_column_at(mtg->keyboard_layout, mtg->selected_row, middle);
+                }
+                break;
+            case InputKeyLeft:
+                if (mtg->selected_column > 0) mtg->selected_column--;
+                break;
+            case InputKeyRight:
+                if (mtg->selected_column < keys->count - 1) mtg->selected_column++;
+                break;
+            case InputKeyOk:
+                {
+                    char text = key->text;
+                    size_t len = strlen(mtg->edit_buffer);
+                    if (text == KEYBOARD_KEY_LAYOUT) {
+                        mtg->keyboard_layout = keyboard_layout_next(mtg->keyboard_layout);
+                    } else if (text == KEYBOARD_KEY_BACKSPACE) {
+                        if (len > 0) mtg->edit_buffer[len - 1] = '\0';
+                        pressed = text;
+                    } else if (text == KEYBOARD_KEY_ENTER) {
+                        pressed = text;
+                    } else if (len < MAX_NAME_LENGTH - 1) {
+                        if (input.type == InputTypeLong && text >= 'a' && text <= 'z') {
+                            text = text - 'a' + 'A';
+                        } else if (input.type == InputTypeLong && text >= 'A' && text <= 'Z') {
+                            text = text - 'A' + 'a';
+                        }
+                        mtg->edit_buffer[len] = text;
+                        mtg->edit_buffer[len + 1] = '\0';
+                        pressed = text;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return pressed;
+}
+
+static void handle_keyboard_input(MTGDeckRandomizer* mtg, InputEvent input) {
+    if (keyboard_input(mtg, input) != KEYBOARD_KEY_ENTER) return;
+
+    size_t len = strlen(mtg->edit_buffer);
+    if (len > 0) {
+        if (!mtg_decks_make_resident(mtg) || mtg->selected_deck > mtg->deck_count) {
+            FURI_LOG_E("MTG", "Deck list reloaded as read-only or shorter, edit dropped");
+            mtg->state = StateDeckList;
+            return;
+        }
+        bool stored;
+        DeckJournalOp op;
+        if (mtg->selected_deck < mtg->deck_count) {
+            // Editing existing deck
+            stored = deck_store_set(mtg->decks, mtg->selected_deck, mtg->edit_buffer, len);
+            op = DeckJournalOpRename;
+        } else {
+            // Adding new deck
+            stored = deck_store_add(mtg->decks, mtg->edit_buffer, len);
+            op = DeckJournalOpAdd;
+        }
+        mtg->deck_count = deck_store_count(mtg->decks);
+        if (stored) {
+            if (op == DeckJournalOpAdd) {
+                deck_picker_insert(mtg->picker, mtg->selected_deck);
+            }
+            mtg_decks_commit(mtg, op, mtg->selected_deck);
+        } else {
+            FURI_LOG_E("MTG", "Deck store full, deck not saved");
+        }
+        mtg->state = StateDeckList;
+    }
+}
+
+// Every character typed or erased narrows or widens the results at once;
+// Enter lists them
+static void handle_search_input(MTGDeckRandomizer* mtg, InputEvent input) {
+    char key = keyboard_input(mtg, input);
+    if (key == KEYBOARD_KEY_ENTER) {
+        if (mtg->search_count > 0) mtg->state = StateSearchResults;
+    } else if (key) {
+        mtg_search_update(mtg);
+    }
+}
+
+// Runs on the system input thread, which must never wait on the app: events
+// go into the pipeline, and one wake-up covers everything queued behind it
+static void mtg_deck_randomizer_input_callback(InputEvent* input_event, void* ctx) {
+    furi_assert(ctx);
+    MTGDeckRandomizer* mtg = ctx;
+    if (mtg->trace) trace_recorder_event(mtg->trace, input_event);
+    if (input_pipeline_push(mtg->input, input_event)) {
+        MTGEvent event = {.type = MTGEventTypeInput};
+        if (furi_message_queue_put(mtg->event_queue, &event, 0) != FuriStatusOk) {
+            input_pipeline_wake_failed(mtg->input);
+        }
+    }
+}
+
+static void mtg_deck_randomizer_update_state(MTGDeckRandomizer* mtg, InputEvent input) {
+    switch (mtg->state) {
+        case StateMainMenu:
+            if (input.key == InputKeyOk && mtg->deck_count > 0) {
+                int deck = mtg_pick_deck(mtg);
+                if (deck >= 0) {
+                    mtg->state = StateSpinning;
+                    mtg->spin_start_time = mtg_tick(mtg);
+                    mtg->current_deck = deck;
+                    mtg->spin_offset = spin_offset_at(mtg, 0);
+                    spin_rows_prefetch(mtg);
+                }
+            } else if (input.type == InputTypeShort && input.key == InputKeyRight) {
+                // Cycle through the selection modes
+                DeckPickerMode mode = (deck_picker_get_mode(mtg->picker) + 1) % DeckPickerModeCount;
+                deck_picker_set_mode(mtg->picker, mode);
+            } else if (input.type == InputTypeLong && input.key == InputKeyRight && mtg->deck_count > 0) {
+                mtg->state = StatePodSetup;
+                mtg->pod_row = PodRowSeats;
+                mtg->pod_result = PodResultOk;
+                mtg_filter_prepare(mtg);
+            } else if (input.type == InputTypeShort && input.key == InputKeyLeft) {
+                mtg->state = StateFilter;
+                mtg->filter_row = FilterRowColors;
+                mtg->filter_column = 0;
+                mtg_filter_prepare(mtg);
+            } else if (input.type == InputTypeLong && input.key == InputKeyLeft) {
+                // The folder is only listed when the lists are asked for. The
+                // worker finishes first so no file is read mid-write, and the
+                // active list's count comes from memory, journal included
+                storage_worker_flush(mtg->storage);
+                deck_lists_refresh(mtg->lists);
+                deck_lists_set_count(mtg->lists, mtg->deck_count);
+                mtg->lists_selected = deck_lists_active(mtg->lists);
+                mtg->state = StateLists;
+            } else if (input.type == InputTypeLong && input.key == InputKeyUp) {
+                mtg->perf_overlay = !mtg->perf_overlay;
+            } else if (input.type == InputTypeShort && input.key == InputKeyUp && mtg->deck_count > 0) {
+                // Start on the last pick so its result is one press away
+                mtg->state = StateStats;
+                mtg->selected_deck = MIN(mtg->current_deck, mtg->deck_count - 1);
+                stats_rows_load(mtg);
+            } else if (input.key == InputKeyDown) {
+                mtg->state = StateDeckList;
+                mtg->selected_deck = 0;
+                mtg->scroll_direction = 1;
+                deck_list_prefetch(mtg);
+            }
+            break;
+        case StateSpinning:
+            // Handle spinning state if needed
+            break;
+        case StateSelected:
+            if (input.key == InputKeyOk) {
+                mtg->state = StateMainMenu;
+            }
+            break;
+        case StateDeckList:
+            if (input.type == InputTypeShort) {
+                if (input.key == InputKeyOk) {
+                    if (mtg->selected_deck < mtg->deck_count) {
+                        mtg->current_deck = mtg->selected_deck;
+                        mtg->state = StateMainMenu;
+                    } else if (!mtg->read_only) {
+                        mtg->state = StateKeyboard;
+                        memset(mtg->edit_buffer, 0, sizeof(mtg->edit_buffer));
+                        mtg->keyboard_layout = KeyboardLayoutLower;
+                        mtg->selected_row = 0;
+                        mtg->selected_column = 0;
+                    }
+                } else if (input.key == InputKeyUp) {
+                    deck_list_move(mtg, -1);
+                } else if (input.key == InputKeyDown) {
+                    deck_list_move(mtg, 1);
+                } else if (input.key == InputKeyRight && mtg_search_prepare(mtg)) {
+                    mtg->state = StateSearch;
+                    memset(mtg->edit_buffer, 0, sizeof(mtg->edit_buffer));
+                    mtg->keyboard_layout = KeyboardLayoutLower;
+                    mtg->selected_row = 0;
+                    mtg->selected_column = 0;
+                    mtg_search_update(mtg);
+                } else if (input.key == InputKeyLeft && !mtg->read_only) {
+                    mtg_import_start(mtg);
+                }
+            } else if (input.type == InputTypeLong && input.key == InputKeyOk && mtg->selected_deck < mtg->deck_count) {
+                mtg->state = StateEditDeletePopup;
+            }
+            break;
+        case StateImport:
+            if (input.type == InputTypeShort && input.key == InputKeyOk && !mtg->import) {
+                mtg->state = StateDeckList;
+            }
+            break;
+        case StateKeyboard:
+            handle_keyboard_input(mtg, input);
+            break;
+        case StateSearch:
+            handle_search_input(mtg, input);
+            break;
+        case StateSearchResults:
+            if (input.type == InputTypeShort) {
+                if (input.key == InputKeyUp && mtg->search_selected > 0) {
+                    mtg->search_selected--;
+                    search_rows_prefetch(mtg);
+                } else if (input.key == InputKeyDown && mtg->search_selected + 1 < mtg->search_count) {
+                    mtg->search_selected++;
+                    search_rows_prefetch(mtg);
+                } else if (input.key == InputKeyOk) {
+                    // Back to the deck list with the chosen deck highlighted
+                    mtg->selected_deck = deck_search_get(mtg->search, mtg->search_first + mtg->search_selected);
+                    mtg->scroll_position = mtg->selected_deck;
+                    mtg->scroll_direction = 0;
+                    deck_list_prefetch(mtg);
+                    mtg->state = StateDeckList;
+                }
+            }
+            break;
+        case StateEditDeletePopup:
+            if (input.type == InputTypeShort) {
+                if (input.key == InputKeyLeft && !mtg->read_only) {
+                    // Delete deck
+                    if (!mtg_decks_make_resident(mtg) || mtg->selected_deck >= mtg->deck_count) {
+                        FURI_LOG_E("MTG", "Deck list reloaded as read-only or shorter, delete dropped");
+                        mtg->state = StateDeckList;
+                        break;
+                    }
+                    deck_store_remove(mtg->decks, mtg->selected_deck);
+                    deck_picker_remove(mtg->picker, mtg->selected_deck);
+                    mtg->deck_count = deck_store_count(mtg->decks);
+                    if (mtg->current_deck >= mtg->deck_count) {
+                        mtg->current_deck = 0;
+                    }
+                    mtg_decks_commit(mtg, DeckJournalOpDelete, mtg->selected_deck);
+                    mtg->state = StateDeckList;
+                } else if (input.key == InputKeyRight && !mtg->read_only) {
+                    // Edit deck
+                    strncpy(mtg->edit_buffer, mtg_deck_name(mtg, mtg->selected_deck), MAX_NAME_LENGTH - 1);
+                    mtg->edit_buffer[MAX_NAME_LENGTH - 1] = '\0';
+                    mtg->state = StateKeyboard;
+                } else if (input.key == InputKeyUp || input.key == InputKeyDown) {
+                    // Weight for the weighted selection mode
+                    uint8_t weight = deck_picker_get_weight(mtg->picker, mtg->selected_deck);
+                    if (input.key == InputKeyUp && weight < DECK_PICKER_WEIGHT_MAX) {
+                        weight++;
+                    } else if (input.key == InputKeyDown && weight > 0) {
+                        weight--;
+                    }
+                    if (!deck_picker_set_weight(mtg->picker, mtg->selected_deck, weight)) {
+                        FURI_LOG_W("MTG", "Deck list too long for weights");
+                    }
+                } else if (input.key == InputKeyBack) {
+                    mtg->state = StateDeckList;
+                }
+            }
+            break;
+        case StateLists:
+            if (input.type == InputTypeShort) {
+                if (input.key == InputKeyUp && mtg->lists_selected > 0) {
+                    mtg->lists_selected--;
+                } else if (input.key == InputKeyDown && mtg->lists_selected + 1 < deck_lists_count(mtg->lists)) {
+                    mtg->lists_selected++;
+                } else if (input.key == InputKeyOk) {
+                    if (mtg->lists_selected != deck_lists_active(mtg->lists)) {
+                        mtg_list_switch(mtg, mtg->lists_selected);
+                    }
+                    mtg->state = StateMainMenu;
+                }
+            }
+            break;
+        case StateStats:
+            if (input.type == InputTypeShort) {
+                if (input.key == InputKeyUp && mtg->selected_deck > 0) {
+                    mtg->selected_deck--;
+                    stats_rows_load(mtg);
+                } else if (input.key == InputKeyDown && mtg->selected_deck < mtg->deck_count - 1) {
+                    mtg->selected_deck++;
+                    stats_rows_load(mtg);
+                } else if (input.key == InputKeyLeft || input.key == InputKeyRight) {
+                    // Report how the game went
+                    mtg_log_play(mtg, mtg->selected_deck, input.key == InputKeyRight ? PlayResultWon : PlayResultLost);
+                    stats_rows_load(mtg);
+                }
+            }
+            break;
+        case StateFilter:
+            if (input.type == InputTypeShort) {
+                DeckFilterRule* rule = &mtg->filter_rule;
+                if (input.key == InputKeyUp && mtg->filter_row > 0) {
+                    mtg->filter_row--;
+                } else if (input.key == InputKeyDown && mtg->filter_row < FilterRowCount - 1) {
+                    mtg->filter_row++;
+                } else if (mtg->filter_row == FilterRowColors) {
+                    uint8_t color = 1 << mtg->filter_column;
+                    if (input.key == InputKeyLeft && mtg->filter_column > 0) {
+                        mtg->filter_column--;
+                    } else if (input.key == InputKeyRight && mtg->filter_column < DECK_COLOR_COUNT - 1) {
+                        mtg->filter_column++;
+                    } else if (input.key == InputKeyOk) {
+                        // any -> excluded -> required -> any
+                        if (rule->without_colors & color) {
+                            rule->without_colors &= ~color;
+                            rule->with_colors |= color;
+                        } else if (rule->with_colors & color) {
+                            rule->with_colors &= ~color;
+                        } else {
+                            rule->without_colors |= color;
+                        }
+                        mtg_filter_update(mtg);
+                    }
+                } else if (mtg->filter_row == FilterRowBracket) {
+                    if (input.key == InputKeyLeft && rule->bracket_max > 0) {
+                        rule->bracket_max--;
+                        mtg_filter_update(mtg);
+                    } else if (input.key == InputKeyRight && rule->bracket_max < DECK_META_BRACKET_MAX) {
+                        rule->bracket_max++;
+                        mtg_filter_update(mtg);
+                    }
+                } else if (mtg->filter_row == FilterRowTag) {
+                    int tag_count = deck_store_tag_count(mtg->decks);
+                    if (input.key == InputKeyLeft && rule->tag >= 0) {
+                        rule->tag--;
+                        mtg_filter_update(mtg);
+                    } else if (input.key == InputKeyRight && rule->tag < tag_count - 1) {
+                        rule->tag++;
+                        mtg_filter_update(mtg);
+                    }
+                } else if (mtg->filter_row == FilterRowClear && input.key == InputKeyOk) {
+                    *rule = DECK_FILTER_RULE_ANY;
+                    mtg_filter_update(mtg);
+                }
+            }
+            break;
+        case StatePodSetup:
+            if (input.type == InputTypeShort) {
+                PodRule* pod = &mtg->pod_rule;
+                if (input.key == InputKeyUp && mtg->pod_row > 0) {
+                    mtg->pod_row--;
+                } else if (input.key == InputKeyDown && mtg->pod_row < PodRowCount - 1) {
+                    mtg->pod_row++;
+                } else if (input.key == InputKeyOk) {
+                    pod_spin_start(mtg);
+                } else if (mtg->pod_row == PodRowSeats) {
+                    if (input.key == InputKeyLeft && pod->seats > POD_SEATS_MIN) {
+                        pod->seats--;
+                    } else if (input.key == InputKeyRight && pod->seats < POD_SEATS_MAX) {
+                        pod->seats++;
+                    }
+                    mtg->pod_result = PodResultOk;
+                } else if (mtg->pod_row == PodRowSpread) {
+                    if (input.key == InputKeyLeft && pod->spread >= 0) {
+                        pod->spread--;
+                    } else if (input.key == InputKeyRight && pod->spread < POD_SPREAD_MAX) {
+                        pod->spread++;
+                    }
+                    mtg->pod_result = PodResultOk;
+                }
+            }
+            break;
+        case StatePodSpinning:
+            break;
+        case StatePodSelected:
+            if (input.key == InputKeyOk) {
+                mtg->state = StateMainMenu;
+            }
+            break;
+    }
+
+    if (input.key == InputKeyBack) {
+        switch (mtg->state) {
+            case StateMainMenu:
+                // Exit the app
+                break;
+            case StateSpinning:
+            case StateSelected:
+            case StateDeckList:
+            case StateStats:
+            case StateLists:
+            case StateFilter:
+            case StatePodSetup:
+            case StatePodSpinning:
+            case StatePodSelected:
+                mtg->state = StateMainMenu;
+                break;
+            case StateKeyboard:
+            case StateEditDeletePopup:
+            case StateSearch:
+                mtg->state = StateDeckList;
+                break;
+            case StateImport:
+                // Decks read in before Back stay, and the file stays to be run again
+                mtg_import_finish(mtg);
+                mtg->state = StateDeckList;
+                break;
+            case StateSearchResults:
+                mtg->state = StateSearch;
+                break;
+        }
+    }
+}
+
+// A held key: lists scroll by the distance its repeats add up to, faster the
+// longer it is held, and the keyboard cursor moves one key per repeat
+static void mtg_deck_randomizer_repeat(MTGDeckRandomizer* mtg, const InputStep* step) {
+    int sign = step->key == InputKeyUp ? -1 : step->key == InputKeyDown ? 1 : 0;
+    switch (mtg->state) {
+        case StateDeckList:
+            deck_list_move(mtg, sign * input_step_distance(step, scroll_page(mtg->deck_count + 1)));
+            break;
+        case StateStats:
+            if (sign && mtg->deck_count > 0) {
+                int target = mtg->selected_deck + sign * input_step_distance(step, scroll_page(mtg->deck_count));
+                mtg->selected_deck = MAX(0, MIN(target, mtg->deck_count - 1));
+                stats_rows_load(mtg);
+            }
+            break;
+        case StateSearchResults:
+            if (sign && mtg->search_count > 0) {
+                int count = mtg->search_count;
+                int target = (int)mtg->search_selected + sign * input_step_distance(step, scroll_page(count));
+                mtg->search_selected = MAX(0, MIN(target, count - 1));
+            }
+            break;
+        case StateLists:
+            if (sign) {
+                int count = deck_lists_count(mtg->lists);
+                int target = (int)mtg->lists_selected + sign * input_step_distance(step, scroll_page(count));
+                mtg->lists_selected = MAX(0, MIN(target, count - 1));
+            }
+            break;
+        case StateKeyboard:
+        case StateSearch:
+            // Holding OK would type the same character over and over
+            if (step->key != InputKeyOk) {
+                InputEvent input = {.key = step->key, .type = InputTypeShort};
+                for (uint16_t i = 0; i < step->repeats; i++) {
+                    keyboard_input(mtg, input);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Apply everything the input thread queued since the last wake-up, so a burst
+// that piled up behind a slow frame costs one redraw
+static void mtg_deck_randomizer_input(MTGDeckRandomizer* mtg) {
+    InputStep step;
+    while (mtg->running && input_pipeline_take(mtg->input, &step)) {
+        if (step.key == InputKeyBack && step.type == InputTypeLong && mtg->state == StateMainMenu) {
+            mtg->running = false;
+        } else if (step.type == InputTypeRepeat) {
+            mtg_deck_randomizer_repeat(mtg, &step);
+        } else {
+            InputEvent input = {.key = step.key, .type = step.type};
+            mtg_deck_randomizer_update_state(mtg, input);
+        }
+        mtg->dirty = true;
+    }
+}
+
+static void mtg_deck_randomizer_frame_callback(void* ctx) {
+    MTGDeckRandomizer* mtg = ctx;
+    MTGEvent event = {.type = MTGEventTypeFrame};
+    // A frame that finds the queue full is simply skipped; the next one catches up
+    furi_message_queue_put(mtg->event_queue, &event, 0);
+}
+
+// Advance animations from the time elapsed since they started, so their speed
+// does not depend on how often frames actually arrive
+static void mtg_deck_randomizer_frame(MTGDeckRandomizer* mtg) {
+    uint32_t now = mtg_tick(mtg);
+    switch (mtg->state) {
+        case StateSpinning:
+            {
+                uint32_t elapsed = now - mtg->spin_start_time;
+                if (elapsed < SPIN_DURATION) {
+                    mtg->spin_offset = spin_offset_at(mtg, elapsed);
+                } else {
+                    mtg->spin_offset = spin_offset_at(mtg, SPIN_DURATION);
+                    mtg->state = StateSelected;
+                    mtg_log_play(mtg, mtg->current_deck, PlayResultPicked);
+                    mtg->blink_start_time = now;
+                    mtg->blink_visible = true;
+                }
+                spin_rows_prefetch(mtg);
+                mtg->dirty = true;
+            }
+            break;
+        case StatePodSpinning:
+            {
+                // Redraw only when some seat's reel moves on
+                uint32_t elapsed = now - mtg->spin_start_time;
+                for (int seat = 0; seat < mtg->pod_rule.seats; seat++) {
+                    int deck = pod_reel_at(mtg, seat, elapsed);
+                    mtg->dirty |= deck != mtg->pod_reels[seat];
+                    mtg->pod_reels[seat] = deck;
+                }
+                pod_reels_prefetch(mtg);
+                if (elapsed >= SPIN_DURATION) {
+                    mtg->state = StatePodSelected;
+                    mtg->current_deck = mtg->pod_decks[0];
+                    for (int seat = 0; seat < mtg->pod_rule.seats; seat++) {
+                        mtg_log_play(mtg, mtg->pod_decks[seat], PlayResultPicked);
+                    }
+                    mtg->dirty = true;
+                }
+            }
+            break;
+        case StateSelected:
+            {
+                uint32_t elapsed = now - mtg->blink_start_time;
+                if (elapsed < BLINK_DURATION) {
+                    // Only a change of blink phase needs a redraw
+                    bool visible = (elapsed / BLINK_INTERVAL) % 2 == 0;
+                    mtg->dirty |= visible != mtg->blink_visible;
+                    mtg->blink_visible = visible;
+                } else {
+                    mtg->state = StateMainMenu;
+                    mtg->dirty = true;
+                }
+            }
+            break;
+        case StateImport:
+            if (mtg->import) mtg_import_step(mtg);
+            break;
+        default:
+            break;
+    }
+}
+
+static bool mtg_deck_randomizer_animating(MTGDeckRandomizer* mtg) {
+    return mtg->state == StateSpinning || mtg->state == StateSelected || mtg->state == StatePodSpinning ||
+           (mtg->state == StateImport && mtg->import);
+}
+
+// The frame timer runs only while something on screen is animating; a replay
+// steps frames itself
+static void mtg_deck_randomizer_schedule_frames(MTGDeckRandomizer* mtg) {
+    if (mtg->replaying) return;
+    bool animating = mtg_deck_randomizer_animating(mtg);
+    if (animating && !furi_timer_is_running(mtg->frame_timer)) {
+        furi_timer_start(mtg->frame_timer, furi_ms_to_ticks(1000 / FRAME_RATE));
+    } else if (!animating && furi_timer_is_running(mtg->frame_timer)) {
+        furi_timer_stop(mtg->frame_timer);
+    }
+}
+
+// Apply one event with the mutex held; the caller redraws if it left the view dirty
+static void mtg_deck_randomizer_handle_event(MTGDeckRandomizer* mtg, const MTGEvent* event) {
+    PERF_SCOPE(PerfScopeEvent);
+    // Input left behind by a wake-up that found the queue full is picked up
+    // with whatever event comes next
+    mtg_deck_randomizer_input(mtg);
+    switch (event->type) {
+        case MTGEventTypeInput:
+            break;
+        case MTGEventTypeStorage:
+            mtg_deck_randomizer_storage_event(mtg);
+            break;
+        case MTGEventTypeFrame:
+            mtg_deck_randomizer_frame(mtg);
+            break;
+    }
+    mtg_deck_randomizer_schedule_frames(mtg);
+}
+
+static MTGDeckRandomizer* mtg_deck_randomizer_alloc(void) {
+    MTGDeckRandomizer* mtg = malloc(sizeof(MTGDeckRandomizer));
+
+    // Initialize MTGDeckRandomizer
+    mtg->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    mtg->event_queue = furi_message_queue_alloc(8, sizeof(MTGEvent));
+    mtg->input = input_pipeline_alloc();
+    mtg->running = true;
+    mtg->perf_overlay = false;
+    mtg->trace = NULL;
+    mtg->replaying = false;
+    mtg->replay_tick = 0;
+    mtg->replay_timestamp = 0;
+    mtg->frame_timer = furi_timer_alloc(mtg_deck_randomizer_frame_callback, FuriTimerTypePeriodic, mtg);
+    mtg->dirty = true;
+    mtg->decks = deck_store_alloc();
+    mtg->index = NULL;
+    mtg->names = name_cache_alloc(NAME_CACHE_SLOTS, MAX_NAME_LENGTH, mtg_deck_name_fetch, mtg);
+    // Startup reads the manifest only; the folder is listed when the picker opens
+    mtg->lists = deck_lists_open(APP_FOLDER, DECK_LISTS_PATH, DECK_LIST_DEFAULT);
+    mtg->lists_selected = 0;
+    deck_lists_set_active(mtg->lists, deck_lists_active(mtg->lists), furi_hal_rtc_get_timestamp());
+    mtg_list_attach(mtg);
+    mtg->plays = play_log_open(PLAY_HISTORY_PATH, PLAY_STATS_PATH, PLAY_HISTORY_SIZE);
+    mtg->stats_rows_start = 0;
+    mtg->filter = deck_filter_alloc();
+    mtg->filter_rule = DECK_FILTER_RULE_ANY;
+    mtg->filter_stale = true;
+    mtg->filter_row = 0;
+    mtg->filter_column = 0;
+    mtg->pod_rule = (PodRule){.seats = POD_SEATS_DEFAULT, .spread = -1};
+    mtg->pod_row = 0;
+    mtg->pod_result = PodResultOk;
+    mtg->pod_available = 0;
+    memset(mtg->pod_decks, 0, sizeof(mtg->pod_decks));
+    memset(mtg->pod_reels, 0, sizeof(mtg->pod_reels));
+    mtg->search = deck_search_alloc(mtg_search_name, mtg);
+    mtg->search_stale = true;
+    mtg->search_first = 0;
+    mtg->search_count = 0;
+    mtg->search_selected = 0;
+    mtg->import = NULL;
+    mtg->import_status = DeckImportStatusDone;
+    memset(&mtg->import_progress, 0, sizeof(mtg->import_progress));
+    mtg->import_path[0] = '\0';
+    mtg->deck_count = 0;
+    mtg->current_deck = 0;
+    mtg->selected_deck = 0;
+    mtg->state = StateMainMenu;
+    mtg->edit_buffer[0] = '\0';
+    mtg->spin_start_time = 0;
+    mtg->spin_offset = 0;
+    spin_widths_reset(mtg);
+    mtg->blink_start_time = 0;
+    mtg->blink_visible = false;
+    mtg->is_blinking = false;
+    mtg->keyboard_layout = KeyboardLayoutLower;
+    mtg->selected_row = 0;
+    mtg->selected_column = 0;
+    mtg->scroll_position = 0;
+    mtg->scroll_direction = 0;
+
+    return mtg;
+}
+
+static void mtg_deck_randomizer_free(MTGDeckRandomizer* mtg) {
+    mtg_list_detach(mtg);
+    // With the worker stopped the list file is final, so its count can be stamped
+    deck_lists_set_count(mtg->lists, mtg->deck_count);
+    deck_lists_sync(mtg->lists);
+    deck_lists_close(mtg->lists);
+    furi_timer_free(mtg->frame_timer);
+    play_log_close(mtg->plays);
+    deck_filter_free(mtg->filter);
+    deck_search_free(mtg->search);
+    if (mtg->index) {
+        deck_index_close(mtg->index);
+    }
+    name_cache_free(mtg->names);
+    deck_store_free(mtg->decks);
+    furi_message_queue_free(mtg->event_queue);
+    input_pipeline_free(mtg->input);
+    furi_mutex_free(mtg->mutex);
+    free(mtg);
+}
+
+// Move the virtual clock on by delta, stepping animation frames at the rate
+// the frame timer would have delivered them
+static void mtg_replay_advance(MTGDeckRandomizer* mtg, uint32_t delta) {
+    uint32_t target = mtg->replay_tick + delta;
+    uint32_t period = 1000 / FRAME_RATE;
+    while (mtg_deck_randomizer_animating(mtg) && target - mtg->replay_tick >= period) {
+        mtg->replay_tick += period;
+        mtg_deck_randomizer_frame(mtg);
+    }
+    mtg->replay_tick = target;
+}
+
+// What the state machine decided, for telling two replays apart; the deck
+// names are covered by the deck file's own hash
+static uint32_t mtg_state_hash(MTGDeckRandomizer* mtg) {
+    int32_t fields[] = {
+        mtg->state,
+        mtg->deck_count,
+        mtg->current_deck,
+        mtg->selected_deck,
+        mtg->scroll_position,
+        mtg->keyboard_layout,
+        mtg->selected_row,
+        mtg->selected_column,
+        deck_picker_get_mode(mtg->picker),
+        deck_lists_active(mtg->lists),
+        mtg->filter_row,
+        mtg->pod_row,
+        mtg->pod_result,
+        mtg->search_selected,
+    };
+    uint32_t hash = mtg_checksum(MTG_CHECKSUM_SEED, fields, sizeof(fields));
+    hash = mtg_checksum(hash, &mtg->filter_rule, sizeof(mtg->filter_rule));
+    hash = mtg_checksum(hash, &mtg->pod_rule, sizeof(mtg->pod_rule));
+    hash = mtg_checksum(hash, mtg->pod_decks, sizeof(mtg->pod_decks));
+    return mtg_checksum(hash, mtg->edit_buffer, strlen(mtg->edit_buffer));
+}
+
+// Append the active deck file to the report, hashed as it goes
+static void mtg_replay_report_decks(MTGDeckRandomizer* mtg, Storage* storage, BlockWriter* report) {
+    File* file = storage_file_alloc(storage);
+    uint32_t hash = MTG_CHECKSUM_SEED;
+    uint32_t size = 0;
+    char line[96];
+    if (storage_file_open(file, mtg->paths.text, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        char* chunk = malloc(REPLAY_REPORT_BLOCK_SIZE);
+        size_t read;
+        while ((read = mtg_file_read(file, chunk, REPLAY_REPORT_BLOCK_SIZE)) > 0) {
+            hash = mtg_checksum(hash, chunk, read);
+            size += read;
+        }
+        int length = snprintf(
+            line, sizeof(line), "decks %s 0x%08lx %lu bytes\n", mtg->paths.text, (unsigned long)hash, (unsigned long)size);
+        block_writer_put(report, line, length);
+        storage_file_seek(file, 0, true);
+        while ((read = mtg_file_read(file, chunk, REPLAY_REPORT_BLOCK_SIZE)) > 0) {
+            block_writer_put(report, chunk, read);
+        }
+        free(chunk);
+    } else {
+        int length = snprintf(line, sizeof(line), "decks %s missing\n", mtg->paths.text);
+        block_writer_put(report, line, length);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+}
+
+// Feed a recorded trace through the state machine on a virtual clock, with no
+// GUI, and write what happened to REPLAY_REPORT_PATH: one line per event with
+// its handling time, then the final state hash and the deck file. Storage
+// worker results are collected before every event, so two replays of a trace
+// against the same files come out the same
+static bool mtg_replay(MTGDeckRandomizer* mtg, const char* trace_path) {
+    TraceHeader header;
+    TraceReader* reader = trace_reader_open(trace_path, &header);
+    if (reader) {
+        mtg->replaying = true;
+        mtg->replay_tick = 0;
+        mtg->replay_timestamp = header.timestamp;
+        deck_picker_random_seed(header.seed);
+    }
+    // Loaded either way, so exiting leaves the list as it was found
+    load_decks(mtg);
+    if (!reader) return false;
+
+    if (header.deck_count != (uint32_t)mtg->deck_count) {
+        FURI_LOG_W(
+            "MTG", "Trace was recorded with %lu decks, replaying with %d", (unsigned long)header.deck_count, mtg->deck_count);
+    }
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool success = false;
+    if (storage_file_open(file, REPLAY_REPORT_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        BlockWriter* report = block_writer_alloc(file, REPLAY_REPORT_BLOCK_SIZE);
+        char line[96];
+        int length = snprintf(
+            line,
+            sizeof(line),
+            "seed 0x%08lx events %lu dropped %lu\n",
+            (unsigned long)header.seed,
+            (unsigned long)header.count,
+            (unsigned long)header.dropped);
+        block_writer_put(report, "trace ", 6);
+        block_writer_put(report, trace_path, strlen(trace_path));
+        block_writer_put(report, " ", 1);
+        block_writer_put(report, line, length);
+        block_writer_put(report, "event,tick,key,type,micros\n", 27);
+
+        TraceRecord record;
+        uint32_t events = 0;
+        uint64_t total_micros = 0;
+        uint32_t max_micros = 0;
+        while (mtg->running && trace_reader_next(reader, &record)) {
+            mtg_replay_advance(mtg, record.delta);
+            storage_worker_flush(mtg->storage);
+            mtg_deck_randomizer_storage_event(mtg);
+
+            InputEvent input = {.key = record.key, .type = record.type};
+            input_pipeline_push(mtg->input, &input);
+            MTGEvent event = {.type = MTGEventTypeInput};
+            uint32_t cycles = DWT->CYCCNT;
+            mtg_deck_randomizer_handle_event(mtg, &event);
+            uint32_t micros = (DWT->CYCCNT - cycles) / furi_hal_cortex_instructions_per_microsecond();
+            mtg->dirty = false;
+
+            total_micros += micros;
+            max_micros = MAX(max_micros, micros);
+            length = snprintf(
+                line,
+                sizeof(line),
+                "%lu,%lu,%s,%s,%lu\n",
+                (unsigned long)events++,
+                (unsigned long)mtg->replay_tick,
+                input_get_key_name(input.key),
+                input_get_type_name(input.type),
+                (unsigned long)micros);
+            block_writer_put(report, line, length);
+        }
+
+        // Let the session's last save land before the deck file is read back
+        mtg_list_finish(mtg);
+        storage_worker_flush(mtg->storage);
+        length = snprintf(
+            line,
+            sizeof(line),
+            "events %lu total %lu us max %lu us\nstate 0x%08lx\n",
+            (unsigned long)events,
+            (unsigned long)total_micros,
+            (unsigned long)max_micros,
+            (unsigned long)mtg_state_hash(mtg));
+        block_writer_put(report, line, length);
+        mtg_replay_report_decks(mtg, storage, report);
+        success = block_writer_flush(report);
+        block_writer_free(report);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    trace_reader_close(reader);
+
+    if (!success) FURI_LOG_E("MTG", "Failed to write %s", REPLAY_REPORT_PATH);
+    return success;
+}
+
+int32_t mtg_deck_randomizer_app(void* p) {
+    // Launch arguments: "record" traces the session's input to TRACE_PATH,
+    // "replay [path]" plays a trace back without the GUI
+    const char* args = p ? p : "";
+    MTGDeckRandomizer* mtg = mtg_deck_randomizer_alloc();
+
+    if (strncmp(args, "replay", 6) == 0) {
+        bool replayed = mtg_replay(mtg, args[6] == ' ' ? args + 7 : TRACE_PATH);
+        deck_picker_random_seed(0);
+        mtg_deck_randomizer_free(mtg);
+        return replayed ? 0 : -1;
+    }
+
+    // The picker's first draws happen while loading, so the seed goes in first
+    bool record = strcmp(args, "record") == 0;
+    uint32_t seed = furi_hal_random_get() | 1;
+    if (record) deck_picker_random_seed(seed);
+
+    // Load decks from storage
+    load_decks(mtg);
+
+    if (record) {
+        mtg->trace = trace_recorder_open(TRACE_PATH, seed, furi_hal_rtc_get_timestamp(), mtg->deck_count);
+        if (!mtg->trace) deck_picker_random_seed(0);
+    }
+
+    // Create GUI
+    Gui* gui = furi_record_open(RECORD_GUI);
+    ViewPort* view_port = view_port_alloc();
+    view_port_draw_callback_set(view_port, mtg_deck_randomizer_draw_callback, mtg);
+    gui_add_view_port(gui, view_port, GuiLayerFullscreen);
+
+    // Input wakes the main loop through the same queue as storage worker reports
+    view_port_input_callback_set(view_port, mtg_deck_randomizer_input_callback, mtg);
+
+    // Main loop: sleeps until input, a storage report or an animation frame
+    // arrives, and redraws only when one of them changed what is on screen
+    MTGEvent event;
+    while (mtg->running) {
+        if (furi_message_queue_get(mtg->event_queue, &event, FuriWaitForever) == FuriStatusOk) {
+            furi_check(furi_mutex_acquire(mtg->mutex, FuriWaitForever) == FuriStatusOk);
+            mtg_deck_randomizer_handle_event(mtg, &event);
+            perf_note_stack(PerfThreadMain);
+            bool dirty = mtg->dirty && mtg->running;
+            mtg->dirty = false;
+            furi_mutex_release(mtg->mutex);
+            if (dirty) view_port_update(view_port);
+            if (mtg->trace) trace_recorder_write(mtg->trace);
+        }
+    }
+    furi_timer_stop(mtg->frame_timer);
+
+    // Cleanup
+    view_port_enabled_set(view_port, false);
+    gui_remove_view_port(gui, view_port);
+    view_port_free(view_port);
+    furi_record_close(RECORD_GUI);
+
+    // Input has stopped with the view port gone, so the trace is complete
+    if (mtg->trace) {
+        trace_recorder_close(mtg->trace);
+        mtg->trace = NULL;
+        deck_picker_random_seed(0);
+    }
+
+    mtg_list_finish(mtg);
+    bool perf_dump_wanted = mtg->perf_overlay;
+    mtg_deck_randomizer_free(mtg);
+    // Written last, so the samples include the final save
+    if (perf_dump_wanted) perf_dump(PERF_CSV_PATH);
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include "mtg_deck_search.h"
+
+#define DECK_SEARCH_INITIAL_CAPACITY 16
+// Longest name prefix that takes part in ordering a new or renamed deck
+#define DECK_SEARCH_NAME_SIZE 64
+
+struct DeckSearch {
+    DeckSearchName name;
+    void* context;
+    uint16_t* order;
+    size_t count;
+    size_t capacity;
+};
+
+static inline char deck_search_fold(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+    if (c == '_') return ' ';
+    return c;
+}
+
+DeckSearch* deck_search_alloc(DeckSearchName name, void* context) {
+    furi_assert(name);
+    DeckSearch* search = malloc(sizeof(DeckSearch));
+    search->name = name;
+    search->context = context;
+    search->order = NULL;
+    search->count = 0;
+    search->capacity = 0;
+    return search;
+}
+
+void deck_search_free(DeckSearch* search) {
+    furi_assert(search);
+    free(search->order);
+    free(search);
+}
+
+int deck_search_compare(const char* a, const char* b) {
+    for (;; a++, b++) {
+        unsigned char fa = deck_search_fold(*a);
+        unsigned char fb = deck_search_fold(*b);
+        if (fa != fb) return fa < fb ? -1 : 1;
+        if (!fa) return 0;
+    }
+}
+
+// Like deck_search_compare, but a name that starts with prefix compares equal
+static int deck_search_compare_prefix(const char* name, const char* prefix) {
+    for (; *prefix; name++, prefix++) {
+        unsigned char fn = deck_search_fold(*name);
+        unsigned char fp = deck_search_fold(*prefix);
+        if (fn != fp) return fn < fp ? -1 : 1;
+    }
+    return 0;
+}
+
+bool deck_search_sort(const DeckStore* store, uint16_t* order) {
+    furi_assert(store);
+    furi_assert(order);
+
+    size_t count = deck_store_count(store);
+    uint16_t* buffer = malloc(MAX(count, (size_t)1) * sizeof(uint16_t));
+    if (!buffer) return false;
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+
+    // Bottom-up merge sort, stable so equal names stay in list order
+    uint16_t* from = order;
+    uint16_t* to = buffer;
+    for (size_t width = 1; width < count; width *= 2) {
+        for (size_t low = 0; low < count; low += 2 * width) {
+            size_t middle = MIN(low + width, count);
+            size_t high = MIN(low + 2 * width, count);
+            size_t left = low;
+            size_t right = middle;
+            for (size_t out = low; out < high; out++) {
+                if (right >= high || (left < middle && deck_search_compare(
+                                                          deck_store_get(store, from[left]),
+                                                          deck_store_get(store, from[right])) <= 0)) {
+                    to[out] = from[left++];
+                } else {
+                    to[out] = from[right++];
+                }
+            }
+        }
+        uint16_t* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != order) memcpy(order, from, count * sizeof(uint16_t));
+
+    free(buffer);
+    return true;
+}
+
+static bool deck_search_reserve(DeckSearch* search, size_t count) {
+    if (count <= search->capacity) return true;
+
+    size_t capacity = search->capacity ? search->capacity : DECK_SEARCH_INITIAL_CAPACITY;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    uint16_t* order = realloc(search->order, capacity * sizeof(uint16_t));
+    if (!order) return false;
+    search->order = order;
+    search->capacity = capacity;
+    return true;
+}
+
+uint16_t* deck_search_reset(DeckSearch* search, size_t count) {
+    furi_assert(search);
+    furi_assert(count <= DECK_STORE_ENTRIES_MAX);
+
+    search->count = 0;
+    if (!deck_search_reserve(search, MAX(count, (size_t)1))) return NULL;
+    search->count = count;
+    return search->order;
+}
+
+// First rank whose name does not sort before name
+static size_t deck_search_lower_bound(DeckSearch* search, const char* name) {
+    size_t low = 0;
+    size_t high = search->count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (deck_search_compare(search->name(search->context, search->order[middle]), name) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static size_t deck_search_rank_of(const DeckSearch* search, size_t position) {
+    for (size_t rank = 0; rank < search->count; rank++) {
+        if (search->order[rank] == position) return rank;
+    }
+    furi_crash("Deck missing from search order");
+}
+
+// Put the deck at position into its place, with the entry at rank free to take
+static void deck_search_place(DeckSearch* search, size_t position, size_t rank) {
+    // Drop the free entry, then open one where the name belongs
+    memmove(&search->order[rank], &search->order[rank + 1], (search->count - rank - 1) * sizeof(uint16_t));
+    search->count--;
+
+    char name[DECK_SEARCH_NAME_SIZE];
+    strncpy(name, search->name(search->context, position), sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    size_t place = deck_search_lower_bound(search, name);
+    memmove(&search->order[place + 1], &search->order[place], (search->count - place) * sizeof(uint16_t));
+    search->order[place] = position;
+    search->count++;
+}
+
+bool deck_search_insert(DeckSearch* search, size_t position) {
+    furi_assert(search);
+    furi_assert(position <= search->count);
+
+    if (!deck_search_reserve(search, search->count + 1)) return false;
+    for (size_t rank = 0; rank < search->count; rank++) {
+        if (search->order[rank] >= position) search->order[rank]++;
+    }
+    search->order[search->count++] = position;
+    deck_search_place(search, position, search->count - 1);
+    return true;
+}
+
+void deck_search_update(DeckSearch* search, size_t position) {
+    furi_assert(search);
+    furi_assert(position < search->count);
+    deck_search_place(search, position, deck_search_rank_of(search, position));
+}
+
+void deck_search_remove(DeckSearch* search, size_t position) {
+    furi_assert(search);
+    furi_assert(position < search->count);
+
+    size_t rank = deck_search_rank_of(search, position);
+    memmove(&search->order[rank], &search->order[rank + 1], (search->count - rank - 1) * sizeof(uint16_t));
+    search->count--;
+    for (size_t i = 0; i < search->count; i++) {
+        if (search->order[i] > position) search->order[i]--;
+    }
+}
+
+size_t deck_search_find(DeckSearch* search, const char* prefix, size_t* first) {
+    furi_assert(search);
+    furi_assert(prefix);
+    furi_assert(first);
+
+    // The matches run from the first name not before the prefix up to the
+    // first name after every name starting with it
+    size_t low = 0;
+    size_t high = search->count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (deck_search_compare_prefix(search->name(search->context, search->order[middle]), prefix) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *first = low;
+
+    high = search->count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (deck_search_compare_prefix(search->name(search->context, search->order[middle]), prefix) <= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low - *first;
+}
+
+uint32_t deck_search_get(const DeckSearch* search, size_t rank) {
+    furi_assert(search);
+    furi_assert(rank < search->count);
+    return search->order[rank];
+}
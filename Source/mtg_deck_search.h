@@ -0,0 +1,67 @@
+#pragma once
+
+#include <furi.h>
+
+#include "mtg_deck_store.h"
+
+/* Type-ahead search over deck names
+ *
+ * Deck positions are kept in an array sorted by case-folded name, two bytes
+ * per deck. The decks starting with a prefix are one contiguous run of that
+ * array, found with two binary searches: a keystroke costs O(log n) name
+ * comparisons plus the k results actually shown, never a scan of the list.
+ *
+ * Names are read through a callback, so a paged list compares through the
+ * name cache; the names a binary search visits first are the same on every
+ * keystroke and stay cached. Adding, renaming or deleting a deck moves one
+ * entry into place instead of sorting again.
+ *
+ * Folding maps A-Z to a-z and '_' to ' ', so names typed on the on-screen
+ * keyboard find names with spaces.
+ */
+
+/** Name of the deck at a position, valid until the next call */
+typedef const char* (*DeckSearchName)(void* context, uint32_t position);
+
+typedef struct DeckSearch DeckSearch;
+
+DeckSearch* deck_search_alloc(DeckSearchName name, void* context);
+
+void deck_search_free(DeckSearch* search);
+
+/** Compare two names as the search orders them */
+int deck_search_compare(const char* a, const char* b);
+
+/** Fill order with the positions of the store's decks in search order
+ *
+ * @return false if memory is short
+ */
+bool deck_search_sort(const DeckStore* store, uint16_t* order);
+
+/** Take over an order for count decks, as produced by deck_search_sort
+ *
+ * @return order to fill in, count entries long, or NULL if memory is short
+ */
+uint16_t* deck_search_reset(DeckSearch* search, size_t count);
+
+/** A deck was appended or inserted at position
+ *
+ * @return false if memory is short; the order is then left without the deck
+ */
+bool deck_search_insert(DeckSearch* search, size_t position);
+
+/** The deck at position was renamed */
+void deck_search_update(DeckSearch* search, size_t position);
+
+/** The deck at position was deleted */
+void deck_search_remove(DeckSearch* search, size_t position);
+
+/** Find the decks whose folded name starts with prefix
+ *
+ * @param first  rank of the first match, for deck_search_get
+ * @return       number of matches
+ */
+size_t deck_search_find(DeckSearch* search, const char* prefix, size_t* first);
+
+/** Position of the deck at a rank in search order */
+uint32_t deck_search_get(const DeckSearch* search, size_t rank);
@@ -0,0 +1,246 @@
+#include "mtg_deck_store.h"
+
+#define DECK_STORE_INITIAL_POOL    256
+#define DECK_STORE_INITIAL_ENTRIES 16
+
+typedef struct {
+    uint32_t offset;
+    uint16_t length;
+    DeckMeta meta;
+} DeckStoreEntry;
+
+struct DeckStore {
+    char* pool;
+    size_t pool_used;
+    size_t pool_capacity;
+    DeckStoreEntry* entries;
+    size_t count;
+    size_t capacity;
+    // Allocated on first use, DECK_META_TAGS_MAX names
+    char (*tags)[DECK_META_TAG_SIZE];
+    size_t tag_count;
+};
+
+DeckStore* deck_store_alloc(void) {
+    DeckStore* store = malloc(sizeof(DeckStore));
+    store->pool = NULL;
+    store->pool_used = 0;
+    store->pool_capacity = 0;
+    store->entries = NULL;
+    store->count = 0;
+    store->capacity = 0;
+    store->tags = NULL;
+    store->tag_count = 0;
+    return store;
+}
+
+void deck_store_free(DeckStore* store) {
+    furi_assert(store);
+    free(store->pool);
+    free(store->entries);
+    free(store->tags);
+    free(store);
+}
+
+DeckStore* deck_store_clone(const DeckStore* store) {
+    furi_assert(store);
+
+    DeckStore* clone = deck_store_alloc();
+    clone->pool = malloc(MAX(store->pool_used, (size_t)1));
+    clone->entries = malloc(MAX(store->count, (size_t)1) * sizeof(DeckStoreEntry));
+    if (!clone->pool || !clone->entries) {
+        deck_store_free(clone);
+        return NULL;
+    }
+    memcpy(clone->pool, store->pool, store->pool_used);
+    memcpy(clone->entries, store->entries, store->count * sizeof(DeckStoreEntry));
+    clone->pool_used = clone->pool_capacity = store->pool_used;
+    clone->count = clone->capacity = store->count;
+    if (store->tag_count > 0) {
+        clone->tags = malloc(DECK_META_TAGS_MAX * DECK_META_TAG_SIZE);
+        if (!clone->tags) {
+            deck_store_free(clone);
+            return NULL;
+        }
+        memcpy(clone->tags, store->tags, store->tag_count * DECK_META_TAG_SIZE);
+        clone->tag_count = store->tag_count;
+    }
+    return clone;
+}
+
+void deck_store_reset(DeckStore* store) {
+    furi_assert(store);
+    store->pool_used = 0;
+    store->count = 0;
+    store->tag_count = 0;
+}
+
+size_t deck_store_count(const DeckStore* store) {
+    furi_assert(store);
+    return store->count;
+}
+
+const char* deck_store_get(const DeckStore* store, size_t index) {
+    furi_assert(store);
+    furi_assert(index < store->count);
+    return store->pool + store->entries[index].offset;
+}
+
+size_t deck_store_get_length(const DeckStore* store, size_t index) {
+    furi_assert(store);
+    furi_assert(index < store->count);
+    return store->entries[index].length;
+}
+
+static bool deck_store_reserve_pool(DeckStore* store, size_t size) {
+    if (size > DECK_STORE_POOL_MAX) return false;
+    if (size <= store->pool_capacity) return true;
+
+    size_t capacity = store->pool_capacity ? store->pool_capacity : DECK_STORE_INITIAL_POOL;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    capacity = MIN(capacity, (size_t)DECK_STORE_POOL_MAX);
+
+    char* pool = realloc(store->pool, capacity);
+    if (!pool) return false;
+    store->pool = pool;
+    store->pool_capacity = capacity;
+    return true;
+}
+
+static bool deck_store_reserve_entries(DeckStore* store, size_t count) {
+    if (count > DECK_STORE_ENTRIES_MAX) return false;
+    if (count <= store->capacity) return true;
+
+    size_t capacity = store->capacity ? store->capacity * 2 : DECK_STORE_INITIAL_ENTRIES;
+    capacity = MIN(capacity, (size_t)DECK_STORE_ENTRIES_MAX);
+
+    DeckStoreEntry* entries = realloc(store->entries, capacity * sizeof(DeckStoreEntry));
+    if (!entries) return false;
+    store->entries = entries;
+    store->capacity = capacity;
+    return true;
+}
+
+static uint32_t deck_store_append_name(DeckStore* store, const char* name, size_t length) {
+    uint32_t offset = store->pool_used;
+    memcpy(store->pool + offset, name, length);
+    store->pool[offset + length] = '\0';
+    store->pool_used += length + 1;
+    return offset;
+}
+
+// Close the gap left by a name, shifting every later name down
+static void deck_store_cut(DeckStore* store, const DeckStoreEntry* entry) {
+    size_t offset = entry->offset;
+    size_t size = entry->length + 1;
+
+    memmove(store->pool + offset, store->pool + offset + size, store->pool_used - offset - size);
+    store->pool_used -= size;
+
+    for (size_t i = 0; i < store->count; i++) {
+        if (store->entries[i].offset > offset) store->entries[i].offset -= size;
+    }
+}
+
+bool deck_store_add(DeckStore* store, const char* name, size_t length) {
+    furi_assert(store);
+    furi_assert(name);
+
+    if (!deck_store_reserve_entries(store, store->count + 1)) return false;
+    if (!deck_store_reserve_pool(store, store->pool_used + length + 1)) return false;
+
+    DeckStoreEntry* entry = &store->entries[store->count];
+    entry->offset = deck_store_append_name(store, name, length);
+    entry->length = length;
+    entry->meta = DECK_META_NONE;
+    store->count++;
+    return true;
+}
+
+bool deck_store_set(DeckStore* store, size_t index, const char* name, size_t length) {
+    furi_assert(store);
+    furi_assert(name);
+    furi_assert(index < store->count);
+    // The pool may move or shift underneath, so the name must come from elsewhere
+    furi_assert(name < store->pool || name >= store->pool + store->pool_capacity);
+
+    DeckStoreEntry* entry = &store->entries[index];
+    if (entry->length == length) {
+        memcpy(store->pool + entry->offset, name, length);
+        return true;
+    }
+
+    if (!deck_store_reserve_pool(store, store->pool_used - entry->length + length)) return false;
+
+    deck_store_cut(store, entry);
+    entry->offset = deck_store_append_name(store, name, length);
+    entry->length = length;
+    return true;
+}
+
+DeckMeta deck_store_get_meta(const DeckStore* store, size_t index) {
+    furi_assert(store);
+    furi_assert(index < store->count);
+    return store->entries[index].meta;
+}
+
+void deck_store_set_meta(DeckStore* store, size_t index, DeckMeta meta) {
+    furi_assert(store);
+    furi_assert(index < store->count);
+    store->entries[index].meta = meta;
+}
+
+int deck_store_tag(DeckStore* store, const char* name, size_t length) {
+    furi_assert(store);
+    furi_assert(name);
+
+    length = MIN(length, (size_t)DECK_META_TAG_SIZE - 1);
+    for (size_t id = 0; id < store->tag_count; id++) {
+        if (strncmp(store->tags[id], name, length) == 0 && store->tags[id][length] == '\0') return id;
+    }
+    if (store->tag_count == DECK_META_TAGS_MAX) return -1;
+
+    if (!store->tags) {
+        store->tags = malloc(DECK_META_TAGS_MAX * DECK_META_TAG_SIZE);
+        if (!store->tags) return -1;
+    }
+    memcpy(store->tags[store->tag_count], name, length);
+    store->tags[store->tag_count][length] = '\0';
+    return store->tag_count++;
+}
+
+size_t deck_store_tag_count(const DeckStore* store) {
+    furi_assert(store);
+    return store->tag_count;
+}
+
+const char* deck_store_tag_name(const DeckStore* store, size_t id) {
+    furi_assert(store);
+    furi_assert(id < store->tag_count);
+    return store->tags[id];
+}
+
+void deck_store_remove(DeckStore* store, size_t index) {
+    furi_assert(store);
+    furi_assert(index < store->count);
+
+    deck_store_cut(store, &store->entries[index]);
+    memmove(
+        &store->entries[index],
+        &store->entries[index + 1],
+        (store->count - index - 1) * sizeof(DeckStoreEntry));
+    store->count--;
+}
+
+size_t deck_store_pool_used(const DeckStore* store) {
+    furi_assert(store);
+    return store->pool_used;
+}
+
+size_t deck_store_memory_used(const DeckStore* store) {
+    furi_assert(store);
+    size_t tags = store->tags ? DECK_META_TAGS_MAX * DECK_META_TAG_SIZE : 0;
+    return sizeof(DeckStore) + store->pool_capacity + store->capacity * sizeof(DeckStoreEntry) + tags;
+}
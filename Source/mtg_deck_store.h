@@ -0,0 +1,69 @@
+#pragma once
+
+#include <furi.h>
+
+#include "mtg_deck_meta.h"
+
+// Names live in one contiguous pool addressed by 32-bit offsets, so the pool
+// is bounded by the heap rather than the offset width. Positions elsewhere are
+// 16-bit, which caps the deck count
+#define DECK_STORE_POOL_MAX    (16UL * 1024 * 1024)
+#define DECK_STORE_ENTRIES_MAX UINT16_MAX
+
+typedef struct DeckStore DeckStore;
+
+DeckStore* deck_store_alloc(void);
+
+void deck_store_free(DeckStore* store);
+
+/** Copy a store into a new one sized to fit exactly
+ *
+ * @return NULL if memory is short
+ */
+DeckStore* deck_store_clone(const DeckStore* store);
+
+/** Drop all decks but keep the allocated pool for reuse */
+void deck_store_reset(DeckStore* store);
+
+size_t deck_store_count(const DeckStore* store);
+
+/** Get a deck name, NUL-terminated and valid until the store is modified */
+const char* deck_store_get(const DeckStore* store, size_t index);
+
+size_t deck_store_get_length(const DeckStore* store, size_t index);
+
+/** Append a deck
+ *
+ * @return false if the pool or the entry table is full
+ */
+bool deck_store_add(DeckStore* store, const char* name, size_t length);
+
+/** Replace the name of an existing deck, keeping its position
+ *
+ * The new name must not point into the store itself.
+ */
+bool deck_store_set(DeckStore* store, size_t index, const char* name, size_t length);
+
+/** Metadata of a deck; DECK_META_NONE until set, and kept across renames */
+DeckMeta deck_store_get_meta(const DeckStore* store, size_t index);
+
+void deck_store_set_meta(DeckStore* store, size_t index, DeckMeta meta);
+
+/** Find or register a tag by name
+ *
+ * @return the tag id, or -1 if DECK_META_TAGS_MAX tags are registered already
+ */
+int deck_store_tag(DeckStore* store, const char* name, size_t length);
+
+size_t deck_store_tag_count(const DeckStore* store);
+
+const char* deck_store_tag_name(const DeckStore* store, size_t id);
+
+/** Remove a deck and compact the pool in place */
+void deck_store_remove(DeckStore* store, size_t index);
+
+/** Bytes of name data currently in the pool, terminators included */
+size_t deck_store_pool_used(const DeckStore* store);
+
+/** Total heap held by the store */
+size_t deck_store_memory_used(const DeckStore* store);
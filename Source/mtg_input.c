@@ -0,0 +1,120 @@
+#include "mtg_input.h"
+
+typedef struct {
+    InputKey key;
+    InputType type;
+    uint16_t repeats;
+} InputSlot;
+
+struct InputPipeline {
+    // Written under FURI_CRITICAL_ENTER only
+    InputSlot slots[INPUT_PIPELINE_SIZE];
+    size_t head;
+    size_t count;
+    bool wake_pending;
+    uint32_t dropped;
+
+    // Main loop only: the key held down and how many repeats it has had
+    InputKey held_key;
+    uint32_t held_repeats;
+};
+
+InputPipeline* input_pipeline_alloc(void) {
+    InputPipeline* pipeline = malloc(sizeof(InputPipeline));
+    memset(pipeline, 0, sizeof(InputPipeline));
+    pipeline->held_key = InputKeyMAX;
+    return pipeline;
+}
+
+void input_pipeline_free(InputPipeline* pipeline) {
+    furi_assert(pipeline);
+    free(pipeline);
+}
+
+bool input_pipeline_push(InputPipeline* pipeline, const InputEvent* event) {
+    furi_assert(pipeline);
+    furi_assert(event);
+
+    bool wake;
+    FURI_CRITICAL_ENTER();
+    InputSlot* last = NULL;
+    if (pipeline->count > 0) {
+        last = &pipeline->slots[(pipeline->head + pipeline->count - 1) % INPUT_PIPELINE_SIZE];
+    }
+    if (event->type == InputTypeRepeat && last && last->type == InputTypeRepeat && last->key == event->key &&
+       last->repeats < UINT16_MAX) {
+        last->repeats++;
+    } else if (pipeline->count < INPUT_PIPELINE_SIZE) {
+        InputSlot* slot = &pipeline->slots[(pipeline->head + pipeline->count) % INPUT_PIPELINE_SIZE];
+        slot->key = event->key;
+        slot->type = event->type;
+        slot->repeats = event->type == InputTypeRepeat ? 1 : 0;
+        pipeline->count++;
+    } else {
+        pipeline->dropped++;
+    }
+    wake = !pipeline->wake_pending;
+    pipeline->wake_pending = true;
+    FURI_CRITICAL_EXIT();
+    return wake;
+}
+
+void input_pipeline_wake_failed(InputPipeline* pipeline) {
+    furi_assert(pipeline);
+    FURI_CRITICAL_ENTER();
+    pipeline->wake_pending = false;
+    FURI_CRITICAL_EXIT();
+}
+
+bool input_pipeline_take(InputPipeline* pipeline, InputStep* step) {
+    furi_assert(pipeline);
+    furi_assert(step);
+
+    InputSlot slot;
+    bool taken = false;
+    FURI_CRITICAL_ENTER();
+    if (pipeline->count > 0) {
+        slot = pipeline->slots[pipeline->head];
+        pipeline->head = (pipeline->head + 1) % INPUT_PIPELINE_SIZE;
+        pipeline->count--;
+        taken = true;
+    } else {
+        // Drained: whatever comes next needs a new wake-up
+        pipeline->wake_pending = false;
+    }
+    FURI_CRITICAL_EXIT();
+    if (!taken) return false;
+
+    step->key = slot.key;
+    step->type = slot.type;
+    step->repeats = slot.repeats;
+    step->rows = 0;
+    step->pages = 0;
+
+    if (slot.type == InputTypePress || slot.type == InputTypeRelease) {
+        pipeline->held_key = slot.type == InputTypePress ? slot.key : InputKeyMAX;
+        pipeline->held_repeats = 0;
+    } else if (slot.type == InputTypeRepeat) {
+        if (slot.key != pipeline->held_key) {
+            pipeline->held_key = slot.key;
+            pipeline->held_repeats = 0;
+        }
+        // Each repeat counts at the rate for how long the key had been held by then
+        for (uint16_t i = 0; i < slot.repeats; i++) {
+            uint32_t n = ++pipeline->held_repeats;
+            if (n <= INPUT_ACCEL_ROWS) {
+                step->rows += 1;
+            } else if (n <= INPUT_ACCEL_ROWS + INPUT_ACCEL_JUMPS) {
+                step->rows += INPUT_ACCEL_JUMP;
+            } else {
+                step->pages += 1;
+            }
+        }
+    }
+    return true;
+}
+
+uint32_t input_pipeline_dropped(const InputPipeline* pipeline) {
+    furi_assert(pipeline);
+    return pipeline->dropped;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <furi.h>
+#include <input/input.h>
+
+/* Input between the system input thread and the app's main loop
+ *
+ * The input thread only ever appends to a small ring under a critical section
+ * a few instructions long, so a slow save or redraw can never hold it up. A
+ * repeat of the key whose repeat is still waiting at the end of the ring is
+ * merged into it instead of taking a slot, so however long a frame takes, a
+ * held key costs one entry and one step for the main loop to apply.
+ *
+ * One wake-up stands for everything queued until the main loop drains the
+ * ring; if it cannot be posted, the next event tries again.
+ *
+ * Steps come out in the order events went in, with the repeats merged into
+ * each turned into a distance: single rows at first, then jumps of
+ * INPUT_ACCEL_JUMP rows, then whole pages the longer the key stays down.
+ */
+
+#define INPUT_PIPELINE_SIZE 16
+// Repeats of a held key that move one row each
+#define INPUT_ACCEL_ROWS 6
+// Repeats after those that move INPUT_ACCEL_JUMP rows each; any later one is a page
+#define INPUT_ACCEL_JUMPS 10
+#define INPUT_ACCEL_JUMP  5
+
+typedef struct {
+    InputKey key;
+    InputType type;
+    // Repeats merged into this step, 0 unless type is InputTypeRepeat
+    uint16_t repeats;
+    // What they add up to under acceleration: rows plus pages of the caller's choosing
+    uint16_t rows;
+    uint16_t pages;
+} InputStep;
+
+typedef struct InputPipeline InputPipeline;
+
+InputPipeline* input_pipeline_alloc(void);
+
+void input_pipeline_free(InputPipeline* pipeline);
+
+/** Queue an event; safe from the input thread and never waits
+ *
+ * @return true if the main loop has to be woken for it
+ */
+bool input_pipeline_push(InputPipeline* pipeline, const InputEvent* event);
+
+/** The wake-up push asked for could not be delivered */
+void input_pipeline_wake_failed(InputPipeline* pipeline);
+
+/** Take the oldest step, on the main loop
+ *
+ * @return false once the ring is empty; the next push then wakes again
+ */
+bool input_pipeline_take(InputPipeline* pipeline, InputStep* step);
+
+/** Events lost to a full ring since allocation */
+uint32_t input_pipeline_dropped(const InputPipeline* pipeline);
+
+/** Row distance of a step, with pages page rows long */
+static inline int input_step_distance(const InputStep* step, int page) {
+    return step->rows + step->pages * page;
+}
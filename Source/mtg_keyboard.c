@@ -0,0 +1,123 @@
+#include "mtg_keyboard.h"
+
+static const KeyboardKey keyboard_lower_row_1[] = {
+    KEYBOARD_KEY('q', 0, 0, 1), KEYBOARD_KEY('w', 0, 1, 1), KEYBOARD_KEY('e', 0, 2, 1), KEYBOARD_KEY('r', 0, 3, 1),
+    KEYBOARD_KEY('t', 0, 4, 1), KEYBOARD_KEY('y', 0, 5, 1), KEYBOARD_KEY('u', 0, 6, 1), KEYBOARD_KEY('i', 0, 7, 1),
+    KEYBOARD_KEY('o', 0, 8, 1), KEYBOARD_KEY('p', 0, 9, 1), KEYBOARD_KEY('\'', 0, 10, 1), KEYBOARD_KEY(',', 0, 11, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_BACKSPACE, 0, 12, 2),
+};
+
+static const KeyboardKey keyboard_lower_row_2[] = {
+    KEYBOARD_KEY('a', 1, 0, 1), KEYBOARD_KEY('s', 1, 1, 1), KEYBOARD_KEY('d', 1, 2, 1), KEYBOARD_KEY('f', 1, 3, 1),
+    KEYBOARD_KEY('g', 1, 4, 1), KEYBOARD_KEY('h', 1, 5, 1), KEYBOARD_KEY('j', 1, 6, 1), KEYBOARD_KEY('k', 1, 7, 1),
+    KEYBOARD_KEY('l', 1, 8, 1), KEYBOARD_KEY('-', 1, 9, 1), KEYBOARD_KEY('.', 1, 10, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_LAYOUT, 1, 11, 2),
+};
+
+static const KeyboardKey keyboard_lower_row_3[] = {
+    KEYBOARD_KEY('z', 2, 0, 1), KEYBOARD_KEY('x', 2, 1, 1), KEYBOARD_KEY('c', 2, 2, 1), KEYBOARD_KEY('v', 2, 3, 1),
+    KEYBOARD_KEY('b', 2, 4, 1), KEYBOARD_KEY('n', 2, 5, 1), KEYBOARD_KEY('m', 2, 6, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_SPACE, 2, 7, 2),
+    KEYBOARD_KEY(KEYBOARD_KEY_ENTER, 2, 9, 3),
+};
+
+static const KeyboardKey keyboard_upper_row_1[] = {
+    KEYBOARD_KEY('Q', 0, 0, 1), KEYBOARD_KEY('W', 0, 1, 1), KEYBOARD_KEY('E', 0, 2, 1), KEYBOARD_KEY('R', 0, 3, 1),
+    KEYBOARD_KEY('T', 0, 4, 1), KEYBOARD_KEY('Y', 0, 5, 1), KEYBOARD_KEY('U', 0, 6, 1), KEYBOARD_KEY('I', 0, 7, 1),
+    KEYBOARD_KEY('O', 0, 8, 1), KEYBOARD_KEY('P', 0, 9, 1), KEYBOARD_KEY('\'', 0, 10, 1), KEYBOARD_KEY(',', 0, 11, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_BACKSPACE, 0, 12, 2),
+};
+
+static const KeyboardKey keyboard_upper_row_2[] = {
+    KEYBOARD_KEY('A', 1, 0, 1), KEYBOARD_KEY('S', 1, 1, 1), KEYBOARD_KEY('D', 1, 2, 1), KEYBOARD_KEY('F', 1, 3, 1),
+    KEYBOARD_KEY('G', 1, 4, 1), KEYBOARD_KEY('H', 1, 5, 1), KEYBOARD_KEY('J', 1, 6, 1), KEYBOARD_KEY('K', 1, 7, 1),
+    KEYBOARD_KEY('L', 1, 8, 1), KEYBOARD_KEY('-', 1, 9, 1), KEYBOARD_KEY('.', 1, 10, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_LAYOUT, 1, 11, 2),
+};
+
+static const KeyboardKey keyboard_upper_row_3[] = {
+    KEYBOARD_KEY('Z', 2, 0, 1), KEYBOARD_KEY('X', 2, 1, 1), KEYBOARD_KEY('C', 2, 2, 1), KEYBOARD_KEY('V', 2, 3, 1),
+    KEYBOARD_KEY('B', 2, 4, 1), KEYBOARD_KEY('N', 2, 5, 1), KEYBOARD_KEY('M', 2, 6, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_SPACE, 2, 7, 2),
+    KEYBOARD_KEY(KEYBOARD_KEY_ENTER, 2, 9, 3),
+};
+
+static const KeyboardKey keyboard_symbols_row_1[] = {
+    KEYBOARD_KEY('1', 0, 0, 1), KEYBOARD_KEY('2', 0, 1, 1), KEYBOARD_KEY('3', 0, 2, 1), KEYBOARD_KEY('4', 0, 3, 1),
+    KEYBOARD_KEY('5', 0, 4, 1), KEYBOARD_KEY('6', 0, 5, 1), KEYBOARD_KEY('7', 0, 6, 1), KEYBOARD_KEY('8', 0, 7, 1),
+    KEYBOARD_KEY('9', 0, 8, 1), KEYBOARD_KEY('0', 0, 9, 1), KEYBOARD_KEY('\'', 0, 10, 1), KEYBOARD_KEY(',', 0, 11, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_BACKSPACE, 0, 12, 2),
+};
+
+static const KeyboardKey keyboard_symbols_row_2[] = {
+    KEYBOARD_KEY('!', 1, 0, 1), KEYBOARD_KEY('?', 1, 1, 1), KEYBOARD_KEY('&', 1, 2, 1), KEYBOARD_KEY('+', 1, 3, 1),
+    KEYBOARD_KEY('-', 1, 4, 1), KEYBOARD_KEY('_', 1, 5, 1), KEYBOARD_KEY('.', 1, 6, 1), KEYBOARD_KEY(':', 1, 7, 1),
+    KEYBOARD_KEY('/', 1, 8, 1), KEYBOARD_KEY('(', 1, 9, 1), KEYBOARD_KEY(')', 1, 10, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_LAYOUT, 1, 11, 2),
+};
+
+static const KeyboardKey keyboard_symbols_row_3[] = {
+    KEYBOARD_KEY('#', 2, 0, 1), KEYBOARD_KEY('@', 2, 1, 1), KEYBOARD_KEY('"', 2, 2, 1), KEYBOARD_KEY('*', 2, 3, 1),
+    KEYBOARD_KEY('%', 2, 4, 1), KEYBOARD_KEY('=', 2, 5, 1), KEYBOARD_KEY(';', 2, 6, 1),
+    KEYBOARD_KEY(KEYBOARD_KEY_SPACE, 2, 7, 2),
+    KEYBOARD_KEY(KEYBOARD_KEY_ENTER, 2, 9, 3),
+};
+
+// The cursor keeps its row and column across a layout change
+_Static_assert(
+    COUNT_OF(keyboard_lower_row_1) == COUNT_OF(keyboard_upper_row_1) &&
+        COUNT_OF(keyboard_lower_row_1) == COUNT_OF(keyboard_symbols_row_1) &&
+        COUNT_OF(keyboard_lower_row_2) == COUNT_OF(keyboard_upper_row_2) &&
+        COUNT_OF(keyboard_lower_row_2) == COUNT_OF(keyboard_symbols_row_2) &&
+        COUNT_OF(keyboard_lower_row_3) == COUNT_OF(keyboard_upper_row_3) &&
+        COUNT_OF(keyboard_lower_row_3) == COUNT_OF(keyboard_symbols_row_3),
+    "keyboard layouts must have the same shape");
+
+#define KEYBOARD_ROW(keys) {(keys), COUNT_OF(keys)}
+
+static const KeyboardRow keyboard_layouts[KeyboardLayoutCount][KEYBOARD_ROWS] = {
+    [KeyboardLayoutLower] =
+        {KEYBOARD_ROW(keyboard_lower_row_1),
+         KEYBOARD_ROW(keyboard_lower_row_2),
+         KEYBOARD_ROW(keyboard_lower_row_3)},
+    [KeyboardLayoutUpper] =
+        {KEYBOARD_ROW(keyboard_upper_row_1),
+         KEYBOARD_ROW(keyboard_upper_row_2),
+         KEYBOARD_ROW(keyboard_upper_row_3)},
+    [KeyboardLayoutSymbols] =
+        {KEYBOARD_ROW(keyboard_symbols_row_1),
+         KEYBOARD_ROW(keyboard_symbols_row_2),
+         KEYBOARD_ROW(keyboard_symbols_row_3)},
+};
+
+static const char* const keyboard_layout_labels[KeyboardLayoutCount] = {
+    [KeyboardLayoutLower] = "AB",
+    [KeyboardLayoutUpper] = "#1",
+    [KeyboardLayoutSymbols] = "ab",
+};
+
+const KeyboardRow* keyboard_row(KeyboardLayout layout, uint8_t row) {
+    furi_assert(layout < KeyboardLayoutCount);
+    furi_assert(row < KEYBOARD_ROWS);
+    return &keyboard_layouts[layout][row];
+}
+
+uint8_t keyboard_column_at(KeyboardLayout layout, uint8_t row, uint8_t x) {
+    const KeyboardRow* keys = keyboard_row(layout, row);
+    // Keys run left to right, so the first that ends past x is under it or
+    // just to its right
+    for (uint8_t column = 0; column < keys->count; column++) {
+        if (x < keys->keys[column].x + keys->keys[column].width) return column;
+    }
+    return keys->count - 1;
+}
+
+KeyboardLayout keyboard_layout_next(KeyboardLayout layout) {
+    furi_assert(layout < KeyboardLayoutCount);
+    return (layout + 1) % KeyboardLayoutCount;
+}
+
+const char* keyboard_layout_label(KeyboardLayout layout) {
+    furi_assert(layout < KeyboardLayoutCount);
+    return keyboard_layout_labels[layout];
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <furi.h>
+
+/* On-screen keyboard layouts
+ *
+ *   lowercase  q..p ' ,      a..l - .      z..m
+ *   uppercase  the same letters in capitals
+ *   symbols    1..9 0 ' ,    ! ? & + - _ . : / ( )    # @ " * % = ;
+ *
+ * Every layout has the same shape, with backspace ending the first row, the
+ * layout key ending the second and space and Enter ending the third, so the
+ * cursor stays on the same key across a layout change.
+ *
+ * Keys sit on a grid of KEYBOARD_CELL_WIDTH px cells, the special keys
+ * spanning several. KEYBOARD_KEY works out each key's hit rectangle from its
+ * row and cells at compile time, so the tables are const data in flash and
+ * neither drawing nor moving the cursor does any layout arithmetic.
+ */
+
+#define KEYBOARD_ROWS        3
+#define KEYBOARD_CELL_WIDTH  9
+#define KEYBOARD_ROW_HEIGHT  12
+#define KEYBOARD_KEY_HEIGHT  11
+#define KEYBOARD_ORIGIN_X    1
+#define KEYBOARD_ORIGIN_Y    29
+// Glyphs and labels are drawn this far into their key's rectangle
+#define KEYBOARD_TEXT_X      1
+#define KEYBOARD_TEXT_Y      8
+
+// Special keys are control codes no deck name contains
+#define KEYBOARD_KEY_ENTER     '\r'
+#define KEYBOARD_KEY_BACKSPACE '\b'
+#define KEYBOARD_KEY_LAYOUT    '\t'
+#define KEYBOARD_KEY_SPACE     ' '
+
+typedef enum {
+    KeyboardLayoutLower,
+    KeyboardLayoutUpper,
+    KeyboardLayoutSymbols,
+    KeyboardLayoutCount
+} KeyboardLayout;
+
+typedef struct {
+    char text;
+    // Hit rectangle in screen pixels
+    uint8_t x;
+    uint8_t y;
+    uint8_t width;
+    uint8_t height;
+} KeyboardKey;
+
+typedef struct {
+    const KeyboardKey* keys;
+    uint8_t count;
+} KeyboardRow;
+
+/** The key spanning cells first cell on from the left of row */
+#define KEYBOARD_KEY(character, row, cell, cells)                   \
+    {.text = (character),                                           \
+     .x = KEYBOARD_ORIGIN_X + (cell) * KEYBOARD_CELL_WIDTH,         \
+     .y = KEYBOARD_ORIGIN_Y + (row) * KEYBOARD_ROW_HEIGHT,          \
+     .width = (cells) * KEYBOARD_CELL_WIDTH - 2,                    \
+     .height = KEYBOARD_KEY_HEIGHT}
+
+const KeyboardRow* keyboard_row(KeyboardLayout layout, uint8_t row);
+
+/** A key drawn with a label in FontSecondary rather than a glyph */
+static inline bool keyboard_key_is_special(const KeyboardKey* key) {
+    return key->text == KEYBOARD_KEY_ENTER || key->text == KEYBOARD_KEY_BACKSPACE ||
+           key->text == KEYBOARD_KEY_LAYOUT || key->text == KEYBOARD_KEY_SPACE;
+}
+
+/** Column of the key in row under x, or the nearest one if none is */
+uint8_t keyboard_column_at(KeyboardLayout layout, uint8_t row, uint8_t x);
+
+KeyboardLayout keyboard_layout_next(KeyboardLayout layout);
+
+/** Label for the layout key while layout is showing: the layout it leads to */
+const char* keyboard_layout_label(KeyboardLayout layout);
@@ -0,0 +1,122 @@
+#include "mtg_line_reader.h"
+#include "mtg_storage_helpers.h"
+
+struct LineReader {
+    File* file;
+    char* buffer;
+    size_t block_size;
+    size_t start;
+    size_t end;
+    bool eof;
+    bool skipping;
+    LineReaderStats stats;
+};
+
+LineReader* line_reader_alloc(File* file, size_t block_size) {
+    furi_assert(file);
+    furi_assert(block_size > 1);
+
+    LineReader* reader = malloc(sizeof(LineReader));
+    reader->file = file;
+    // One spare byte so the last line can always be terminated in place
+    reader->buffer = malloc(block_size + 1);
+    reader->block_size = block_size;
+    reader->start = 0;
+    reader->end = 0;
+    reader->eof = false;
+    reader->skipping = false;
+    memset(&reader->stats, 0, sizeof(reader->stats));
+    return reader;
+}
+
+void line_reader_free(LineReader* reader) {
+    furi_assert(reader);
+    free(reader->buffer);
+    free(reader);
+}
+
+static bool line_reader_fill(LineReader* reader) {
+    if (reader->eof) return false;
+
+    // Keep the partial line at the front, then top the block up
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+
+    size_t bytes_read =
+        mtg_file_read(reader->file, reader->buffer + reader->end, reader->block_size - reader->end);
+    if (bytes_read == 0) {
+        reader->eof = true;
+        return false;
+    }
+
+    reader->stats.blocks++;
+    reader->stats.bytes += bytes_read;
+    reader->end += bytes_read;
+    return true;
+}
+
+static void line_reader_emit(
+    LineReader* reader,
+    char* begin,
+    size_t size,
+    const char** line,
+    size_t* length) {
+    if (size > 0 && begin[size - 1] == '\r') size--;
+    begin[size] = '\0';
+    reader->stats.lines++;
+    *line = begin;
+    *length = size;
+}
+
+bool line_reader_next(LineReader* reader, const char** line, size_t* length) {
+    furi_assert(reader);
+
+    for (;;) {
+        char* begin = reader->buffer + reader->start;
+        size_t available = reader->end - reader->start;
+        char* newline = memchr(begin, '\n', available);
+
+        if (newline) {
+            size_t size = newline - begin;
+            reader->start += size + 1;
+            if (reader->skipping) {
+                // Tail of an overlong line that was already returned
+                reader->skipping = false;
+                continue;
+            }
+            line_reader_emit(reader, begin, size, line, length);
+            return true;
+        }
+
+        if (reader->skipping) {
+            reader->start = reader->end;
+        } else if (available == reader->block_size) {
+            // No newline in a full block: return what fits and drop the rest
+            reader->stats.overlong_lines++;
+            reader->skipping = true;
+            reader->start = reader->end;
+            line_reader_emit(reader, begin, reader->block_size - 1, line, length);
+            return true;
+        }
+
+        if (!line_reader_fill(reader)) {
+            // Last line without a trailing newline
+            if (reader->start < reader->end && !reader->skipping) {
+                begin = reader->buffer + reader->start;
+                available = reader->end - reader->start;
+                reader->start = reader->end;
+                line_reader_emit(reader, begin, available, line, length);
+                return true;
+            }
+            return false;
+        }
+    }
+}
+
+const LineReaderStats* line_reader_get_stats(const LineReader* reader) {
+    furi_assert(reader);
+    return &reader->stats;
+}
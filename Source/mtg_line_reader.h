@@ -0,0 +1,35 @@
+#pragma once
+
+#include <furi.h>
+#include <storage/storage.h>
+
+// Default block size for deck list reads; one SD round-trip per block
+#define LINE_READER_DEFAULT_BLOCK_SIZE 1024
+
+typedef struct {
+    uint32_t lines;
+    uint32_t bytes;
+    uint32_t blocks;
+    uint32_t overlong_lines;
+} LineReaderStats;
+
+typedef struct LineReader LineReader;
+
+/** Allocate a block-buffered line reader over an already opened file
+ *
+ * Lines longer than the block size are truncated to block_size - 1 bytes and
+ * the remainder is skipped. CRLF and a missing trailing newline are handled.
+ */
+LineReader* line_reader_alloc(File* file, size_t block_size);
+
+void line_reader_free(LineReader* reader);
+
+/** Fetch the next line
+ *
+ * @param line   set to a NUL-terminated line, valid until the next call
+ * @param length set to the line length without terminator
+ * @return false at end of file
+ */
+bool line_reader_next(LineReader* reader, const char** line, size_t* length);
+
+const LineReaderStats* line_reader_get_stats(const LineReader* reader);
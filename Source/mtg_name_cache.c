@@ -0,0 +1,102 @@
+#include "mtg_name_cache.h"
+
+#define NAME_CACHE_EMPTY UINT32_MAX
+
+typedef struct {
+    uint32_t index;
+    uint32_t last_used;
+} NameCacheSlot;
+
+struct NameCache {
+    NameCacheSlot* slots;
+    char* names;
+    size_t slot_count;
+    size_t name_size;
+    uint32_t clock;
+    NameCacheFetch fetch;
+    void* context;
+    NameCacheStats stats;
+};
+
+NameCache* name_cache_alloc(size_t slots, size_t name_size, NameCacheFetch fetch, void* context) {
+    furi_assert(slots > 0);
+    furi_assert(name_size > 0);
+    furi_assert(fetch);
+
+    NameCache* cache = malloc(sizeof(NameCache));
+    cache->slots = malloc(slots * sizeof(NameCacheSlot));
+    cache->names = malloc(slots * name_size);
+    cache->slot_count = slots;
+    cache->name_size = name_size;
+    cache->fetch = fetch;
+    cache->context = context;
+    name_cache_reset(cache);
+    return cache;
+}
+
+void name_cache_free(NameCache* cache) {
+    furi_assert(cache);
+    free(cache->slots);
+    free(cache->names);
+    free(cache);
+}
+
+void name_cache_reset(NameCache* cache) {
+    furi_assert(cache);
+    for (size_t i = 0; i < cache->slot_count; i++) {
+        cache->slots[i].index = NAME_CACHE_EMPTY;
+        cache->slots[i].last_used = 0;
+    }
+    cache->clock = 0;
+    memset(&cache->stats, 0, sizeof(cache->stats));
+}
+
+// A linear scan is cheaper than any index structure at a few dozen slots
+static size_t name_cache_lookup(NameCache* cache, uint32_t index, bool* hit) {
+    size_t victim = 0;
+    for (size_t i = 0; i < cache->slot_count; i++) {
+        if (cache->slots[i].index == index) {
+            *hit = true;
+            return i;
+        }
+        if (cache->slots[i].last_used < cache->slots[victim].last_used) victim = i;
+    }
+    *hit = false;
+    return victim;
+}
+
+static char* name_cache_load(NameCache* cache, uint32_t index) {
+    bool hit;
+    size_t slot = name_cache_lookup(cache, index, &hit);
+    char* name = cache->names + slot * cache->name_size;
+
+    if (hit) {
+        cache->stats.hits++;
+    } else {
+        cache->stats.misses++;
+        if (!cache->fetch(cache->context, index, name, cache->name_size)) {
+            name[0] = '\0';
+        }
+        cache->slots[slot].index = index;
+    }
+    cache->slots[slot].last_used = ++cache->clock;
+    return name;
+}
+
+const char* name_cache_get(NameCache* cache, uint32_t index) {
+    furi_assert(cache);
+    return name_cache_load(cache, index);
+}
+
+void name_cache_prefetch(NameCache* cache, uint32_t first, uint32_t count) {
+    furi_assert(cache);
+    furi_assert(count <= cache->slot_count);
+    for (uint32_t i = 0; i < count; i++) {
+        name_cache_load(cache, first + i);
+    }
+}
+
+const NameCacheStats* name_cache_get_stats(const NameCache* cache) {
+    furi_assert(cache);
+    return &cache->stats;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <furi.h>
+
+/** Fetch one name from backing storage into name, NUL-terminated within size */
+typedef bool (*NameCacheFetch)(void* context, uint32_t index, char* name, size_t size);
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+} NameCacheStats;
+
+typedef struct NameCache NameCache;
+
+/** Allocate a fixed-size LRU cache of deck names
+ *
+ * Memory is allocated once up front and never grows with the list size.
+ */
+NameCache* name_cache_alloc(size_t slots, size_t name_size, NameCacheFetch fetch, void* context);
+
+void name_cache_free(NameCache* cache);
+
+/** Forget every cached name, e.g. after the backing list changed */
+void name_cache_reset(NameCache* cache);
+
+/** Get a name, fetching it on a miss. Valid until the next cache call. */
+const char* name_cache_get(NameCache* cache, uint32_t index);
+
+/** Make sure names [first, first + count) are cached */
+void name_cache_prefetch(NameCache* cache, uint32_t first, uint32_t count);
+
+const NameCacheStats* name_cache_get_stats(const NameCache* cache);
@@ -0,0 +1,172 @@
+#include "mtg_perf.h"
+#include "mtg_storage_helpers.h"
+
+#include <furi_hal.h>
+#include <stdio.h>
+
+#define PERF_DUMP_BLOCK_SIZE 512
+
+typedef struct {
+    PerfSample ring[PERF_RING_SIZE];
+    // Samples ever recorded; the newest is at (written - 1) % PERF_RING_SIZE
+    uint32_t written;
+    PerfIo io;
+    uint32_t stack_space[PerfThreadCount];
+} PerfState;
+
+static PerfState perf;
+
+static const char* const perf_scope_names[PerfScopeCount] = {
+    [PerfScopeDraw] = "draw",
+    [PerfScopeEvent] = "event",
+    [PerfScopeLoad] = "load",
+    [PerfScopeSave] = "save",
+};
+
+PerfTimer perf_timer_begin(PerfScope scope) {
+    furi_assert(scope < PerfScopeCount);
+    PerfTimer timer = {.scope = scope};
+    FURI_CRITICAL_ENTER();
+    timer.io = perf.io;
+    FURI_CRITICAL_EXIT();
+    timer.cycles = DWT->CYCCNT;
+    return timer;
+}
+
+void perf_timer_end(PerfTimer* timer) {
+    furi_assert(timer);
+    uint32_t cycles = DWT->CYCCNT - timer->cycles;
+
+    PerfSample sample = {
+        .tick = furi_get_tick(),
+        .micros = cycles / furi_hal_cortex_instructions_per_microsecond(),
+        .scope = timer->scope,
+    };
+    FURI_CRITICAL_ENTER();
+    sample.reads = MIN(perf.io.reads - timer->io.reads, (uint32_t)UINT16_MAX);
+    sample.writes = MIN(perf.io.writes - timer->io.writes, (uint32_t)UINT16_MAX);
+    sample.read_bytes = perf.io.read_bytes - timer->io.read_bytes;
+    sample.write_bytes = perf.io.write_bytes - timer->io.write_bytes;
+    perf.ring[perf.written % PERF_RING_SIZE] = sample;
+    perf.written++;
+    FURI_CRITICAL_EXIT();
+}
+
+void perf_count_read(size_t bytes) {
+    FURI_CRITICAL_ENTER();
+    perf.io.reads++;
+    perf.io.read_bytes += bytes;
+    FURI_CRITICAL_EXIT();
+}
+
+void perf_count_write(size_t bytes) {
+    FURI_CRITICAL_ENTER();
+    perf.io.writes++;
+    perf.io.write_bytes += bytes;
+    FURI_CRITICAL_EXIT();
+}
+
+PerfIo perf_io_totals(void) {
+    FURI_CRITICAL_ENTER();
+    PerfIo io = perf.io;
+    FURI_CRITICAL_EXIT();
+    return io;
+}
+
+void perf_note_stack(PerfThread thread) {
+    furi_assert(thread < PerfThreadCount);
+    // FreeRTOS keeps the high-water mark itself; this only makes it visible
+    // from other threads
+    perf.stack_space[thread] = furi_thread_get_stack_space(furi_thread_get_current_id());
+}
+
+uint32_t perf_stack_space(PerfThread thread) {
+    furi_assert(thread < PerfThreadCount);
+    return perf.stack_space[thread];
+}
+
+void perf_summary(PerfScope scope, PerfSummary* summary) {
+    furi_assert(scope < PerfScopeCount);
+    furi_assert(summary);
+
+    uint32_t micros[PERF_RING_SIZE];
+    size_t count = 0;
+    FURI_CRITICAL_ENTER();
+    size_t filled = MIN(perf.written, (uint32_t)PERF_RING_SIZE);
+    for (size_t i = 0; i < filled; i++) {
+        if (perf.ring[i].scope == scope) micros[count++] = perf.ring[i].micros;
+    }
+    FURI_CRITICAL_EXIT();
+
+    // Insertion sort; the ring is small and mostly one scope
+    for (size_t i = 1; i < count; i++) {
+        uint32_t value = micros[i];
+        size_t j = i;
+        for (; j > 0 && micros[j - 1] > value; j--) {
+            micros[j] = micros[j - 1];
+        }
+        micros[j] = value;
+    }
+    summary->count = count;
+    summary->p50_micros = count ? micros[count / 2] : 0;
+    summary->max_micros = count ? micros[count - 1] : 0;
+}
+
+const char* perf_scope_name(PerfScope scope) {
+    furi_assert(scope < PerfScopeCount);
+    return perf_scope_names[scope];
+}
+
+bool perf_dump(const char* path) {
+    furi_assert(path);
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool success = false;
+    if (storage_file_open(file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        BlockWriter* writer = block_writer_alloc(file, PERF_DUMP_BLOCK_SIZE);
+        char line[96];
+        int length = snprintf(
+            line, sizeof(line), "scope,tick,micros,reads,read_bytes,writes,write_bytes\n");
+        block_writer_put(writer, line, length);
+
+        // One sample at a time, so the dump never holds up other threads for long
+        FURI_CRITICAL_ENTER();
+        uint32_t end = perf.written;
+        FURI_CRITICAL_EXIT();
+        uint32_t start = end > PERF_RING_SIZE ? end - PERF_RING_SIZE : 0;
+        for (uint32_t n = start; n < end; n++) {
+            FURI_CRITICAL_ENTER();
+            PerfSample sample = perf.ring[n % PERF_RING_SIZE];
+            bool overwritten = perf.written - n > PERF_RING_SIZE;
+            FURI_CRITICAL_EXIT();
+            if (overwritten) continue;
+            length = snprintf(
+                line,
+                sizeof(line),
+                "%s,%lu,%lu,%u,%lu,%u,%lu\n",
+                perf_scope_name(sample.scope),
+                (unsigned long)sample.tick,
+                (unsigned long)sample.micros,
+                sample.reads,
+                (unsigned long)sample.read_bytes,
+                sample.writes,
+                (unsigned long)sample.write_bytes);
+            block_writer_put(writer, line, length);
+        }
+        success = block_writer_flush(writer);
+        block_writer_free(writer);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    if (!success) FURI_LOG_E("MTG", "Failed to write %s", path);
+    return success;
+}
+
+void perf_reset(void) {
+    FURI_CRITICAL_ENTER();
+    memset(&perf, 0, sizeof(perf));
+    FURI_CRITICAL_EXIT();
+}
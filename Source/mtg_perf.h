@@ -0,0 +1,100 @@
+#pragma once
+
+#include <furi.h>
+
+/* Lightweight instrumentation for the diagnostics overlay
+ *
+ * Scoped timers read the Cortex cycle counter, so they cost two register
+ * reads and a ring write. Each finished scope leaves a PerfSample in a fixed
+ * ring of the latest PERF_RING_SIZE, with the storage reads and writes made
+ * while it ran; those counters are process-wide, so a scope on the UI thread
+ * also counts whatever the storage worker did meanwhile.
+ *
+ * Storage I/O is counted by mtg_file_read and mtg_file_write. Stack
+ * watermarks are noted by each thread for itself, since FreeRTOS only
+ * reports them per task; heap figures are read when asked for.
+ *
+ * Everything is static and guarded by FURI_CRITICAL_ENTER, so any thread may
+ * record at any time and nothing here allocates.
+ */
+
+#define PERF_RING_SIZE 64
+
+typedef enum {
+    // One pass of the draw callback
+    PerfScopeDraw,
+    // One main loop event, input batches included
+    PerfScopeEvent,
+    PerfScopeLoad,
+    PerfScopeSave,
+    PerfScopeCount
+} PerfScope;
+
+typedef enum {
+    PerfThreadMain,
+    PerfThreadWorker,
+    PerfThreadCount
+} PerfThread;
+
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t read_bytes;
+    uint32_t write_bytes;
+} PerfIo;
+
+typedef struct {
+    uint32_t tick;
+    uint32_t micros;
+    uint32_t read_bytes;
+    uint32_t write_bytes;
+    uint16_t reads;
+    uint16_t writes;
+    uint8_t scope;
+    uint8_t reserved[3];
+} PerfSample;
+
+typedef struct {
+    uint32_t cycles;
+    PerfIo io;
+    PerfScope scope;
+} PerfTimer;
+
+typedef struct {
+    // Samples of the scope still in the ring
+    uint16_t count;
+    uint32_t p50_micros;
+    uint32_t max_micros;
+} PerfSummary;
+
+PerfTimer perf_timer_begin(PerfScope scope);
+
+/** Record the scope begun with perf_timer_begin */
+void perf_timer_end(PerfTimer* timer);
+
+/** Time the rest of the enclosing block */
+#define PERF_SCOPE(scope) \
+    PerfTimer perf_scope_timer __attribute__((cleanup(perf_timer_end))) = perf_timer_begin(scope)
+
+void perf_count_read(size_t bytes);
+
+void perf_count_write(size_t bytes);
+
+/** Storage traffic since start or the last perf_reset */
+PerfIo perf_io_totals(void);
+
+/** Note the calling thread's stack watermark as that of thread */
+void perf_note_stack(PerfThread thread);
+
+/** Least free stack thread has had, in bytes; 0 until noted */
+uint32_t perf_stack_space(PerfThread thread);
+
+/** Median and worst time of the scope's samples in the ring */
+void perf_summary(PerfScope scope, PerfSummary* summary);
+
+const char* perf_scope_name(PerfScope scope);
+
+/** Write the ring, oldest sample first, as CSV */
+bool perf_dump(const char* path);
+
+void perf_reset(void);
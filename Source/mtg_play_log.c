@@ -0,0 +1,507 @@
+#include "mtg_play_log.h"
+#include "mtg_storage_helpers.h"
+
+#include <storage/storage.h>
+
+/* History file (mtg_history.bin)
+ *
+ *   header   PlayHistoryHeader
+ *   ring     capacity PlayRecords, record n in slot n % capacity
+ *
+ * Sequence numbers start at 1, so a zeroed slot has never been written.
+ *
+ * Stats file (mtg_stats.bin)
+ *
+ *   header   PlayStatsHeader
+ *   table    capacity PlayStats slots, linear probing from deck % capacity;
+ *            deck 0 marks an empty slot
+ */
+
+#define PLAY_HISTORY_MAGIC 0x4850474D // "MGPH"
+#define PLAY_STATS_MAGIC   0x5350474D // "MGPS"
+#define PLAY_LOG_VERSION   1
+
+#define PLAY_STATS_MIN_CAPACITY 64
+// The table doubles before it is more than three quarters full
+#define PLAY_STATS_LOAD_NUM 3
+#define PLAY_STATS_LOAD_DEN 4
+#define PLAY_LOG_BLOCK_SIZE 512
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t capacity;
+    uint32_t reserved;
+} PlayHistoryHeader;
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t deck;
+    uint32_t timestamp;
+    uint8_t result;
+    uint8_t reserved[3];
+} PlayRecord;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t capacity;
+    uint32_t last_sequence;
+    PlayTotals totals;
+} PlayStatsHeader;
+
+struct PlayLog {
+    Storage* storage;
+    FuriString* history_path;
+    FuriString* stats_path;
+    FuriString* stats_tmp_path;
+    uint32_t history_capacity;
+    uint32_t history_header_size;
+    uint32_t next_sequence;
+    // magic is 0 until the stats file exists
+    PlayStatsHeader stats;
+};
+
+uint32_t play_log_deck_id(const char* name, size_t length) {
+    uint32_t id = mtg_checksum(MTG_CHECKSUM_SEED, name, length);
+    return id ? id : 1;
+}
+
+static bool play_log_write_zeros(File* file, size_t size) {
+    uint8_t zeros[64] = {0};
+    while (size > 0) {
+        size_t chunk = MIN(size, sizeof(zeros));
+        if (mtg_file_write(file, zeros, chunk) != chunk) return false;
+        size -= chunk;
+    }
+    return true;
+}
+
+// Find the newest record in the ring, or remove a ring that can't be read
+static uint32_t play_log_scan_history(PlayLog* log) {
+    const char* path = furi_string_get_cstr(log->history_path);
+    File* file = storage_file_alloc(log->storage);
+    PlayHistoryHeader header;
+    uint32_t newest = 0;
+    bool valid = false;
+
+    if (storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+       mtg_file_read(file, &header, sizeof(header)) == sizeof(header) &&
+       header.magic == PLAY_HISTORY_MAGIC && header.version == PLAY_LOG_VERSION &&
+       header.header_size >= sizeof(header) && header.capacity > 0 &&
+       storage_file_seek(file, header.header_size, true)) {
+        PlayRecord records[PLAY_LOG_BLOCK_SIZE / sizeof(PlayRecord)];
+        size_t remaining = header.capacity;
+        valid = true;
+        while (remaining > 0) {
+            size_t count = MIN(remaining, COUNT_OF(records));
+            size_t bytes = count * sizeof(PlayRecord);
+            if (mtg_file_read(file, records, bytes) != bytes) {
+                valid = false;
+                break;
+            }
+            for (size_t i = 0; i < count; i++) {
+                newest = MAX(newest, records[i].sequence);
+            }
+            remaining -= count;
+        }
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if (valid) {
+        log->history_capacity = header.capacity;
+        log->history_header_size = header.header_size;
+    } else {
+        storage_common_remove(log->storage, path);
+        newest = 0;
+    }
+    return newest;
+}
+
+static bool play_log_read_record(File* history, const PlayLog* log, uint32_t sequence, PlayRecord* record) {
+    uint64_t offset = log->history_header_size +
+                      (uint64_t)(sequence % log->history_capacity) * sizeof(PlayRecord);
+    return storage_file_seek(history, offset, true) &&
+           mtg_file_read(history, record, sizeof(PlayRecord)) == sizeof(PlayRecord) &&
+           record->sequence == sequence;
+}
+
+static uint64_t play_stats_offset(const PlayLog* log, uint32_t slot) {
+    return log->stats.header_size + (uint64_t)slot * sizeof(PlayStats);
+}
+
+// Probe for deck; on a miss, slot is where it would be inserted
+static bool play_stats_find(PlayLog* log, File* file, uint32_t deck, PlayStats* stats, uint32_t* slot) {
+    uint32_t mask = log->stats.capacity - 1;
+    uint32_t index = deck & mask;
+    for (uint32_t probe = 0; probe < log->stats.capacity; probe++) {
+        if (!storage_file_seek(file, play_stats_offset(log, index), true) ||
+           mtg_file_read(file, stats, sizeof(PlayStats)) != sizeof(PlayStats)) {
+            break;
+        }
+        if (stats->deck == deck || stats->deck == 0) {
+            *slot = index;
+            return stats->deck == deck;
+        }
+        index = (index + 1) & mask;
+    }
+    *slot = UINT32_MAX;
+    return false;
+}
+
+static void play_stats_add(PlayStats* stats, PlayTotals* totals, const PlayRecord* record) {
+    switch (record->result) {
+        case PlayResultPicked:
+            if (stats->plays < UINT16_MAX) stats->plays++;
+            stats->last_played = MAX(stats->last_played, record->timestamp);
+            totals->games++;
+            break;
+        case PlayResultWon:
+            if (stats->wins < UINT16_MAX) stats->wins++;
+            totals->wins++;
+            break;
+        case PlayResultLost:
+            if (stats->losses < UINT16_MAX) stats->losses++;
+            totals->losses++;
+            break;
+        default:
+            break;
+    }
+}
+
+static bool play_stats_write_header(PlayLog* log, File* file) {
+    return storage_file_seek(file, 0, true) &&
+           mtg_file_write(file, &log->stats, sizeof(PlayStatsHeader)) == sizeof(PlayStatsHeader);
+}
+
+// Lay out an empty table of the given capacity in the temporary file
+static bool play_stats_write_empty(PlayLog* log, const PlayStatsHeader* header) {
+    File* file = storage_file_alloc(log->storage);
+    bool success =
+        storage_file_open(file, furi_string_get_cstr(log->stats_tmp_path), FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+        mtg_file_write(file, header, sizeof(PlayStatsHeader)) == sizeof(PlayStatsHeader) &&
+        play_log_write_zeros(file, header->capacity * sizeof(PlayStats));
+    storage_file_close(file);
+    storage_file_free(file);
+    return success;
+}
+
+// Move the temporary file over the table, so a failure leaves the old one in place
+static bool play_stats_commit(PlayLog* log, const PlayStatsHeader* header, bool success) {
+    const char* tmp_path = furi_string_get_cstr(log->stats_tmp_path);
+    const char* path = furi_string_get_cstr(log->stats_path);
+    if (success) {
+        storage_common_remove(log->storage, path);
+        success = storage_common_rename(log->storage, tmp_path, path) == FSE_OK;
+    }
+    if (success) {
+        log->stats = *header;
+    } else {
+        storage_common_remove(log->storage, tmp_path);
+        FURI_LOG_E("MTG", "Failed to write play stats");
+    }
+    return success;
+}
+
+static bool play_stats_create(PlayLog* log, uint32_t last_sequence) {
+    PlayStatsHeader header = {
+        .magic = PLAY_STATS_MAGIC,
+        .version = PLAY_LOG_VERSION,
+        .header_size = sizeof(PlayStatsHeader),
+        .capacity = PLAY_STATS_MIN_CAPACITY,
+        .last_sequence = last_sequence,
+        .totals = {0},
+    };
+    return play_stats_commit(log, &header, play_stats_write_empty(log, &header));
+}
+
+// One block of the new table, written back when another block takes its place
+typedef struct {
+    PlayStats slots[PLAY_LOG_BLOCK_SIZE / sizeof(PlayStats)];
+    uint32_t first;
+    bool dirty;
+} PlayStatsWindow;
+
+static bool play_stats_window_flush(File* file, PlayStatsWindow* window) {
+    if (!window->dirty) return true;
+    window->dirty = false;
+    return storage_file_seek(file, sizeof(PlayStatsHeader) + (uint64_t)window->first * sizeof(PlayStats), true) &&
+           mtg_file_write(file, window->slots, sizeof(window->slots)) == sizeof(window->slots);
+}
+
+static bool play_stats_window_load(File* file, PlayStatsWindow* window, uint32_t first) {
+    if (!play_stats_window_flush(file, window)) return false;
+    window->first = first;
+    return storage_file_seek(file, sizeof(PlayStatsHeader) + (uint64_t)first * sizeof(PlayStats), true) &&
+           mtg_file_read(file, window->slots, sizeof(window->slots)) == sizeof(window->slots);
+}
+
+// Insert into the new table on the card. A deck from old slot i lands near
+// slot i in one half of the new table or the other, so with a window per half
+// the rehash reads and writes each block about once
+static bool play_stats_place(File* file, PlayStatsWindow windows[2], uint32_t capacity, const PlayStats* stats) {
+    const uint32_t window_slots = COUNT_OF(windows[0].slots);
+    uint32_t mask = capacity - 1;
+    uint32_t index = stats->deck & mask;
+    for (uint32_t probe = 0; probe < capacity; probe++) {
+        uint32_t first = index - index % window_slots;
+        PlayStatsWindow* window = &windows[first < capacity / 2 ? 0 : 1];
+        if (window->first != first && !play_stats_window_load(file, window, first)) return false;
+        PlayStats* slot = &window->slots[index - first];
+        if (slot->deck == 0) {
+            *slot = *stats;
+            window->dirty = true;
+            return true;
+        }
+        index = (index + 1) & mask;
+    }
+    return false;
+}
+
+// Double the table, rehashing every deck into the new one a block at a time
+static bool play_stats_grow(PlayLog* log) {
+    PlayStatsHeader header = log->stats;
+    header.header_size = sizeof(PlayStatsHeader);
+    header.capacity *= 2;
+    furi_assert(header.capacity % (2 * (PLAY_LOG_BLOCK_SIZE / sizeof(PlayStats))) == 0);
+    bool success = play_stats_write_empty(log, &header);
+
+    File* file = storage_file_alloc(log->storage);
+    File* tmp = storage_file_alloc(log->storage);
+    success = success &&
+              storage_file_open(file, furi_string_get_cstr(log->stats_path), FSAM_READ, FSOM_OPEN_EXISTING) &&
+              storage_file_seek(file, log->stats.header_size, true) &&
+              storage_file_open(tmp, furi_string_get_cstr(log->stats_tmp_path), FSAM_READ_WRITE, FSOM_OPEN_EXISTING);
+    PlayStatsWindow* windows = malloc(2 * sizeof(PlayStatsWindow));
+    for (size_t w = 0; w < 2; w++) {
+        windows[w].first = UINT32_MAX;
+        windows[w].dirty = false;
+    }
+    // Off the stack, which is small on the main thread
+    const size_t block_slots = PLAY_LOG_BLOCK_SIZE / sizeof(PlayStats);
+    PlayStats* block = malloc(PLAY_LOG_BLOCK_SIZE);
+    size_t remaining = log->stats.capacity;
+    while (success && remaining > 0) {
+        size_t count = MIN(remaining, block_slots);
+        size_t bytes = count * sizeof(PlayStats);
+        success = mtg_file_read(file, block, bytes) == bytes;
+        for (size_t i = 0; success && i < count; i++) {
+            if (block[i].deck == 0) continue;
+            success = play_stats_place(tmp, windows, header.capacity, &block[i]);
+        }
+        remaining -= count;
+    }
+    for (size_t w = 0; w < 2; w++) {
+        if (!play_stats_window_flush(tmp, &windows[w])) success = false;
+    }
+    free(block);
+    free(windows);
+    storage_file_close(tmp);
+    storage_file_free(tmp);
+    storage_file_close(file);
+    storage_file_free(file);
+
+    return play_stats_commit(log, &header, success);
+}
+
+// Fold records into the stats block; the caller holds it open for writing
+static bool play_stats_apply(PlayLog* log, File* file, const PlayRecord* record) {
+    PlayStats stats;
+    uint32_t slot;
+    if (!play_stats_find(log, file, record->deck, &stats, &slot)) {
+        if (slot == UINT32_MAX) return false;
+        memset(&stats, 0, sizeof(stats));
+        stats.deck = record->deck;
+        log->stats.totals.decks++;
+    }
+    play_stats_add(&stats, &log->stats.totals, record);
+    log->stats.last_sequence = record->sequence;
+    return storage_file_seek(file, play_stats_offset(log, slot), true) &&
+           mtg_file_write(file, &stats, sizeof(stats)) == sizeof(stats);
+}
+
+static bool play_stats_ensure_room(PlayLog* log) {
+    if (log->stats.magic != PLAY_STATS_MAGIC && !play_stats_create(log, log->next_sequence - 1)) {
+        return false;
+    }
+    uint64_t used = (uint64_t)(log->stats.totals.decks + 1) * PLAY_STATS_LOAD_DEN;
+    if (used > (uint64_t)log->stats.capacity * PLAY_STATS_LOAD_NUM) {
+        return play_stats_grow(log);
+    }
+    return true;
+}
+
+// Apply history records first..last that the stats block has not seen
+static void play_stats_catch_up(PlayLog* log, uint32_t first, uint32_t last) {
+    File* history = storage_file_alloc(log->storage);
+    File* file = storage_file_alloc(log->storage);
+    size_t applied = 0;
+    if (storage_file_open(history, furi_string_get_cstr(log->history_path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+        PlayRecord record;
+        for (uint32_t sequence = first; sequence <= last; sequence++) {
+            if (!play_log_read_record(history, log, sequence, &record)) continue;
+            // Growing reopens the table, so it happens between records
+            storage_file_close(file);
+            if (!play_stats_ensure_room(log)) break;
+            if (!storage_file_open(file, furi_string_get_cstr(log->stats_path), FSAM_READ_WRITE, FSOM_OPEN_EXISTING) ||
+               !play_stats_apply(log, file, &record)) {
+                break;
+            }
+            applied++;
+        }
+    }
+    log->stats.last_sequence = last;
+    if (!storage_file_is_open(file)) {
+        storage_file_open(file, furi_string_get_cstr(log->stats_path), FSAM_READ_WRITE, FSOM_OPEN_EXISTING);
+    }
+    play_stats_write_header(log, file);
+    storage_file_close(file);
+    storage_file_free(file);
+    storage_file_close(history);
+    storage_file_free(history);
+    FURI_LOG_I("MTG", "Applied %zu logged games to play stats", applied);
+}
+
+PlayLog* play_log_open(const char* history_path, const char* stats_path, uint32_t capacity) {
+    furi_assert(history_path);
+    furi_assert(stats_path);
+    furi_assert(capacity > 0);
+
+    PlayLog* log = malloc(sizeof(PlayLog));
+    log->storage = furi_record_open(RECORD_STORAGE);
+    log->history_path = furi_string_alloc_set(history_path);
+    log->stats_path = furi_string_alloc_set(stats_path);
+    log->stats_tmp_path = furi_string_alloc_printf("%s.tmp", stats_path);
+    log->history_capacity = capacity;
+    log->history_header_size = sizeof(PlayHistoryHeader);
+    memset(&log->stats, 0, sizeof(log->stats));
+
+    uint32_t newest = play_log_scan_history(log);
+
+    File* file = storage_file_alloc(log->storage);
+    PlayStatsHeader header;
+    if (storage_file_open(file, stats_path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+       mtg_file_read(file, &header, sizeof(header)) == sizeof(header) &&
+       header.magic == PLAY_STATS_MAGIC && header.version == PLAY_LOG_VERSION &&
+       header.header_size >= sizeof(header) && header.capacity >= PLAY_STATS_MIN_CAPACITY &&
+       (header.capacity & (header.capacity - 1)) == 0 &&
+       storage_file_size(file) >= header.header_size + (uint64_t)header.capacity * sizeof(PlayStats)) {
+        log->stats = header;
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+
+    // Records the block never saw: apply them if the ring still holds them all,
+    // otherwise start the block over from what it does hold
+    uint32_t seen = log->stats.magic == PLAY_STATS_MAGIC ? log->stats.last_sequence : 0;
+    if (newest > seen) {
+        uint32_t oldest = newest >= log->history_capacity ? newest - log->history_capacity + 1 : 1;
+        if (seen + 1 < oldest || log->stats.magic != PLAY_STATS_MAGIC) {
+            FURI_LOG_W("MTG", "Rebuilding play stats from history");
+            play_stats_create(log, oldest - 1);
+            seen = oldest - 1;
+        }
+        play_stats_catch_up(log, seen + 1, newest);
+    }
+
+    log->next_sequence = MAX(newest, log->stats.last_sequence) + 1;
+    return log;
+}
+
+void play_log_close(PlayLog* log) {
+    furi_assert(log);
+    furi_string_free(log->stats_tmp_path);
+    furi_string_free(log->stats_path);
+    furi_string_free(log->history_path);
+    furi_record_close(RECORD_STORAGE);
+    free(log);
+}
+
+static bool play_log_write_record(PlayLog* log, const PlayRecord* record) {
+    File* file = storage_file_alloc(log->storage);
+    bool success = false;
+    do {
+        if (!storage_file_open(file, furi_string_get_cstr(log->history_path), FSAM_READ_WRITE, FSOM_OPEN_ALWAYS)) break;
+        if (storage_file_size(file) < sizeof(PlayHistoryHeader)) {
+            // A new ring is laid out in full so unwritten slots read as empty
+            PlayHistoryHeader header = {
+                .magic = PLAY_HISTORY_MAGIC,
+                .version = PLAY_LOG_VERSION,
+                .header_size = sizeof(PlayHistoryHeader),
+                .capacity = log->history_capacity,
+                .reserved = 0,
+            };
+            if (mtg_file_write(file, &header, sizeof(header)) != sizeof(header)) break;
+            if (!play_log_write_zeros(file, log->history_capacity * sizeof(PlayRecord))) break;
+            log->history_header_size = header.header_size;
+        }
+        uint64_t offset = log->history_header_size +
+                          (uint64_t)(record->sequence % log->history_capacity) * sizeof(PlayRecord);
+        if (!storage_file_seek(file, offset, true)) break;
+        success = mtg_file_write(file, record, sizeof(PlayRecord)) == sizeof(PlayRecord);
+    } while (false);
+    storage_file_close(file);
+    storage_file_free(file);
+    return success;
+}
+
+bool play_log_append(PlayLog* log, uint32_t deck, uint32_t timestamp, PlayResult result) {
+    furi_assert(log);
+    furi_assert(deck != 0);
+
+    PlayRecord record = {
+        .sequence = log->next_sequence,
+        .deck = deck,
+        .timestamp = timestamp,
+        .result = result,
+        .reserved = {0},
+    };
+    if (!play_log_write_record(log, &record)) {
+        FURI_LOG_E("MTG", "Failed to append to play history");
+        return false;
+    }
+    log->next_sequence++;
+
+    // The record is safe; if the stats update fails it is applied on next open
+    if (!play_stats_ensure_room(log)) return true;
+    File* file = storage_file_alloc(log->storage);
+    if (storage_file_open(file, furi_string_get_cstr(log->stats_path), FSAM_READ_WRITE, FSOM_OPEN_EXISTING)) {
+        PlayStatsHeader previous = log->stats;
+        if (!play_stats_apply(log, file, &record) || !play_stats_write_header(log, file)) {
+            log->stats = previous;
+            FURI_LOG_E("MTG", "Failed to update play stats");
+        }
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    return true;
+}
+
+bool play_log_get(PlayLog* log, uint32_t deck, PlayStats* stats) {
+    furi_assert(log);
+    furi_assert(stats);
+
+    bool found = false;
+    if (log->stats.magic == PLAY_STATS_MAGIC) {
+        File* file = storage_file_alloc(log->storage);
+        uint32_t slot;
+        if (storage_file_open(file, furi_string_get_cstr(log->stats_path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+            found = play_stats_find(log, file, deck, stats, &slot);
+        }
+        storage_file_close(file);
+        storage_file_free(file);
+    }
+    if (!found) {
+        memset(stats, 0, sizeof(PlayStats));
+        stats->deck = deck;
+    }
+    return found;
+}
+
+const PlayTotals* play_log_totals(const PlayLog* log) {
+    furi_assert(log);
+    return &log->stats.totals;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <furi.h>
+
+/* Play history and per-deck statistics
+ *
+ * Every pick and every reported result is appended to a fixed-size ring of
+ * records (mtg_history.bin): once it is full the oldest game is overwritten,
+ * so an append is one record write however long the app has been in use.
+ *
+ * Appends also update a stats block (mtg_stats.bin) in place: an open
+ * addressing table of PlayStats keyed by deck id, plus running totals. Reading
+ * a deck's numbers is a lookup in that table, never a scan of the history.
+ * The block remembers the last history record it has seen; on open, records
+ * it missed are applied from the ring, and a missing or damaged block is
+ * rebuilt from whatever the ring still holds.
+ *
+ * Decks are identified by a hash of their name, so statistics survive list
+ * edits and reordering but not a rename.
+ */
+
+typedef enum {
+    PlayResultPicked,
+    PlayResultWon,
+    PlayResultLost,
+} PlayResult;
+
+typedef struct {
+    uint32_t deck;
+    uint16_t plays;
+    uint16_t wins;
+    uint16_t losses;
+    uint16_t reserved;
+    uint32_t last_played;
+} PlayStats;
+
+typedef struct {
+    uint32_t games;
+    uint32_t wins;
+    uint32_t losses;
+    uint32_t decks;
+} PlayTotals;
+
+typedef struct PlayLog PlayLog;
+
+/** Open the history and stats files, creating them on the first append
+ *
+ * @param capacity  records kept by a new history ring; an existing ring keeps its own
+ */
+PlayLog* play_log_open(const char* history_path, const char* stats_path, uint32_t capacity);
+
+void play_log_close(PlayLog* log);
+
+/** Stable deck id for a deck name */
+uint32_t play_log_deck_id(const char* name, size_t length);
+
+/** Record a game and fold it into the stats block */
+bool play_log_append(PlayLog* log, uint32_t deck, uint32_t timestamp, PlayResult result);
+
+/** Look up a deck's statistics
+ *
+ * @return false if the deck has no games yet; stats is zeroed
+ */
+bool play_log_get(PlayLog* log, uint32_t deck, PlayStats* stats);
+
+const PlayTotals* play_log_totals(const PlayLog* log);
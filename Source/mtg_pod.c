@@ -0,0 +1,96 @@
+#include "mtg_pod.h"
+#include "mtg_deck_picker.h"
+
+// Floyd's sampling: seats distinct match ranks below count, then dealt to the
+// seats in random order since the sampling favours late ranks in late slots
+static void pod_draw(const DeckFilter* filter, size_t count, uint8_t seats, uint32_t decks[POD_SEATS_MAX]) {
+    uint32_t ranks[POD_SEATS_MAX];
+    size_t drawn = 0;
+    for (size_t limit = count - seats; limit < count; limit++) {
+        uint32_t rank = deck_picker_random_below(limit + 1);
+        for (size_t i = 0; i < drawn; i++) {
+            if (ranks[i] == rank) {
+                rank = limit;
+                break;
+            }
+        }
+        ranks[drawn++] = rank;
+    }
+
+    for (size_t i = seats - 1; i > 0; i--) {
+        uint32_t j = deck_picker_random_below(i + 1);
+        uint32_t swap = ranks[i];
+        ranks[i] = ranks[j];
+        ranks[j] = swap;
+    }
+
+    for (size_t i = 0; i < seats; i++) {
+        decks[i] = deck_filter_select(filter, ranks[i]);
+    }
+}
+
+static PodResult pod_assign_balanced(
+    DeckFilter* filter,
+    const DeckFilterRule* rule,
+    const PodRule* pod,
+    uint32_t decks[POD_SEATS_MAX],
+    size_t* available) {
+    uint32_t counts[DECK_META_BRACKET_MAX + 1];
+    deck_filter_bracket_counts(filter, counts);
+
+    // Windows [low, low + spread], clipped at the top bracket
+    uint8_t last = DECK_META_BRACKET_MAX > pod->spread ? DECK_META_BRACKET_MAX - pod->spread : 1;
+    uint32_t sizes[DECK_META_BRACKET_MAX + 1] = {0};
+    uint32_t total = 0;
+    uint32_t best = 0;
+    for (uint8_t low = 1; low <= last; low++) {
+        for (uint8_t bracket = low; bracket <= MIN(low + pod->spread, DECK_META_BRACKET_MAX); bracket++) {
+            sizes[low] += counts[bracket];
+        }
+        best = MAX(best, sizes[low]);
+        if (sizes[low] >= pod->seats) total += sizes[low];
+    }
+    if (total == 0) {
+        *available = best;
+        return PodResultUnbalanced;
+    }
+
+    uint32_t pick = deck_picker_random_below(total);
+    uint8_t low = 1;
+    for (;; low++) {
+        if (sizes[low] < pod->seats) continue;
+        if (pick < sizes[low]) break;
+        pick -= sizes[low];
+    }
+
+    DeckFilterRule window = *rule;
+    window.bracket_min = MAX(low, rule->bracket_min);
+    window.bracket_max = MIN(low + pod->spread, DECK_META_BRACKET_MAX);
+    if (rule->bracket_max) window.bracket_max = MIN(window.bracket_max, rule->bracket_max);
+    size_t count = deck_filter_apply(filter, &window);
+    furi_check(count == sizes[low]);
+    pod_draw(filter, count, pod->seats, decks);
+    deck_filter_apply(filter, rule);
+    return PodResultOk;
+}
+
+PodResult pod_assign(
+    DeckFilter* filter,
+    const DeckFilterRule* rule,
+    const PodRule* pod,
+    uint32_t decks[POD_SEATS_MAX],
+    size_t* available) {
+    furi_assert(filter);
+    furi_assert(rule);
+    furi_assert(pod);
+    furi_assert(pod->seats >= POD_SEATS_MIN && pod->seats <= POD_SEATS_MAX);
+    furi_assert(available);
+
+    size_t count = deck_filter_count(filter);
+    *available = count;
+    if (count < pod->seats) return PodResultTooFewDecks;
+    if (pod->spread >= 0) return pod_assign_balanced(filter, rule, pod, decks, available);
+
+    pod_draw(filter, count, pod->seats, decks);
+    return PodResultOk;
+}
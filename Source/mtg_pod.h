@@ -0,0 +1,53 @@
+#pragma once
+
+#include <furi.h>
+
+#include "mtg_deck_filter.h"
+
+/* Pod assignment: one distinct deck per seat, drawn in a single pass
+ *
+ * Decks are drawn uniformly from the filter's matches by Floyd's sampling, so
+ * a pod costs one random draw and one select per seat whatever the list size
+ * and however many decks are left out.
+ *
+ * A balanced pod keeps the brackets of its decks within a given spread. The
+ * matches are counted per bracket, each run of brackets no wider than the
+ * spread holding at least one deck per seat is a candidate window, and one
+ * window is chosen in proportion to the decks it holds before drawing from
+ * it. That is a fixed amount of work, and when no window is large enough the
+ * pod is refused rather than retried. Decks without a bracket never go into a
+ * balanced pod.
+ */
+
+#define POD_SEATS_MIN 2
+#define POD_SEATS_MAX 6
+// Widest bracket spread offered for balancing
+#define POD_SPREAD_MAX 3
+
+typedef enum {
+    PodResultOk,
+    // Fewer matching decks than seats
+    PodResultTooFewDecks,
+    // No bracket window holds a deck for every seat
+    PodResultUnbalanced,
+} PodResult;
+
+typedef struct {
+    uint8_t seats;
+    // Largest bracket difference within the pod, -1 to ignore brackets
+    int8_t spread;
+} PodRule;
+
+/** Draw a deck for every seat among the decks rule lets through
+ *
+ * The filter must hold the current matches for rule, and does again on return.
+ *
+ * @param decks      deck positions, one per seat
+ * @param available  on failure, the most decks any pod could have drawn from
+ */
+PodResult pod_assign(
+    DeckFilter* filter,
+    const DeckFilterRule* rule,
+    const PodRule* pod,
+    uint32_t decks[POD_SEATS_MAX],
+    size_t* available);
@@ -0,0 +1,58 @@
+#include "mtg_storage_helpers.h"
+
+struct BlockWriter {
+    File* file;
+    uint8_t* block;
+    size_t block_size;
+    size_t fill;
+    bool ok;
+};
+
+bool file_stamp_get(Storage* storage, const char* path, FileStamp* stamp) {
+    FileInfo info;
+    if (storage_common_stat(storage, path, &info) != FSE_OK) return false;
+    if (storage_common_timestamp(storage, path, &stamp->mtime) != FSE_OK) return false;
+    stamp->size = (uint32_t)info.size;
+    return true;
+}
+
+BlockWriter* block_writer_alloc(File* file, size_t block_size) {
+    furi_assert(file);
+    furi_assert(block_size > 0);
+
+    BlockWriter* writer = malloc(sizeof(BlockWriter));
+    writer->file = file;
+    writer->block = malloc(block_size);
+    writer->block_size = block_size;
+    writer->fill = 0;
+    writer->ok = true;
+    return writer;
+}
+
+void block_writer_free(BlockWriter* writer) {
+    furi_assert(writer);
+    free(writer->block);
+    free(writer);
+}
+
+void block_writer_put(BlockWriter* writer, const void* data, size_t size) {
+    furi_assert(writer);
+    const uint8_t* bytes = data;
+    while (size > 0) {
+        size_t chunk = MIN(size, writer->block_size - writer->fill);
+        memcpy(writer->block + writer->fill, bytes, chunk);
+        writer->fill += chunk;
+        bytes += chunk;
+        size -= chunk;
+        if (writer->fill == writer->block_size) block_writer_flush(writer);
+    }
+}
+
+bool block_writer_flush(BlockWriter* writer) {
+    furi_assert(writer);
+    if (writer->fill > 0 && mtg_file_write(writer->file, writer->block, writer->fill) != writer->fill) {
+        writer->ok = false;
+    }
+    writer->fill = 0;
+    return writer->ok;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <furi.h>
+#include <storage/storage.h>
+
+#include "mtg_perf.h"
+
+#define MTG_CHECKSUM_SEED 2166136261U
+
+/** FNV-1a over a byte range, chainable by passing the previous result as hash */
+static inline uint32_t mtg_checksum(uint32_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    return hash;
+}
+
+/** storage_file_read, counted for the diagnostics overlay */
+static inline size_t mtg_file_read(File* file, void* buffer, size_t size) {
+    size_t read = storage_file_read(file, buffer, size);
+    perf_count_read(read);
+    return read;
+}
+
+/** storage_file_write, counted for the diagnostics overlay */
+static inline size_t mtg_file_write(File* file, const void* buffer, size_t size) {
+    size_t written = storage_file_write(file, buffer, size);
+    perf_count_write(written);
+    return written;
+}
+
+/** Size and modification time, used to tell whether a derived file is stale */
+typedef struct {
+    uint32_t size;
+    uint32_t mtime;
+} FileStamp;
+
+bool file_stamp_get(Storage* storage, const char* path, FileStamp* stamp);
+
+/** Coalesces small writes into block-sized storage_file_write calls */
+typedef struct BlockWriter BlockWriter;
+
+BlockWriter* block_writer_alloc(File* file, size_t block_size);
+
+void block_writer_free(BlockWriter* writer);
+
+void block_writer_put(BlockWriter* writer, const void* data, size_t size);
+
+/** Write out anything buffered
+ *
+ * @return false if any write since allocation came up short
+ */
+bool block_writer_flush(BlockWriter* writer);
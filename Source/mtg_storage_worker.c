@@ -0,0 +1,211 @@
+#include "mtg_storage_worker.h"
+#include "mtg_perf.h"
+
+#define STORAGE_WORKER_STACK_SIZE 2048
+
+typedef enum {
+    StorageWorkerFlagWake = (1 << 0),
+    StorageWorkerFlagStop = (1 << 1),
+} StorageWorkerFlag;
+
+// Raised on the thread waiting in storage_worker_flush, clear of the low bits
+// an app is likely to use for its own thread flags
+#define STORAGE_WORKER_FLAG_FLUSHED (1 << 16)
+
+typedef struct {
+    uint16_t position;
+    uint8_t op;
+    uint8_t length;
+    char name[STORAGE_WORKER_NAME_SIZE];
+} StorageWorkerAppend;
+
+struct StorageWorker {
+    FuriThread* thread;
+    FuriMutex* mutex;
+    DeckJournal* journal;
+    StorageWorkerSaveCallback save;
+    StorageWorkerCallback callback;
+    void* context;
+
+    // Guarded by mutex
+    DeckStore* pending_save;
+    StorageWorkerAppend appends[STORAGE_WORKER_QUEUE_SIZE];
+    size_t append_head;
+    size_t append_count;
+    bool busy;
+    FuriThreadId flush_waiter;
+    uint32_t events;
+    size_t journal_size;
+};
+
+static void storage_worker_lock(StorageWorker* worker) {
+    furi_check(furi_mutex_acquire(worker->mutex, FuriWaitForever) == FuriStatusOk);
+}
+
+static void storage_worker_unlock(StorageWorker* worker) {
+    furi_mutex_release(worker->mutex);
+}
+
+static int32_t storage_worker_thread(void* context) {
+    StorageWorker* worker = context;
+    bool running = true;
+
+    while (true) {
+        // A pending save always runs first: anything queued before it was dropped
+        storage_worker_lock(worker);
+        DeckStore* decks = worker->pending_save;
+        worker->pending_save = NULL;
+        StorageWorkerAppend append;
+        bool appending = false;
+        if (!decks && worker->append_count > 0) {
+            append = worker->appends[worker->append_head];
+            worker->append_head = (worker->append_head + 1) % STORAGE_WORKER_QUEUE_SIZE;
+            worker->append_count--;
+            appending = true;
+        }
+        worker->busy = decks || appending;
+        if (!worker->busy && worker->flush_waiter) {
+            furi_thread_flags_set(worker->flush_waiter, STORAGE_WORKER_FLAG_FLUSHED);
+            worker->flush_waiter = NULL;
+        }
+        storage_worker_unlock(worker);
+
+        if (!decks && !appending) {
+            if (!running) break;
+            uint32_t flags = furi_thread_flags_wait(
+                StorageWorkerFlagWake | StorageWorkerFlagStop, FuriFlagWaitAny, FuriWaitForever);
+            if (flags & StorageWorkerFlagStop) running = false;
+            continue;
+        }
+
+        uint32_t event;
+        if (decks) {
+            event = worker->save(worker->context, decks) ? StorageWorkerEventSaved :
+                                                           StorageWorkerEventSaveFailed;
+            deck_store_free(decks);
+        } else {
+            event = deck_journal_append(
+                        worker->journal, append.op, append.position, append.name, append.length) ?
+                        StorageWorkerEventAppended :
+                        StorageWorkerEventAppendFailed;
+        }
+
+        perf_note_stack(PerfThreadWorker);
+        storage_worker_lock(worker);
+        worker->events |= event;
+        worker->journal_size = deck_journal_size(worker->journal);
+        storage_worker_unlock(worker);
+
+        if (worker->callback) worker->callback(worker->context);
+    }
+
+    return 0;
+}
+
+StorageWorker* storage_worker_alloc(
+    DeckJournal* journal,
+    StorageWorkerSaveCallback save,
+    StorageWorkerCallback callback,
+    void* context) {
+    furi_assert(journal);
+    furi_assert(save);
+
+    StorageWorker* worker = malloc(sizeof(StorageWorker));
+    worker->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    worker->journal = journal;
+    worker->save = save;
+    worker->callback = callback;
+    worker->context = context;
+    worker->pending_save = NULL;
+    worker->append_head = 0;
+    worker->append_count = 0;
+    worker->busy = false;
+    worker->flush_waiter = NULL;
+    worker->events = 0;
+    worker->journal_size = 0;
+
+    worker->thread = furi_thread_alloc_ex(
+        "MtgStorageWorker", STORAGE_WORKER_STACK_SIZE, storage_worker_thread, worker);
+    furi_thread_start(worker->thread);
+    return worker;
+}
+
+void storage_worker_free(StorageWorker* worker) {
+    furi_assert(worker);
+
+    // The thread drains whatever is queued before it honours the stop
+    furi_thread_flags_set(furi_thread_get_id(worker->thread), StorageWorkerFlagStop);
+    furi_thread_join(worker->thread);
+    furi_thread_free(worker->thread);
+
+    furi_mutex_free(worker->mutex);
+    free(worker);
+}
+
+bool storage_worker_append(
+    StorageWorker* worker,
+    DeckJournalOp op,
+    size_t position,
+    const char* name,
+    size_t length) {
+    furi_assert(worker);
+    furi_assert(position <= UINT16_MAX);
+    furi_assert(length < STORAGE_WORKER_NAME_SIZE);
+
+    storage_worker_lock(worker);
+    bool queued = worker->append_count < STORAGE_WORKER_QUEUE_SIZE;
+    if (queued) {
+        size_t tail = (worker->append_head + worker->append_count) % STORAGE_WORKER_QUEUE_SIZE;
+        StorageWorkerAppend* append = &worker->appends[tail];
+        append->position = position;
+        append->op = op;
+        append->length = length;
+        if (length > 0) memcpy(append->name, name, length);
+        worker->append_count++;
+    }
+    storage_worker_unlock(worker);
+
+    if (queued) {
+        furi_thread_flags_set(furi_thread_get_id(worker->thread), StorageWorkerFlagWake);
+    }
+    return queued;
+}
+
+void storage_worker_save(StorageWorker* worker, DeckStore* decks) {
+    furi_assert(worker);
+    furi_assert(decks);
+
+    // Last write wins: the snapshot already holds every edit still queued
+    storage_worker_lock(worker);
+    DeckStore* superseded = worker->pending_save;
+    worker->pending_save = decks;
+    worker->append_count = 0;
+    storage_worker_unlock(worker);
+
+    if (superseded) deck_store_free(superseded);
+    furi_thread_flags_set(furi_thread_get_id(worker->thread), StorageWorkerFlagWake);
+}
+
+void storage_worker_flush(StorageWorker* worker) {
+    furi_assert(worker);
+
+    storage_worker_lock(worker);
+    bool idle = !worker->busy && !worker->pending_save && worker->append_count == 0;
+    if (!idle) worker->flush_waiter = furi_thread_get_current_id();
+    storage_worker_unlock(worker);
+
+    if (!idle) {
+        furi_thread_flags_wait(STORAGE_WORKER_FLAG_FLUSHED, FuriFlagWaitAny, FuriWaitForever);
+    }
+}
+
+uint32_t storage_worker_take_events(StorageWorker* worker, size_t* journal_size) {
+    furi_assert(worker);
+
+    storage_worker_lock(worker);
+    uint32_t events = worker->events;
+    worker->events = 0;
+    if (journal_size) *journal_size = worker->journal_size;
+    storage_worker_unlock(worker);
+    return events;
+}
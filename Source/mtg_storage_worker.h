@@ -0,0 +1,75 @@
+#pragma once
+
+#include <furi.h>
+
+#include "mtg_deck_store.h"
+#include "mtg_deck_journal.h"
+
+/* Write-behind thread for deck list storage
+ *
+ * The UI thread hands over journal appends and full saves and carries on; the
+ * worker performs them in order on its own thread. A save carries a snapshot
+ * of the whole list, so it supersedes everything queued before it: submitting
+ * one drops pending appends and any older snapshot that has not started yet.
+ *
+ * Outcomes are accumulated as StorageWorkerEvent bits and the callback is
+ * invoked after every finished job; the UI collects them with
+ * storage_worker_take_events on its own thread.
+ */
+
+// Appends waiting beyond this are folded into a save by the caller
+#define STORAGE_WORKER_QUEUE_SIZE 8
+// Longest name an append can carry, terminator included
+#define STORAGE_WORKER_NAME_SIZE 64
+
+typedef enum {
+    StorageWorkerEventSaved = (1 << 0),
+    StorageWorkerEventAppended = (1 << 1),
+    StorageWorkerEventSaveFailed = (1 << 2),
+    StorageWorkerEventAppendFailed = (1 << 3),
+} StorageWorkerEvent;
+
+/** Write a complete list; runs on the worker thread */
+typedef bool (*StorageWorkerSaveCallback)(void* context, const DeckStore* decks);
+
+/** A job finished; runs on the worker thread and must not block */
+typedef void (*StorageWorkerCallback)(void* context);
+
+typedef struct StorageWorker StorageWorker;
+
+/** Start the worker thread
+ *
+ * The journal is only touched by the worker from here on, except while the
+ * worker is idle after storage_worker_flush.
+ */
+StorageWorker* storage_worker_alloc(
+    DeckJournal* journal,
+    StorageWorkerSaveCallback save,
+    StorageWorkerCallback callback,
+    void* context);
+
+/** Finish all queued work and stop the thread */
+void storage_worker_free(StorageWorker* worker);
+
+/** Queue a journal append
+ *
+ * @return false if the queue is full; submit a save instead
+ */
+bool storage_worker_append(
+    StorageWorker* worker,
+    DeckJournalOp op,
+    size_t position,
+    const char* name,
+    size_t length);
+
+/** Queue a save of decks, taking ownership of the snapshot */
+void storage_worker_save(StorageWorker* worker, DeckStore* decks);
+
+/** Block until every queued job has finished */
+void storage_worker_flush(StorageWorker* worker);
+
+/** Collect and clear the StorageWorkerEvent bits raised since the last call
+ *
+ * @param journal_size set to the journal size after the latest finished job
+ */
+uint32_t storage_worker_take_events(StorageWorker* worker, size_t* journal_size);
@@ -0,0 +1,188 @@
+#include "mtg_trace.h"
+#include "mtg_storage_helpers.h"
+
+// Records held for the main loop; it writes them out TRACE_BLOCK_RECORDS at a time
+#define TRACE_BUFFER_RECORDS 128
+#define TRACE_BLOCK_RECORDS  64
+
+struct TraceRecorder {
+    Storage* storage;
+    File* file;
+    TraceHeader header;
+    bool failed;
+
+    // Written under FURI_CRITICAL_ENTER only
+    TraceRecord records[TRACE_BUFFER_RECORDS];
+    size_t count;
+    uint32_t last_tick;
+    uint32_t dropped;
+};
+
+struct TraceReader {
+    Storage* storage;
+    File* file;
+    TraceRecord records[TRACE_BLOCK_RECORDS];
+    size_t count;
+    size_t next;
+    uint32_t remaining;
+};
+
+TraceRecorder* trace_recorder_open(const char* path, uint32_t seed, uint32_t timestamp, uint32_t deck_count) {
+    furi_assert(path);
+
+    TraceRecorder* recorder = malloc(sizeof(TraceRecorder));
+    memset(recorder, 0, sizeof(TraceRecorder));
+    recorder->storage = furi_record_open(RECORD_STORAGE);
+    recorder->file = storage_file_alloc(recorder->storage);
+    recorder->header.magic = TRACE_MAGIC;
+    recorder->header.version = TRACE_VERSION;
+    recorder->header.header_size = sizeof(TraceHeader);
+    recorder->header.seed = seed;
+    recorder->header.timestamp = timestamp;
+    recorder->header.deck_count = deck_count;
+    recorder->header.checksum = MTG_CHECKSUM_SEED;
+    recorder->last_tick = furi_get_tick();
+
+    // The header is written now to hold its place and again on close
+    if (!storage_file_open(recorder->file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS) ||
+       mtg_file_write(recorder->file, &recorder->header, sizeof(TraceHeader)) != sizeof(TraceHeader)) {
+        FURI_LOG_E("MTG", "Failed to start trace %s", path);
+        storage_file_close(recorder->file);
+        storage_file_free(recorder->file);
+        furi_record_close(RECORD_STORAGE);
+        free(recorder);
+        return NULL;
+    }
+    return recorder;
+}
+
+void trace_recorder_event(TraceRecorder* recorder, const InputEvent* event) {
+    furi_assert(recorder);
+    furi_assert(event);
+
+    uint32_t now = furi_get_tick();
+    FURI_CRITICAL_ENTER();
+    if (recorder->count < TRACE_BUFFER_RECORDS) {
+        TraceRecord* record = &recorder->records[recorder->count++];
+        record->delta = MIN(now - recorder->last_tick, (uint32_t)UINT16_MAX);
+        record->key = event->key;
+        record->type = event->type;
+        recorder->last_tick = now;
+    } else {
+        recorder->dropped++;
+    }
+    FURI_CRITICAL_EXIT();
+}
+
+// Records below the count taken here are only ever appended past, so they can
+// be written without holding up the input thread
+static void trace_recorder_drain(TraceRecorder* recorder, size_t minimum) {
+    FURI_CRITICAL_ENTER();
+    size_t count = recorder->count;
+    FURI_CRITICAL_EXIT();
+    if (count == 0 || count < minimum) return;
+
+    size_t size = count * sizeof(TraceRecord);
+    if (mtg_file_write(recorder->file, recorder->records, size) != size) recorder->failed = true;
+    recorder->header.checksum = mtg_checksum(recorder->header.checksum, recorder->records, size);
+    recorder->header.count += count;
+
+    FURI_CRITICAL_ENTER();
+    recorder->count -= count;
+    memmove(recorder->records, &recorder->records[count], recorder->count * sizeof(TraceRecord));
+    FURI_CRITICAL_EXIT();
+}
+
+void trace_recorder_write(TraceRecorder* recorder) {
+    furi_assert(recorder);
+    trace_recorder_drain(recorder, TRACE_BLOCK_RECORDS);
+}
+
+bool trace_recorder_close(TraceRecorder* recorder) {
+    furi_assert(recorder);
+
+    trace_recorder_drain(recorder, 1);
+    recorder->header.dropped = recorder->dropped;
+    if (recorder->dropped) {
+        FURI_LOG_W("MTG", "Trace lost %lu events", (unsigned long)recorder->dropped);
+    }
+    if (!storage_file_seek(recorder->file, 0, true) ||
+       mtg_file_write(recorder->file, &recorder->header, sizeof(TraceHeader)) != sizeof(TraceHeader)) {
+        recorder->failed = true;
+    }
+    bool success = !recorder->failed;
+    if (!success) FURI_LOG_E("MTG", "Failed to write trace");
+
+    storage_file_close(recorder->file);
+    storage_file_free(recorder->file);
+    furi_record_close(RECORD_STORAGE);
+    free(recorder);
+    return success;
+}
+
+static bool trace_reader_fill(TraceReader* reader) {
+    size_t count = MIN(reader->remaining, (uint32_t)TRACE_BLOCK_RECORDS);
+    size_t size = count * sizeof(TraceRecord);
+    if (count == 0 || mtg_file_read(reader->file, reader->records, size) != size) return false;
+    reader->count = count;
+    reader->next = 0;
+    reader->remaining -= count;
+    return true;
+}
+
+// Read the records through once for the checksum, then rewind to the first
+static bool trace_reader_check(TraceReader* reader, const TraceHeader* header) {
+    uint32_t checksum = MTG_CHECKSUM_SEED;
+    reader->remaining = header->count;
+    while (reader->remaining > 0) {
+        if (!trace_reader_fill(reader)) return false;
+        checksum = mtg_checksum(checksum, reader->records, reader->count * sizeof(TraceRecord));
+    }
+    reader->remaining = header->count;
+    reader->count = 0;
+    reader->next = 0;
+    return checksum == header->checksum && storage_file_seek(reader->file, header->header_size, true);
+}
+
+TraceReader* trace_reader_open(const char* path, TraceHeader* header) {
+    furi_assert(path);
+    furi_assert(header);
+
+    TraceReader* reader = malloc(sizeof(TraceReader));
+    reader->storage = furi_record_open(RECORD_STORAGE);
+    reader->file = storage_file_alloc(reader->storage);
+    reader->count = 0;
+    reader->next = 0;
+    reader->remaining = 0;
+
+    bool valid = false;
+    if (storage_file_open(reader->file, path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+       mtg_file_read(reader->file, header, sizeof(TraceHeader)) == sizeof(TraceHeader)) {
+        valid = header->magic == TRACE_MAGIC && header->version == TRACE_VERSION &&
+                header->header_size >= sizeof(TraceHeader) &&
+                storage_file_seek(reader->file, header->header_size, true) && trace_reader_check(reader, header);
+    }
+    if (!valid) {
+        FURI_LOG_E("MTG", "Trace %s is missing or damaged", path);
+        trace_reader_close(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+bool trace_reader_next(TraceReader* reader, TraceRecord* record) {
+    furi_assert(reader);
+    furi_assert(record);
+
+    if (reader->next == reader->count && !trace_reader_fill(reader)) return false;
+    *record = reader->records[reader->next++];
+    return true;
+}
+
+void trace_reader_close(TraceReader* reader) {
+    furi_assert(reader);
+    storage_file_close(reader->file);
+    storage_file_free(reader->file);
+    furi_record_close(RECORD_STORAGE);
+    free(reader);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <furi.h>
+#include <input/input.h>
+
+/* Input traces, for replaying a session against the state machine
+ *
+ *   header   TraceHeader: the RNG seed and wall clock the session ran with,
+ *            the deck count it started from, and the record count and
+ *            checksum, filled in when the trace is closed
+ *   records  TraceRecord, four bytes per input event
+ *
+ * Each record holds the milliseconds since the previous event, or since the
+ * trace was opened for the first one. Longer gaps than a record can hold are
+ * cut to UINT16_MAX, well past anything the app times.
+ *
+ * The recorder is fed from the input thread and only ever appends to a RAM
+ * buffer there; the main loop writes the buffer out a block at a time. Events
+ * that arrive with the buffer full are counted in the header, and a trace
+ * that lost any is still replayable but no longer the session it came from.
+ */
+
+#define TRACE_MAGIC   0x5254474DU // "MGTR"
+#define TRACE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t seed;
+    // Unix time when recording started
+    uint32_t timestamp;
+    uint32_t deck_count;
+    uint32_t count;
+    uint32_t dropped;
+    uint32_t checksum;
+} __attribute__((packed)) TraceHeader;
+
+typedef struct {
+    uint16_t delta;
+    uint8_t key;
+    uint8_t type;
+} TraceRecord;
+
+typedef struct TraceRecorder TraceRecorder;
+
+/** Start a trace at path, replacing any there; NULL if it cannot be created */
+TraceRecorder* trace_recorder_open(const char* path, uint32_t seed, uint32_t timestamp, uint32_t deck_count);
+
+/** Note an event; safe from the input thread and never waits */
+void trace_recorder_event(TraceRecorder* recorder, const InputEvent* event);
+
+/** Write out the buffered events once a block's worth has queued, on the main loop */
+void trace_recorder_write(TraceRecorder* recorder);
+
+/** Write out everything left and finish the header
+ *
+ * @return false if any part of the trace failed to write
+ */
+bool trace_recorder_close(TraceRecorder* recorder);
+
+typedef struct TraceReader TraceReader;
+
+/** Open a trace and check it end to end; NULL if it is missing or damaged */
+TraceReader* trace_reader_open(const char* path, TraceHeader* header);
+
+/** @return false after the last record */
+bool trace_reader_next(TraceReader* reader, TraceRecord* record);
+
+void trace_reader_close(TraceReader* reader);